@@ -36,38 +36,98 @@
 
 #define BOOT_PAGE_START 0
 #define BOOT_PAGE_NR 30
+#define BOOT_PAGE_WORDS (EMBEDDED_FLASH_BLOCK_SIZE / 4)
+#define BOOT_PAGE_RETRIES 3
+
+#define PAGE_ADDR(page) \
+	((uint32_t *)((page) * EMBEDDED_FLASH_BLOCK_SIZE + BASE_FLASH_ADDR))
 
 void soc_reboot(void)
 {
 	SCSS_REG_VAL(SCSS_RSTC) = RSTC_WARM_RESET;
 }
 
+static int page_equals(const uint32_t *dst, const uint32_t *src)
+{
+	int i;
 
-void main(void)
+	for (i = 0; i < BOOT_PAGE_WORDS; i++) {
+		if (dst[i] != src[i])
+			return 0;
+	}
+	return 1;
+}
+
+static int page_is_erased(const uint32_t *page)
 {
+	int i;
+
+	for (i = 0; i < BOOT_PAGE_WORDS; i++) {
+		if (page[i] != 0xFFFFFFFF)
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * Update one page of the bootloader partition, if needed.
+ *
+ * The page is only erased and programmed if its content differs from the new
+ * image, and it is read back afterwards. As the staging area is never
+ * modified, an update interrupted by a power loss can simply be restarted:
+ * the pages already updated are skipped and the update resumes on the first
+ * page that differs, including a partially programmed one.
+ *
+ * @return 0 if the page was already up to date, 1 if it was updated,
+ *         -1 in case of error.
+ */
+static int update_page(uint32_t dst_page, uint32_t src_page)
+{
+	uint32_t *dst = PAGE_ADDR(dst_page);
+	uint32_t *src = PAGE_ADDR(src_page);
 	unsigned int retlen;
+	int retry;
+
+	if (page_equals(dst, src))
+		return 0;
+
+	for (retry = 0; retry < BOOT_PAGE_RETRIES; retry++) {
+		if (!page_is_erased(dst) &&
+		    soc_flash_block_erase(dst_page, 1))
+			continue;
+		if (soc_flash_write(dst_page * EMBEDDED_FLASH_BLOCK_SIZE,
+				    BOOT_PAGE_WORDS, &retlen, src))
+			continue;
+		if (page_equals(dst, src))
+			return 1;
+	}
+	return -1;
+}
+
+void main(void)
+{
 	uint32_t data_new_bl = ARC_START_PAGE;
 	int count = 0;
+	int updated = 0;
+	int ret;
 
 	soc_init();
 	uart_init(1, COM2_BASE_ADRS, 115200);
 	uart_puts("UART app updater\r\n");
 	uart_puts("Copying image on Bootloader Partition\r\n");
 
-	soc_flash_block_erase(BOOT_PAGE_START, BOOT_PAGE_NR);
-
-	/* Perform actual copy using soc_flash driver */
-	for (count = BOOT_PAGE_START; count < BOOT_PAGE_NR; count++) {
-		soc_flash_write(
-			(BOOT_PAGE_START + count) * EMBEDDED_FLASH_BLOCK_SIZE,
-			EMBEDDED_FLASH_BLOCK_SIZE / 4,
-			&retlen,
-			(uint32_t *)((data_new_bl +
-				      count) * EMBEDDED_FLASH_BLOCK_SIZE +
-				     BASE_FLASH_ADDR));
-		uart_puts(".");
+	/* Only the pages that differ are erased and programmed */
+	for (count = 0; count < BOOT_PAGE_NR; count++) {
+		ret = update_page(BOOT_PAGE_START + count, data_new_bl + count);
+		if (ret < 0) {
+			uart_puts("\r\nCopy failed\r\n");
+			/* Do not reboot on a corrupted bootloader */
+			while (1) ;
+		}
+		updated += ret;
+		uart_puts(ret ? "." : "=");
 	}
-	uart_puts("Copy Done. \r\n");
+	uart_puts(updated ? "Copy Done. \r\n" : "Already up to date. \r\n");
 	uart_puts("Rebooting... \r\n");
 	set_boot_target(TARGET_FLASHING);
 	soc_reboot();
@@ -110,6 +110,7 @@ struct sensor_sba_info {
 	BLOCK_TYPE block_type;
 	SENSOR_BUS_TYPE bus_type;
 	uint8_t dev_id;
+	struct sba_device *sba_dev; /*!< when set, requests use its QoS */
 };
 
 /**
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SENSOR_REPLAY_H__
+#define __SENSOR_REPLAY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "infra/device.h"
+
+/**
+ * @defgroup sensor_replay Sensor trace replay
+ * Physical sensor driver feeding recorded accel/gyro/mag frames.
+ *
+ * The replay sensors register as regular polling physical sensors, so the
+ * sensor core and its algorithms consume recorded traces through the same
+ * path as live data. Feeds asking for the default sensor of a replayed type
+ * are bound to the replay sensor by its id, see sensor_replay_dev_id(). Frames use the raw physical sensor formats
+ * (phy_accel_data_t, phy_gyro_data_t, phy_mag_data_t); one frame is returned
+ * per poll.
+ *
+ * @ingroup phy_sensor
+ * @{
+ */
+
+/** Replayed sensors */
+enum sensor_replay_id {
+	SENSOR_REPLAY_ACCEL = 0,
+	SENSOR_REPLAY_GYRO,
+	SENSOR_REPLAY_MAG,
+	SENSOR_REPLAY_COUNT
+};
+
+/** Replay statistics of one sensor */
+struct sensor_replay_stats {
+	/** Number of frames returned to the sensor core */
+	uint32_t frames;
+	/** Number of polls that found the trace exhausted */
+	uint32_t underruns;
+	/** Time elapsed between the first and the last frame (us) */
+	uint32_t elapsed_us;
+	/** Current position in the trace */
+	uint16_t pos;
+	/** Number of frames in the trace */
+	uint16_t count;
+};
+
+/** Driver instantiating the replay sensors */
+extern struct driver sensor_replay_driver;
+
+/**
+ * Attach a recorded trace to a replay sensor.
+ *
+ * The trace is not copied and must stay valid until replaced. Passing a
+ * NULL trace detaches the sensor. Statistics of the sensor are reset.
+ *
+ * @param id     replayed sensor
+ * @param frames array of raw frames in the format of the sensor
+ * @param count  number of frames in the array
+ * @param loop   restart from the first frame at the end of the trace
+ *
+ * @return DRV_RC_OK on success, DRV_RC_INVALID_CONFIG on wrong parameters
+ */
+int sensor_replay_load(enum sensor_replay_id id, const void *frames,
+		       uint16_t count, bool loop);
+
+/**
+ * Read the replay statistics of a sensor.
+ *
+ * @param id    replayed sensor
+ * @param stats filled with the current statistics
+ *
+ * @return DRV_RC_OK on success, DRV_RC_INVALID_CONFIG on wrong parameters
+ */
+int sensor_replay_get_stats(enum sensor_replay_id id,
+			    struct sensor_replay_stats *stats);
+
+/**
+ * Rewind a replay sensor to the start of its trace and reset its statistics.
+ *
+ * @param id replayed sensor
+ */
+void sensor_replay_rewind(enum sensor_replay_id id);
+
+/**
+ * Get the physical sensor id of the replay sensor of a type.
+ *
+ * The sensor core binds the feeds asking for the default sensor of a
+ * replayed type to this id.
+ *
+ * @param type physical sensor type (SENSOR_ACCELEROMETER...)
+ *
+ * @return the sensor id, 0 if the type is not replayed or the replay
+ *         sensors are not registered
+ */
+uint8_t sensor_replay_dev_id(uint8_t type);
+
+/** @} */
+
+#endif /* __SENSOR_REPLAY_H__ */
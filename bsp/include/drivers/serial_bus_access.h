@@ -85,6 +85,34 @@ typedef enum {
 	SBA_SS_I2C_MASTER_1   /*!< SS  I2C master controller 1, accessible by ARC cpu only */
 } SBA_BUSID;
 
+/**
+ * Priority classes of the requests, the highest goes first
+ */
+typedef enum {
+	SBA_PRIO_NORMAL = 0,  /*!< Default class */
+	SBA_PRIO_HIGH,        /*!< Latency sensitive transfers, e.g. sensor FIFO reads */
+	SBA_PRIO_CRITICAL     /*!< Transfers that must not wait for others */
+} SBA_PRIORITY;
+
+/**
+ *  Quality of service of the requests of a device.
+ */
+struct sba_qos {
+	uint8_t priority;     /*!< Priority class, see SBA_PRIORITY */
+	uint16_t deadline;    /*!< Queueing delay in ms after which a request goes first, 0 for none */
+};
+
+/**
+ *  Queueing delay statistics, in 32k ticks.
+ */
+struct sba_delay_stats {
+	uint32_t count;       /*!< Number of executed requests */
+	uint32_t total;       /*!< Total queueing delay */
+	uint32_t max;         /*!< Longest queueing delay */
+};
+
+struct sba_device;
+
 /**
  *  Transfer request structure.
  */
@@ -105,6 +133,12 @@ typedef struct sba_request {
 	int8_t status;                              /*!< 0 if ok, -1 if error */
 	void *priv_data;                            /*!< User private data */
 	void (*callback)(struct sba_request *);     /*!< Callback to notify transaction completion */
+	struct sba_request *chain;                  /*!< Next request of the transaction, see sba_exec_chain() */
+	/* internal fields */
+	uint8_t priority;                           /*!< Priority class of the request */
+	uint32_t queued;                            /*!< Queueing time in 32k ticks */
+	uint32_t deadline;                          /*!< Time in 32k ticks after which the request goes first, 0 for none */
+	struct sba_device *dev;                     /*!< Device of the request, NULL if unknown */
 }sba_request_t;
 
 /**
@@ -147,9 +181,13 @@ struct sba_master_cfg_data {
 	/* internal fields */
 	list_head_t request_list;               /*!< List to pending requests */
 	sba_request_t *current_request;         /*!< Current request pointer */
+	sba_request_t *current_chain;           /*!< First request of the current transaction */
 	uint8_t controller_initialised;         /*!< Controller initialized flag */
 	struct pm_wakelock sba_wakelock;        /*!< Power manager wakelock */
 	struct clk_gate_info_s *clk_gate_info;  /*!< Clock gate data */
+#ifdef CONFIG_SBA_STATS
+	struct sba_delay_stats stats;           /*!< Queueing delay of the bus requests */
+#endif
 };
 
 /**
@@ -162,6 +200,12 @@ struct sba_device {
 		SPI_SLAVE_ENABLE cs;    /*!< Chip select */
 		uint32_t slave_addr;    /*!< Address of the slave */
 	} addr;
+	struct sba_qos qos;             /*!< Quality of service of the device requests */
+#ifdef CONFIG_SBA_STATS
+	/* internal fields */
+	struct sba_delay_stats stats;   /*!< Queueing delay of the device requests */
+	struct sba_device *stats_next;  /*!< Next device with statistics */
+#endif
 };
 
 /** Export sba driver to link it with devices in soc_config file */
@@ -169,6 +213,7 @@ extern struct driver serial_bus_access_driver;
 
 /**
  *  Request a SBA transfer.
+ *  The request is queued with the normal priority and no deadline.
  *
  *  Configuration parameters must be valid or an error is returned - see return values below.
  *  The callback specified in the request will be called on transfer completion.
@@ -186,6 +231,7 @@ DRIVER_API_RC sba_exec_request(sba_request_t *request);
 
 /**
  *  Request a SBA transfer for a specific device.
+ *  The request is queued according to the quality of service of the device.
  *
  *  Configuration parameters must be valid or an error is returned - see return values below.
  *  The callback specified in the request will be called on transfer completion.
@@ -203,6 +249,38 @@ DRIVER_API_RC sba_exec_request(sba_request_t *request);
 DRIVER_API_RC sba_exec_dev_request(struct sba_device *	dev,
 				   struct sba_request * req);
 
+/**
+ *  Request a chain of SBA transfers as one transaction.
+ *  The requests linked by their chain field, up to a NULL chain, are executed
+ *  back to back on the bus of the first request, without any other request in
+ *  between. The transaction is stopped on the first failing request.
+ *  Only the callback of the first request is called, on transaction completion,
+ *  with the status of the transaction.
+ *  @param request  Pointer to the first request of the chain
+ *  @return
+ *           - DRV_RC_OK on success,
+ *           - DRV_RC_INVALID_CONFIG        - if any configuration parameter is not valid
+ *           - DRV_RC_INVALID_OPERATION     - if both Rx and Tx while it is not implemented
+ *           - DRV_RC_CONTROLLER_IN_USE     - when device is busy
+ *           - DRV_RC_FAIL                  otherwise
+ */
+DRIVER_API_RC sba_exec_chain(sba_request_t *request);
+
+/**
+ *  Request a chain of SBA transfers as one transaction for a specific device.
+ *  See sba_exec_chain().
+ *  @param dev      sba device used to send the requests
+ *  @param req      first sba request of the chain
+ *  @return
+ *           - DRV_RC_OK on success,
+ *           - DRV_RC_INVALID_CONFIG        - if any configuration parameter is not valid
+ *           - DRV_RC_INVALID_OPERATION     - if both Rx and Tx while it is not implemented
+ *           - DRV_RC_CONTROLLER_IN_USE     - when device is busy
+ *           - DRV_RC_FAIL                  otherwise
+ */
+DRIVER_API_RC sba_exec_dev_chain(struct sba_device *	dev,
+				 struct sba_request *	req);
+
 /**
  *  Get physical bus id from logical bus id.
  *
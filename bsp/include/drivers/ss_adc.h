@@ -155,6 +155,10 @@ struct adc_info_t {
 };
 
 /** Read ADC channel
+ *
+ *  If the channel is part of the continuous sequence, the value is the
+ *  average of the frames sampled after the call. Otherwise the sequence,
+ *  if any, is paused for a one-shot read.
  *
  *  @param  channel_id      ADC channel
  *  @param  result_value    Buffer where to return value
@@ -163,6 +167,31 @@ struct adc_info_t {
  */
 DRIVER_API_RC ss_adc_read(uint8_t channel_id, uint16_t *result_value);
 
+#ifdef CONFIG_SS_ADC_SEQ
+#define SS_ADC_SEQ_MAX_CHANNELS 8
+
+/** Start continuous sampling of several channels
+ *
+ *  The channels are sampled in one repetitive hardware sequence and the
+ *  FIFO threshold interrupt stores the samples in a ring buffer read by
+ *  ss_adc_read. A running sequence is replaced.
+ *
+ *  @param  channels        ADC channels of the sequence
+ *  @param  count           Number of channels, 0 stops the sequence
+ *  @param  sample_dly      Delay between two samples in ADC clocks,
+ *                          0 for the default
+ *  @return : DRV_RC_OK or DRV_RC_INVALID_CONFIG if count is too large
+ */
+DRIVER_API_RC ss_adc_seq_start(const uint8_t *channels, uint8_t count,
+			       uint16_t sample_dly);
+
+/** Stop continuous sampling */
+void ss_adc_seq_stop(void);
+
+/** Return the number of FIFO overflows since boot */
+uint32_t ss_adc_seq_overruns(void);
+#endif
+
 /** @} */
 
 #endif  /* SS_ADC_H_ */
@@ -115,7 +115,8 @@
  * @param  xfer_done the callback function called when transfer is complete
  *                  this function will be called in the interrupt context
  * @param  data the data passed to the transfer complete callback
- * @return  0 if success DRV_RC_BUSY if a request is already pending
+ * @return  0 if success DRV_RC_BUSY if all the read requests of the
+ *          channel are pending
  */
 int acm_read(int idx, uint8_t *buffer, int len, void (*xfer_done)(int,
 								  void *),
@@ -138,6 +139,32 @@ int acm_write(int idx, uint8_t *buffer, int len, void (*xfer_done)(int,
 								   void *),
 	      void *data);
 
+/**
+ * Segment of a scatter write.
+ */
+struct acm_sg {
+	uint8_t *buf;
+	int len;
+};
+
+/**
+ * write a list of buffers to an acm channel without copying them.
+ * Each segment uses one request of the channel pool (CONFIG_USB_ACM_REQS)
+ * and the buffers must stay valid until the callback.
+ * The callback is called once, when the last segment completes, with the
+ * total number of bytes transfered.
+ *
+ * @param  idx the index of the ACM interface to use
+ * @param  sg the segments to write
+ * @param  count the number of segments
+ * @param  xfer_done the callback function called when transfer is complete
+ *                  this function will be called in the interrupt context
+ * @param  data the data passed to the transfer complete callback
+ * @return  0 if success DRV_RC_BUSY if not enough requests are free
+ */
+int acm_write_sg(int idx, const struct acm_sg *sg, int count,
+		 void (*xfer_done)(int, void *), void *data);
+
 /**
  * Set the com state.
  *
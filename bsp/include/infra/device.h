@@ -65,6 +65,7 @@ struct __packed __aligned(4) td_device
 	struct driver *driver;          /*!< Driver used for device */
 	PM_POWERSTATE powerstate : 8;   /*!< Powerstate of device */
 	uint8_t id;                     /*!< ID of device */
+	uint8_t lazy_resume;            /*!< Resumed on demand, see device_resume() */
 };
 
 /**
@@ -98,6 +99,26 @@ int suspend_devices(PM_POWERSTATE state);
  */
 void resume_devices(void);
 
+/**
+ * Resumes a device flagged with lazy_resume, if it is still suspended.
+ *
+ * resume_devices() does not resume devices flagged with lazy_resume: they are
+ * resumed in the background from the workqueue (if enabled), or on demand
+ * by this function, that their driver must call before accessing the
+ * hardware. Suspended lazy devices initialized before this one are resumed
+ * first, as a device is always initialized after the devices it depends on.
+ *
+ * It returns immediately if the device is not suspended, so drivers can call
+ * it from every entry point, including the ones used by their init.
+ *
+ * This must be called from a task or fiber.
+ *
+ * @param dev the device to resume
+ *
+ * @attention It will panic if there is an error during resume.
+ */
+void device_resume(struct td_device *dev);
+
 /**
  * Adds all devices to power management infrastructure and init them.
  *
@@ -179,6 +179,35 @@ void ipc_async_init(T_QUEUE queue);
  */
 T_QUEUE ipc_setup(void);
 
+#ifdef CONFIG_IPC_RING
+struct ipc_ring;
+
+/**
+ * Route asynchronous message send/free through shared memory rings.
+ *
+ * Once attached, ipc_async_send_message() and ipc_async_free_message() push
+ * the message address to the tx ring and only use a mailbox as a doorbell,
+ * if the remote CPU drains the ring. They fall back to synchronous requests
+ * when the ring is full or not drained.
+ * The rx ring is marked as ready: the caller must then call
+ * ipc_ring_handle_doorbell() on each doorbell interrupt.
+ *
+ * @param tx       Ring to the remote CPU.
+ * @param rx       Ring from the remote CPU.
+ * @param doorbell Function notifying the remote CPU, called with interrupts
+ *                 locked.
+ */
+void ipc_ring_attach(struct ipc_ring *tx, struct ipc_ring *rx,
+		     void (*doorbell)(void));
+
+/**
+ * Drain the rx ring attached by ipc_ring_attach().
+ *
+ * Meant to be called in the context of the doorbell interrupt.
+ */
+void ipc_ring_handle_doorbell(void);
+#endif
+
 
 /** @} */
 #endif
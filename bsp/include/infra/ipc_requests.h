@@ -56,6 +56,12 @@
  * Set the MessageBox as synchronized.
  */
 #define IPC_MSG_TYPE_SYNC    0x3
+/**
+ * Request to free a batch of messages.
+ * param1: number of messages
+ * ptr: array of message addresses
+ */
+#define IPC_MSG_TYPE_FREE_BATCH 0x4
 
 /**
  * Allocate a port.
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __IPC_RING_H__
+#define __IPC_RING_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @defgroup ipc_ring IPC message rings
+ * Single-producer / single-consumer rings in shared memory.
+ *
+ * <table>
+ * <tr><th><b>Include file</b><td><tt> \#include "infra/ipc_ring.h"</tt>
+ * <tr><th><b>Source path</b> <td><tt>bsp/src/infra</tt>
+ * </table>
+ *
+ * One ring is used per direction between two cores. Each entry is a 32-bit
+ * word, typically a message address. The producer only writes the head
+ * index, the consumer only writes the tail index, so no lock is shared
+ * between the cores.
+ *
+ * A mailbox is only used as a doorbell: the consumer arms the doorbell once
+ * it has emptied the ring, and the producer rings it (once) when it finds it
+ * armed after pushing an entry. Entries pushed while the consumer is
+ * draining the ring are therefore batched without any mailbox transaction.
+ *
+ * The ring is portable C so that it can also be exercised on a host.
+ *
+ * @ingroup ipc
+ * @{
+ */
+
+/** Maximum number of entries of a ring, must be a power of 2 */
+#ifdef CONFIG_IPC_RING_SIZE
+#define IPC_RING_SIZE CONFIG_IPC_RING_SIZE
+#else
+#define IPC_RING_SIZE 64
+#endif
+
+/** A shared memory ring */
+struct ipc_ring {
+	/** Index of the next entry to write, only written by the producer */
+	volatile uint32_t head;
+	/** Index of the next entry to read, only written by the consumer */
+	volatile uint32_t tail;
+	/** Set by the consumer when it needs a doorbell to see new entries */
+	volatile uint32_t doorbell;
+	/** Set by the consumer once it is ready to drain the ring */
+	volatile uint32_t ready;
+	/** Number of entries - 1 */
+	uint32_t mask;
+	/** Entries */
+	volatile uint32_t entries[IPC_RING_SIZE];
+};
+
+/**
+ * Initialize a ring.
+ *
+ * The ring is not ready: the consumer has to call ipc_ring_set_ready().
+ *
+ * @param ring the ring to initialize
+ */
+void ipc_ring_init(struct ipc_ring *ring);
+
+/**
+ * Mark the ring as drained by its consumer.
+ *
+ * @param ring the ring
+ */
+void ipc_ring_set_ready(struct ipc_ring *ring);
+
+/**
+ * Check if a consumer drains the ring.
+ *
+ * @param ring the ring
+ *
+ * @return true if the ring can be used by the producer
+ */
+static inline bool ipc_ring_is_ready(struct ipc_ring *ring)
+{
+	return ring && ring->ready;
+}
+
+/**
+ * Push an entry (producer side).
+ *
+ * The producer must serialize its own calls (e.g. by locking interrupts).
+ *
+ * @param ring  the ring
+ * @param entry the entry to push
+ *
+ * @return 0 if the entry was pushed, -1 if the ring is full
+ */
+int ipc_ring_push(struct ipc_ring *ring, uint32_t entry);
+
+/**
+ * Check, after a push, if the consumer has to be notified (producer side).
+ *
+ * This disarms the doorbell: it returns true at most once until the consumer
+ * arms it again.
+ *
+ * @param ring the ring
+ *
+ * @return true if the doorbell has to be rung
+ */
+bool ipc_ring_take_doorbell(struct ipc_ring *ring);
+
+/**
+ * Pop an entry (consumer side).
+ *
+ * @param ring  the ring
+ * @param entry the popped entry
+ *
+ * @return 0 if an entry was popped, -1 if the ring is empty
+ */
+int ipc_ring_pop(struct ipc_ring *ring, uint32_t *entry);
+
+/**
+ * Arm the doorbell once the ring has been drained (consumer side).
+ *
+ * Entries may have been pushed between the last pop and the arming, without
+ * a doorbell: the consumer has to drain the ring again if this returns true.
+ *
+ * @param ring the ring
+ *
+ * @return true if the ring is not empty
+ */
+bool ipc_ring_arm_doorbell(struct ipc_ring *ring);
+
+/** @} */
+
+#endif /* __IPC_RING_H__ */
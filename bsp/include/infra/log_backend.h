@@ -42,8 +42,8 @@
 /**
  * Provide the final low level function used to output logs on a backend.
  *
- * Implementation of a log_backend need to provide valid functions for these 2
- * callbacks.
+ * Implementation of a log_backend need to provide valid functions for the
+ * first 2 callbacks, flush is optional.
  */
 struct log_backend {
 	/**
@@ -57,6 +57,11 @@ struct log_backend {
 	 * Returns the current backend status.
 	 */
 	bool (*is_backend_ready)(void);
+	/**
+	 * Write out any text buffered by the backend, called by log_flush().
+	 * May be NULL if the backend does not buffer.
+	 */
+	void (*flush)(void);
 };
 
 /** @} */
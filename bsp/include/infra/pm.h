@@ -70,8 +70,15 @@
  *
  */
 struct pm_wakelock {
-	list_t list;     /*!< Internal list management member */
 	unsigned int lock; /*!< Lock to avoid acquiring a lock several times */
+#ifdef CONFIG_PM_WAKELOCK_STATS
+	struct pm_wakelock *next; /*!< Next wakelock with statistics */
+	const char *name;         /*!< Function that initialized the wakelock */
+	uint32_t acquire_time;    /*!< Last acquire time, in 32k ticks */
+	uint32_t acquire_count;   /*!< Number of acquires */
+	uint32_t max_hold_time;   /*!< Longest hold, in 32k ticks */
+	uint64_t hold_time;       /*!< Total hold time, in 32k ticks */
+#endif
 };
 
 /**
@@ -84,10 +91,26 @@ void pm_wakelock_init_mgr();
 /**
  * Initialize a wakelock structure.
  *
+ * With CONFIG_PM_WAKELOCK_STATS, the wakelock is recorded for the
+ * "pm wakelocks" test command, named after the calling function: it must not
+ * be allocated on the stack.
+ *
  * @param wli Address of the wakelock structure to initialize.
  */
 void pm_wakelock_init(struct pm_wakelock *wli);
 
+#ifdef CONFIG_PM_WAKELOCK_STATS
+/**
+ * Initialize a wakelock structure, and record it with a name.
+ *
+ * @param wli  Address of the wakelock structure to initialize.
+ * @param name Name of the wakelock in the statistics.
+ */
+void pm_wakelock_init_named(struct pm_wakelock *wli, const char *name);
+
+#define pm_wakelock_init(wli) pm_wakelock_init_named(wli, __func__)
+#endif
+
 /**
  * Acquire a wakelock.
  *
@@ -104,7 +127,7 @@ int pm_wakelock_acquire(struct pm_wakelock *wl);
  *
  * @param wl Wakelock to release
  *
- * @return 0 on success, -EINVAL if already released, -ENOENT if list clear
+ * @return 0 on success, -EINVAL if already released
  */
 int pm_wakelock_release(struct pm_wakelock *wl);
 
@@ -243,6 +243,30 @@ void system_event_push(struct system_event *evt);
  */
 struct system_event *system_event_pop(void);
 
+/**
+ * Pop several system events
+ *
+ * This function retrieves the first available system events in the buffer,
+ * without allocating memory.
+ *
+ * @param evts  Buffer of count * SYSTEM_EVENT_SIZE bytes, filled with the
+ *              retrieved system events.
+ * @param count Maximum number of system events to retrieve.
+ *
+ * @return The number of system events retrieved.
+ */
+int system_event_pop_bulk(uint8_t *evts, int count);
+
+#ifdef CONFIG_SYSTEM_EVENTS_STAGING
+/**
+ * Write the system events staged in RAM to the buffer.
+ *
+ * Pushed events are written in batches. This is called on panic and
+ * shutdown events, and may be called before any other reset.
+ */
+void system_events_flush(void);
+#endif
+
 /**
  * Fill the header part of a system event
  *
@@ -93,6 +93,11 @@ struct tcmd_handler {
  *         }
  *     }
  *     INSERT BEFORE .rodata;
+ *
+ * Each handler is put in a section named .test_cmds.<group>.<name>, so that
+ * the SORT directive orders the table by group, then by name (the '.'
+ * separator sorts before any character allowed in a group name). The engine
+ * relies on that ordering to look handlers up with a binary search.
  */
 
 #ifdef CONFIG_TCMD
@@ -112,7 +117,7 @@ struct tcmd_handler {
  * either the group or name */
 #define _DECLARE_TEST_COMMAND_PRESCAN(group, name, handler) \
 	const struct tcmd_handler __test_cmd_ ## group ## _ ## name   \
-	__section(".test_cmds." # group # name)	   \
+	__section(".test_cmds." # group "." # name)   \
 		= { # group, # name, handler }
 
 #else
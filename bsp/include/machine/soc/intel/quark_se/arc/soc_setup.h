@@ -37,4 +37,14 @@
  * */
 void soc_setup();
 
+#ifdef CONFIG_IPC_RING
+/**
+ * Notify quark that the IPC ring to quark is not empty.
+ *
+ * The doorbell has its own mailbox channel, IPC_SS_QRK_RING: printk
+ * transactions on IPC_SS_QRK_ASYNC cannot overwrite it.
+ */
+void ipc_ring_quark_doorbell(void);
+#endif
+
 #endif
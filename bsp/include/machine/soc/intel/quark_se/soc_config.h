@@ -113,6 +113,10 @@ struct platform_shared_block_ {
 
 	/** reserved for user application */
 	uint8_t user_reverved;
+
+	/** IPC rings published by quark, indexed by IPC_RING_QRK_SS and
+	 * IPC_RING_SS_QRK, NULL if not supported */
+	void *ipc_rings;
 };
 
 #define RAM_START           0xA8000000
@@ -159,6 +163,12 @@ static volatile uint32_t __unused *board_features =
 #define IPC_QRK_SS_ACK 1
 #define IPC_QRK_SS_ASYNC 7
 
+/* ARC to quark IPC ring doorbell, kept apart from the printk channel */
+#define IPC_SS_QRK_RING 2
+
+#define IPC_RING_QRK_SS 0
+#define IPC_RING_SS_QRK 1
+
 /* I2C */
 /*!
  * List of all controllers in system ( IA and SS )
@@ -232,6 +242,7 @@ typedef enum {
 	SPI_OHRM_ID = 41,
 	MANAGED_COMPARATOR_ID = 42,
 	BATT_CHARGER_ID = 43,
+	SENSOR_REPLAY_ID = 44,
 } DEVICE_ID;
 
 /* SBA_SPI0_ID */
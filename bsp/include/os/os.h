@@ -981,6 +981,24 @@ void local_task_sleep_ticks(int ticks);
  */
 void os_init(void);
 
+#ifdef CONFIG_OS_LINUX
+/**
+ * Lock out the simulated interrupt context (timer callbacks).
+ *
+ * On target these come from the kernel headers. Calls nest.
+ *
+ * @return key to pass to @ref irq_unlock
+ */
+unsigned int irq_lock(void);
+
+/**
+ * Release a lock taken by @ref irq_lock.
+ *
+ * @param key value returned by the matching @ref irq_lock
+ */
+void irq_unlock(unsigned int key);
+#endif
+
 /**
  * @}
  */
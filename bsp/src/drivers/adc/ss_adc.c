@@ -36,6 +36,7 @@
  *****************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <nanokernel.h>
 #include <arch/cpu.h>
 #include "util/assert.h"
@@ -83,6 +84,30 @@
 #define FINE_RATIO          8
 #define FINE_SAMPLE_DLY     14
 
+#ifdef CONFIG_SS_ADC_SEQ
+/* Number of sequencer frames averaged by ss_adc_read */
+#define SEQ_AVG_FRAMES      4
+#if SEQ_AVG_FRAMES > CONFIG_SS_ADC_SEQ_FRAMES
+#error "CONFIG_SS_ADC_SEQ_FRAMES must hold the averaged frames"
+#endif
+/* Maximum time to wait for fresh frames, in ms */
+#define SEQ_READ_TIMEOUT    10
+
+/* Continuous sampling state: each frame holds one sample per channel */
+static struct {
+	uint8_t channels[SS_ADC_SEQ_MAX_CHANNELS];
+	uint8_t count;          /* sequenced channels, 0 when stopped */
+	uint8_t frames_per_irq; /* frames popped per FIFO threshold interrupt */
+	uint16_t sample_dly;
+	bool irq_connected;
+	uint16_t ring[CONFIG_SS_ADC_SEQ_FRAMES][SS_ADC_SEQ_MAX_CHANNELS];
+	uint32_t frames;        /* frames received since start */
+	uint32_t wait_frames;   /* frame count awaited by a reader, 0 if none */
+	uint32_t overruns;
+	T_SEMAPHORE sem;
+} seq;
+#endif
+
 const ss_adc_cfg_data_t fine_config = {
 	.in_mode = SINGLED_ENDED,
 	.out_mode = PARALLEL,
@@ -98,6 +123,10 @@ static void adc_goto_normal_mode_wo_calibration(struct td_device *dev);
 static void adc_goto_deep_power_down(struct td_device *dev);
 static void ss_adc_enable(struct td_device *dev);
 static void ss_adc_disable(struct td_device *dev);
+#ifdef CONFIG_SS_ADC_SEQ
+static void seq_hw_start(struct td_device *dev);
+static void seq_hw_stop(struct td_device *dev);
+#endif
 
 static void ss_adc_set_config(struct td_device *dev)
 {
@@ -301,6 +330,9 @@ static int ss_adc_init(struct td_device *dev)
 
 	ss_adc_disable(dev); /* disable IP by default */
 	info->adc_in_use = mutex_create();
+#ifdef CONFIG_SS_ADC_SEQ
+	seq.sem = semaphore_create(0);
+#endif
 	pr_debug(LOG_MODULE_DRV, "%s %d init", DRV_NAME, dev->id);
 	return 0;
 }
@@ -308,6 +340,11 @@ static int ss_adc_init(struct td_device *dev)
 static int ss_adc_suspend(struct td_device *dev, PM_POWERSTATE state)
 {
 	pr_debug(LOG_MODULE_DRV, "%s %d suspend", DRV_NAME, dev->id);
+#ifdef CONFIG_SS_ADC_SEQ
+	/* The sequence is kept and restarted on resume */
+	if (seq.count)
+		seq_hw_stop(dev);
+#endif
 	return 0;
 }
 
@@ -316,12 +353,21 @@ static int ss_adc_resume(struct td_device *dev)
 	pr_debug(LOG_MODULE_DRV, "%s %d resume", DRV_NAME, dev->id);
 	/* disable IP by default */
 	ss_adc_disable(dev);
+#ifdef CONFIG_SS_ADC_SEQ
+	if (seq.count)
+		seq_hw_start(dev);
+#endif
 	return 0;
 }
 
-DRIVER_API_RC ss_adc_read(uint8_t channel_id, uint16_t *result_value)
+/*
+ * Sample a channel REPEAT_TIME times in single shot mode, polling for the
+ * end of the sequence. Called with adc_in_use held.
+ */
+static DRIVER_API_RC adc_single_read(struct td_device *adc_dev,
+				     uint8_t channel_id,
+				     uint16_t *result_value)
 {
-	struct td_device *adc_dev = &pf_device_ss_adc;
 	struct adc_info_t *info = adc_dev->priv;
 	uint32_t data[REPEAT_TIME] = { 0 };
 	DRIVER_API_RC ret = DRV_RC_OK;
@@ -330,8 +376,6 @@ DRIVER_API_RC ss_adc_read(uint8_t channel_id, uint16_t *result_value)
 	uint32_t temp_value = 0;
 	uint32_t reg_get_sample = 0;
 
-	mutex_lock(info->adc_in_use, OS_WAIT_FOREVER);
-
 	ss_adc_set_config(adc_dev);
 	ss_adc_set_seq(adc_dev, channel_id);
 
@@ -356,9 +400,8 @@ DRIVER_API_RC ss_adc_read(uint8_t channel_id, uint16_t *result_value)
 		}
 
 		if (get_uptime_ms() - start_point >= 10) {
-			ret = DRV_RC_TIMEOUT;
 			ss_adc_disable(adc_dev);
-			goto fail;
+			return DRV_RC_TIMEOUT;
 		}
 	}
 	ss_adc_disable(adc_dev);
@@ -371,7 +414,218 @@ DRIVER_API_RC ss_adc_read(uint8_t channel_id, uint16_t *result_value)
 	}
 
 	*result_value = temp_value / count;
-fail:
+	return ret;
+}
+
+#ifdef CONFIG_SS_ADC_SEQ
+static void ss_adc_rx_isr(void *arg)
+{
+	struct td_device *dev = arg;
+	struct adc_info_t *info = dev->priv;
+	uint32_t pop = READ_ARC_REG(info->reg_base + ADC_SET) | ADC_POP_SAMPLE;
+	uint16_t *frame;
+	int f, c;
+
+	for (f = 0; f < seq.frames_per_irq; f++) {
+		frame = seq.ring[seq.frames % CONFIG_SS_ADC_SEQ_FRAMES];
+		for (c = 0; c < seq.count; c++) {
+			WRITE_ARC_REG(pop, info->reg_base + ADC_SET);
+			frame[c] = READ_ARC_REG(info->reg_base + ADC_SAMPLE);
+		}
+		seq.frames++;
+	}
+	WRITE_ARC_REG(READ_ARC_REG(info->reg_base + ADC_CTRL) | ADC_CLR_DATA_A,
+		      info->reg_base + ADC_CTRL);
+
+	if (seq.wait_frames && (int32_t)(seq.frames - seq.wait_frames) >= 0) {
+		seq.wait_frames = 0;
+		semaphore_give(seq.sem, NULL);
+	}
+}
+
+static void ss_adc_err_isr(void *arg)
+{
+	struct td_device *dev = arg;
+	struct adc_info_t *info = dev->priv;
+
+	/* A FIFO overflow breaks the channel order of the samples: drop the
+	 * FIFO content and restart the sequence from its first entry */
+	seq.overruns++;
+	WRITE_ARC_REG(READ_ARC_REG(info->reg_base + ADC_SET) | ADC_FLUSH_RX,
+		      info->reg_base + ADC_SET);
+	WRITE_ARC_REG(READ_ARC_REG(info->reg_base + ADC_CTRL)
+		      | ADC_CLR_OVERFLOW | ADC_CLR_UNDRFLOW | ADC_CLR_SEQ_ERR
+		      | ADC_SEQ_PTR_RST, info->reg_base + ADC_CTRL);
+}
+
+/*
+ * Program the sequence table with the sequenced channels in repetitive
+ * mode and let the FIFO threshold interrupt collect the samples.
+ */
+static void seq_hw_start(struct td_device *dev)
+{
+	struct adc_info_t *info = dev->priv;
+	uint32_t reg_val;
+	int i;
+
+	seq.frames_per_irq = info->fifo_tld / seq.count;
+
+	ss_adc_set_config(dev);
+	ss_adc_enable(dev);
+
+	reg_val = READ_ARC_REG(info->reg_base + ADC_SET);
+	reg_val &= ADC_SEQ_MODE_SET_MASK;
+	reg_val |= (REPETITIVE << SEQUENCE_MODE_POS);
+	reg_val &= ADC_SEQ_SIZE_SET_MASK;
+	reg_val |= (((seq.count - 1) & SIX_BITS_SET) << SEQ_ENTRIES_POS);
+	reg_val &= ADC_FTL_SET_MASK;
+	reg_val |= ((seq.count * seq.frames_per_irq - 1) << THRESHOLD_POS);
+	WRITE_ARC_REG(reg_val, info->reg_base + ADC_SET);
+	info->seq_mode = REPETITIVE;
+	info->seq_size = seq.count;
+
+	/* Sequence entries are written two by two */
+	for (i = 0; i < seq.count; i += 2) {
+		reg_val = ((seq.sample_dly & ELEVEN_BITS_SET)
+			   << SEQ_DELAY_EVEN_POS);
+		reg_val |= (seq.channels[i] & FIVE_BITS_SET);
+		if (i + 1 < seq.count) {
+			reg_val |= ((seq.sample_dly & ELEVEN_BITS_SET)
+				    << SEQ_DELAY_ODD_POS);
+			reg_val |= ((seq.channels[i + 1] & FIVE_BITS_SET)
+				    << SEQ_MUX_ODD_POS);
+		}
+		WRITE_ARC_REG(reg_val, info->reg_base + ADC_SEQ);
+	}
+
+	WRITE_ARC_REG(READ_ARC_REG(info->reg_base + ADC_CTRL) | ADC_SEQ_PTR_RST,
+		      info->reg_base + ADC_CTRL);
+
+	if (!seq.irq_connected) {
+		irq_connect_dynamic(info->rx_vector, ISR_DEFAULT_PRIO,
+				    ss_adc_rx_isr, dev, 0);
+		irq_connect_dynamic(info->err_vector, ISR_DEFAULT_PRIO,
+				    ss_adc_err_isr, dev, 0);
+		irq_enable(info->rx_vector);
+		irq_enable(info->err_vector);
+		seq.irq_connected = true;
+	}
+	MMIO_REG_VAL(info->adc_irq_mask) &= ENABLE_SSS_INTERRUPTS;
+	MMIO_REG_VAL(info->adc_err_mask) &= ENABLE_SSS_INTERRUPTS;
+
+	info->state = ADC_STATE_SAMPLING;
+	WRITE_ARC_REG(ADC_SEQ_START | ADC_ENABLE | ADC_CLK_ENABLE,
+		      info->reg_base + ADC_CTRL);
+}
+
+static void seq_hw_stop(struct td_device *dev)
+{
+	struct adc_info_t *info = dev->priv;
+
+	MMIO_REG_VAL(info->adc_irq_mask) |= DISABLE_SSS_INTERRUPTS;
+	MMIO_REG_VAL(info->adc_err_mask) |= DISABLE_SSS_INTERRUPTS;
+	ss_adc_disable(dev);
+	info->state = ADC_STATE_IDLE;
+}
+
+/*
+ * Average the latest frames of a sequenced channel, waiting for frames
+ * sampled after the call.
+ */
+static DRIVER_API_RC seq_read(int idx, uint16_t *result_value)
+{
+	uint32_t flags, sum = 0, frame, count;
+
+	/* Drop a wake up given after a previous timeout */
+	while (semaphore_take(seq.sem, OS_NO_WAIT) == E_OS_OK) ;
+
+	flags = irq_lock();
+	seq.wait_frames = seq.frames + SEQ_AVG_FRAMES;
+	/* 0 means no reader */
+	if (!seq.wait_frames)
+		seq.wait_frames = 1;
+	irq_unlock(flags);
+
+	if (semaphore_take(seq.sem, SEQ_READ_TIMEOUT) != E_OS_OK) {
+		seq.wait_frames = 0;
+		return DRV_RC_TIMEOUT;
+	}
+
+	/* The ring holds the frames written since start, up to its size: a
+	 * sample of 0 is a valid reading */
+	flags = irq_lock();
+	count = seq.frames < SEQ_AVG_FRAMES ? seq.frames : SEQ_AVG_FRAMES;
+	for (frame = seq.frames - count; frame != seq.frames; frame++)
+		sum += seq.ring[frame % CONFIG_SS_ADC_SEQ_FRAMES][idx];
+	irq_unlock(flags);
+
+	if (!count)
+		return DRV_RC_FAIL;
+	*result_value = sum / count;
+	return DRV_RC_OK;
+}
+
+DRIVER_API_RC ss_adc_seq_start(const uint8_t *channels, uint8_t count,
+			       uint16_t sample_dly)
+{
+	struct td_device *adc_dev = &pf_device_ss_adc;
+	struct adc_info_t *info = adc_dev->priv;
+
+	if (count > SS_ADC_SEQ_MAX_CHANNELS)
+		return DRV_RC_INVALID_CONFIG;
+
+	mutex_lock(info->adc_in_use, OS_WAIT_FOREVER);
+	if (seq.count)
+		seq_hw_stop(adc_dev);
+	seq.count = count;
+	seq.sample_dly = sample_dly ? sample_dly : FINE_SAMPLE_DLY;
+	seq.frames = 0;
+	memcpy(seq.channels, channels, count);
+	if (count)
+		seq_hw_start(adc_dev);
+	mutex_unlock(info->adc_in_use);
+	return DRV_RC_OK;
+}
+
+void ss_adc_seq_stop(void)
+{
+	ss_adc_seq_start(NULL, 0, 0);
+}
+
+uint32_t ss_adc_seq_overruns(void)
+{
+	return seq.overruns;
+}
+#endif
+
+DRIVER_API_RC ss_adc_read(uint8_t channel_id, uint16_t *result_value)
+{
+	struct td_device *adc_dev = &pf_device_ss_adc;
+	struct adc_info_t *info = adc_dev->priv;
+	DRIVER_API_RC ret;
+
+	mutex_lock(info->adc_in_use, OS_WAIT_FOREVER);
+#ifdef CONFIG_SS_ADC_SEQ
+	if (seq.count) {
+		int i;
+
+		for (i = 0; i < seq.count; i++) {
+			if (seq.channels[i] == channel_id) {
+				ret = seq_read(i, result_value);
+				goto out;
+			}
+		}
+		/* Not sequenced: pause the sequence for a one-shot read */
+		seq_hw_stop(adc_dev);
+		ret = adc_single_read(adc_dev, channel_id, result_value);
+		seq_hw_start(adc_dev);
+		goto out;
+	}
+#endif
+	ret = adc_single_read(adc_dev, channel_id, result_value);
+#ifdef CONFIG_SS_ADC_SEQ
+out:
+#endif
 	mutex_unlock(info->adc_in_use);
 	return ret;
 }
@@ -35,6 +35,7 @@
 
 #include "os/os.h"      /* For balloc */
 #include "infra/log.h"  /* For logger */
+#include "infra/device.h"
 
 #include "drivers/serial_bus_access.h"
 
@@ -50,6 +51,8 @@ struct driver_data {
 	uint8_t is_init;                        /*!< Init state of memory */
 
 	struct sba_request req;                 /*!< sba request object used to drive the spi flash */
+	struct sba_request wren_req;            /*!< write enable request chained before program and erase */
+	struct sba_request rdsr_req;            /*!< status read request checking the write enable */
 	T_TIMER spi_timer;                      /*!< Timer to wait for erase/program operations to complete */
 	T_SEMAPHORE spi_timer_sem;              /*!< Semaphore to wait for spi_timer event */
 	T_SEMAPHORE spi_sync_sem;               /*!< Semaphore to wait for and spi transfer to complete */
@@ -69,12 +72,13 @@ typedef enum {
 /* Internal device driver functions */
 static DRIVER_API_RC spi_flash_get_rdscur(struct td_device *	dev,
 					  uint8_t *		rdscur);
-static DRIVER_API_RC spi_flash_write_enable(struct td_device *dev);
 static DRIVER_API_RC spi_flash_sleep(struct td_device *dev, bool on);
 static DRIVER_API_RC spi_flash_erase(struct td_device *dev, ER_TYPE er_type,
 				     unsigned int start,
 				     unsigned int count);
 static DRIVER_API_RC spi_sync(struct td_device *dev, struct sba_request *req);
+static DRIVER_API_RC spi_write_sync(struct td_device *	dev,
+				    struct sba_request *req);
 
 /* Device driver callback functions */
 static void spi_timer_sync_callback(void *priv);
@@ -116,6 +120,8 @@ int spi_flash_init(struct td_device *device)
 	flash_dev->req.request_type = SBA_TRANSFER;
 	flash_dev->req.addr.cs = dev->addr.cs;
 	flash_dev->req.full_duplex = 0;
+	flash_dev->wren_req = flash_dev->req;
+	flash_dev->rdsr_req = flash_dev->req;
 
 	/* Link driver priv data to device */
 	device->priv = flash_dev;
@@ -188,6 +194,51 @@ static DRIVER_API_RC spi_sync(struct td_device *dev, struct sba_request *req)
 	return ret;
 }
 
+/*
+ * Send a program or erase request in one bus transaction with the write
+ * enable command and the status read checking it: the bus wakelock and clock
+ * are taken once. If the write enable failed, the flash ignores the request.
+ */
+static DRIVER_API_RC spi_write_sync(struct td_device *	dev,
+				    struct sba_request *req)
+{
+	DRIVER_API_RC ret;
+	struct driver_data *flash_dev = (struct driver_data *)dev->priv;
+	const struct spi_flash_info *info = GET_SPI_FLASH_INFO(dev);
+	uint8_t wren = info->cmd_write_en;
+	uint8_t rdsr = info->cmd_read_status;
+	uint8_t status = 0;
+
+	flash_dev->wren_req.tx_len = 1;
+	flash_dev->wren_req.tx_buff = &wren;
+	flash_dev->wren_req.rx_len = 0;
+	flash_dev->wren_req.rx_buff = NULL;
+	flash_dev->wren_req.chain = &flash_dev->rdsr_req;
+
+	flash_dev->rdsr_req.tx_len = 1;
+	flash_dev->rdsr_req.tx_buff = &rdsr;
+	flash_dev->rdsr_req.rx_len = 1;
+	flash_dev->rdsr_req.rx_buff = &status;
+	flash_dev->rdsr_req.chain = req;
+
+	req->chain = NULL;
+
+	flash_dev->wren_req.priv_data = flash_dev->spi_sync_sem;
+	flash_dev->wren_req.callback = spi_completion_callback;
+
+	if ((ret =
+		     sba_exec_dev_chain((struct sba_device *)dev,
+					&flash_dev->wren_req)) != DRV_RC_OK)
+		return ret;
+	/* Wait for the transaction to complete */
+	if (semaphore_take(flash_dev->spi_sync_sem, SBA_TIMEOUT) != E_OS_OK)
+		return DRV_RC_FAIL;
+	if ((ret = flash_dev->wren_req.status) != DRV_RC_OK)
+		return ret;
+
+	return (status & info->status_wel_bit) ? DRV_RC_OK : DRV_RC_FAIL;
+}
+
 static DRIVER_API_RC spi_flash_sleep(struct td_device *dev, bool on)
 {
 	uint8_t command;
@@ -223,6 +274,9 @@ DRIVER_API_RC spi_flash_get_rdid(struct td_device *dev, uint32_t *rdid)
 
 	if (!flash_dev->is_init)
 		return DRV_RC_INVALID_OPERATION;
+	/* The flash and its bus are resumed lazily, see soc_config.c */
+	device_resume(dev);
+
 	/* Take spi device mutex */
 	if ((ret_os =
 		     mutex_lock(flash_dev->device_mtx,
@@ -258,6 +312,8 @@ DRIVER_API_RC spi_flash_get_status(struct td_device *dev, uint8_t *status)
 	struct driver_data *flash_dev = (struct driver_data *)dev->priv;
 	const struct spi_flash_info *info = GET_SPI_FLASH_INFO(dev);
 
+	device_resume(dev);
+
 	flash_dev->req.tx_len = 1;
 	flash_dev->req.tx_buff = &command;
 	flash_dev->req.rx_len = 1;
@@ -285,36 +341,6 @@ static DRIVER_API_RC spi_flash_get_rdscur(struct td_device *	dev,
 	return spi_sync(dev, &flash_dev->req);
 }
 
-static DRIVER_API_RC spi_flash_write_enable(struct td_device *dev)
-{
-	uint8_t command = 0, status = 0;
-	struct driver_data *flash_dev = (struct driver_data *)dev->priv;
-	const struct spi_flash_info *info = GET_SPI_FLASH_INFO(dev);
-	DRIVER_API_RC ret;
-
-	flash_dev->req.tx_len = 1;
-	flash_dev->req.tx_buff = &command;
-	flash_dev->req.rx_len = 0;
-	flash_dev->req.rx_buff = NULL;
-
-	command = info->cmd_write_en;
-
-	/* Send write enable command */
-	if ((ret = spi_sync(dev, &flash_dev->req)) != DRV_RC_OK)
-		return ret;
-
-	flash_dev->req.rx_len = 1;
-	flash_dev->req.rx_buff = &status;
-
-	command = info->cmd_read_status;
-
-	/* Read status register to check if write is enabled */
-	if ((ret = spi_sync(dev, &flash_dev->req)) != DRV_RC_OK)
-		return ret;
-
-	return (status & info->status_wel_bit) ? DRV_RC_OK : DRV_RC_FAIL;
-}
-
 DRIVER_API_RC spi_flash_read_byte(struct td_device *dev, uint32_t address,
 				  unsigned int len, unsigned int *retlen,
 				  uint8_t *data)
@@ -333,6 +359,9 @@ DRIVER_API_RC spi_flash_read_byte(struct td_device *dev, uint32_t address,
 	if ((len + address) > info->flash_size)
 		return DRV_RC_OUT_OF_MEM;
 
+	/* The flash and its bus are resumed lazily, see soc_config.c */
+	device_resume(dev);
+
 	/* Take spi device mutex */
 	if ((ret_os =
 		     mutex_lock(flash_dev->device_mtx,
@@ -345,6 +374,8 @@ DRIVER_API_RC spi_flash_read_byte(struct td_device *dev, uint32_t address,
 	if ((ret = spi_flash_sleep(dev, true)) != DRV_RC_OK)
 		goto exit_mutex;
 
+	/* The flash is alone on its bus, so a long read is done in one
+	 * transfer: splitting it would only add command overhead */
 	command[0] = info->cmd_read;
 	command[1] = (uint8_t)(address >> 16);
 	command[2] = (uint8_t)(address >> 8);
@@ -400,6 +431,9 @@ DRIVER_API_RC spi_flash_write_byte(struct td_device *dev, uint32_t address,
 	if ((len + address) > info->flash_size)
 		return DRV_RC_OUT_OF_MEM;
 
+	/* The flash and its bus are resumed lazily, see soc_config.c */
+	device_resume(dev);
+
 	/* Take spi device mutex */
 	if ((ret_os =
 		     mutex_lock(flash_dev->device_mtx,
@@ -429,12 +463,6 @@ DRIVER_API_RC spi_flash_write_byte(struct td_device *dev, uint32_t address,
 	     data += count, count =
 		     ((len -= count) >
 		      info->page_size ? info->page_size : len)) {
-		/* Enable write operation */
-		if ((ret = spi_flash_write_enable(dev)) != DRV_RC_OK) {
-			*retlen -= len;
-			goto exit_wakeup;
-		}
-
 		/* Set data for write operation */
 		memcpy((uint8_t *)(flash_dev->tx_buffer) + 4, data, count);
 		flash_dev->req.tx_len = count + 4;
@@ -446,7 +474,8 @@ DRIVER_API_RC spi_flash_write_byte(struct td_device *dev, uint32_t address,
 		flash_dev->tx_buffer[2] = (uint8_t)(address >> 8);
 		flash_dev->tx_buffer[3] = (uint8_t)address;
 
-		if ((ret = spi_sync(dev, &flash_dev->req)) != DRV_RC_OK) {
+		/* Enable write operation and program the page */
+		if ((ret = spi_write_sync(dev, &flash_dev->req)) != DRV_RC_OK) {
 			*retlen -= len;
 			goto exit_wakeup;
 		}
@@ -549,6 +578,9 @@ static DRIVER_API_RC spi_flash_erase(struct td_device *dev, ER_TYPE er_type,
 	if ((count + start) > er_count)
 		return DRV_RC_OUT_OF_MEM;
 
+	/* The flash and its bus are resumed lazily, see soc_config.c */
+	device_resume(dev);
+
 	/* Take spi device mutex */
 	if ((ret_os =
 		     mutex_lock(flash_dev->device_mtx,
@@ -564,10 +596,6 @@ static DRIVER_API_RC spi_flash_erase(struct td_device *dev, ER_TYPE er_type,
 	for (count += start; start < count; start++) {
 		uint32_t address = er_size * start;
 
-		/* Enable write operation */
-		if ((ret = spi_flash_write_enable(dev)) != DRV_RC_OK)
-			goto exit_wakeup;
-
 		flash_dev->req.tx_len = command_len;
 		flash_dev->req.tx_buff = command;
 		flash_dev->req.rx_len = 0;
@@ -577,7 +605,8 @@ static DRIVER_API_RC spi_flash_erase(struct td_device *dev, ER_TYPE er_type,
 		command[2] = (uint8_t)(address >> 8);
 		command[3] = (uint8_t)address;
 
-		if ((ret = spi_sync(dev, &flash_dev->req)) != DRV_RC_OK)
+		/* Enable write operation and erase */
+		if ((ret = spi_write_sync(dev, &flash_dev->req)) != DRV_RC_OK)
 			/* Error detected */
 			goto exit_wakeup;
 
@@ -29,16 +29,43 @@
  */
 
 #include <stddef.h>
+#include <string.h>
 #include <errno.h>
 
 #include "infra/device.h"
 #include "infra/log.h"
 #include "infra/panic.h"
+#include "os/os.h"
 #include "machine.h"
+#ifdef CONFIG_WORKQUEUE
+#include "util/workqueue.h"
+#endif
+#ifdef CONFIG_DEVICE_RESUME_STATS
+#include <stdio.h>
+#include "infra/time.h"
+#include "infra/tcmd/handler.h"
+#endif
 
 static struct td_device **all_devices = NULL;
 static uint32_t all_devices_count = 0;
 
+/* Serializes the resume of lazy devices */
+static T_MUTEX lazy_mutex;
+/* Prevents suspend while lazy devices are being resumed */
+static struct pm_wakelock lazy_wakelock;
+
+#ifdef CONFIG_DEVICE_RESUME_STATS
+/* Resume durations of a device, in 32k ticks */
+struct resume_stats {
+	uint32_t count;
+	uint32_t last;
+	uint32_t max;
+	uint32_t total;
+};
+
+static struct resume_stats *resume_stats;
+#endif
+
 void init_devices(struct td_device **_all_devices, uint32_t _all_devices_count)
 {
 	if (all_devices != NULL)
@@ -65,40 +92,129 @@ void init_devices(struct td_device **_all_devices, uint32_t _all_devices_count)
 		}
 		dev->powerstate = PM_RUNNING;
 	}
+
+	lazy_mutex = mutex_create();
+	pm_wakelock_init(&lazy_wakelock);
+#ifdef CONFIG_DEVICE_RESUME_STATS
+	resume_stats = balloc(all_devices_count * sizeof(*resume_stats), NULL);
+	memset(resume_stats, 0, all_devices_count * sizeof(*resume_stats));
+#endif
 }
 
-static void resume_devices_from_index(uint32_t i)
+static int resume_device_index(uint32_t i)
 {
-	int ret = 0;
-	struct td_device *dev = NULL;
+	struct td_device *dev = all_devices[i];
+	int ret;
 
-	for (; i < all_devices_count; ++i) {
-		dev = all_devices[i];
+#ifdef CONFIG_DEVICE_RESUME_STATS
+	uint32_t start = get_uptime_32k();
+#endif
 
-		pr_debug(LOG_MODULE_DRV, "resume device %d", dev->id);
-		if (dev->powerstate <= PM_SHUTDOWN) {
-			ret = -EINVAL;
-			goto err_resume_device;
-		}
+	pr_debug(LOG_MODULE_DRV, "resume device %d", dev->id);
+	if (dev->powerstate <= PM_SHUTDOWN)
+		return -EINVAL;
 
-		if (dev->powerstate == PM_RUNNING)
-			/* Device already running */
-			continue;
+	if (dev->powerstate == PM_RUNNING)
+		/* Device already running */
+		return 0;
 
-		if (dev->driver->resume && (ret = dev->driver->resume(dev)))
-			goto err_resume_device;
+	if (dev->driver->resume && (ret = dev->driver->resume(dev)))
+		return ret;
 
-		/* Current device resumed */
-		dev->powerstate = PM_RUNNING;
-	}
+	/* Current device resumed */
+	dev->powerstate = PM_RUNNING;
 
-	return;
+#ifdef CONFIG_DEVICE_RESUME_STATS
+	struct resume_stats *stats = &resume_stats[i];
+	stats->last = get_uptime_32k() - start;
+	stats->total += stats->last;
+	if (stats->last > stats->max)
+		stats->max = stats->last;
+	stats->count++;
+#endif
+	return 0;
+}
 
-err_resume_device:
-	pr_error(LOG_MODULE_DRV, "failed to resume device %d (%d)", dev->id,
-		 ret);
+static void resume_failed(uint32_t i, int ret)
+{
+	pr_error(LOG_MODULE_DRV, "failed to resume device %d (%d)",
+		 all_devices[i]->id, ret);
 	log_flush();
-	panic(dev->id);
+	panic(all_devices[i]->id);
+}
+
+/* Resume the suspended lazy devices up to index last, included */
+static void resume_lazy_devices(uint32_t last)
+{
+	uint32_t i;
+	int ret;
+	/* The background resume may already hold the wakelock */
+	bool own_wakelock = !pm_wakelock_acquire(&lazy_wakelock);
+
+	for (i = 0; i <= last; ++i) {
+		if (all_devices[i]->lazy_resume &&
+		    (ret = resume_device_index(i)))
+			resume_failed(i, ret);
+	}
+	if (own_wakelock)
+		pm_wakelock_release(&lazy_wakelock);
+}
+
+#ifdef CONFIG_WORKQUEUE
+static void lazy_resume_work(void *data)
+{
+	mutex_lock(lazy_mutex, OS_WAIT_FOREVER);
+	resume_lazy_devices(all_devices_count - 1);
+	/* Taken by resume_devices_from_index() */
+	pm_wakelock_release(&lazy_wakelock);
+	mutex_unlock(lazy_mutex);
+}
+#endif
+
+/* Resume lazy devices in the background, without suspend meanwhile */
+static void start_lazy_resume(void)
+{
+#ifdef CONFIG_WORKQUEUE
+	if (!pm_wakelock_acquire(&lazy_wakelock) &&
+	    workqueue_queue_work(lazy_resume_work, NULL) != E_OS_OK)
+		pm_wakelock_release(&lazy_wakelock);
+#endif
+}
+
+void device_resume(struct td_device *dev)
+{
+	uint32_t i;
+
+	/* Nothing to do while running, or while devices are initialized */
+	if (dev->powerstate != PM_SUSPENDED)
+		return;
+
+	for (i = 0; i < all_devices_count && all_devices[i] != dev; ++i) ;
+	if (i == all_devices_count)
+		return;
+
+	mutex_lock(lazy_mutex, OS_WAIT_FOREVER);
+	resume_lazy_devices(i);
+	mutex_unlock(lazy_mutex);
+}
+
+static void resume_devices_from_index(uint32_t i)
+{
+	int ret = 0;
+	bool lazy = false;
+
+	for (; i < all_devices_count; ++i) {
+		if (all_devices[i]->lazy_resume &&
+		    all_devices[i]->powerstate == PM_SUSPENDED) {
+			lazy = true;
+			continue;
+		}
+		if ((ret = resume_device_index(i)))
+			resume_failed(i, ret);
+	}
+
+	if (lazy)
+		start_lazy_resume();
 }
 
 void resume_devices(void)
@@ -146,3 +262,39 @@ int suspend_devices(PM_POWERSTATE state)
 
 	return -1;
 }
+
+#ifdef CONFIG_DEVICE_RESUME_STATS
+#define TICKS_TO_US(t) ((uint32_t)(((uint64_t)(t) * 1000000) / 32768))
+
+/*
+ * Displays the resume durations of the devices: pm resume_stats
+ * One line per resumed device: id, resume count, last, longest and total
+ * resume durations in us, and 'L' if the device is resumed lazily.
+ *
+ * @param[in]   argc        Number of arguments in the Test Command (including group and name)
+ * @param[in]   argv        Table of null-terminated buffers containing the arguments
+ * @param[in]   ctx         The opaque context to pass to responses
+ */
+void pm_resume_stats(int argc, char **argv, struct tcmd_handler_ctx *ctx)
+{
+	char answer[64];
+	uint32_t i;
+
+	for (i = 0; i < all_devices_count; ++i) {
+		struct resume_stats *stats = &resume_stats[i];
+
+		if (!stats->count)
+			continue;
+		snprintf(answer, sizeof(answer), "%d %u %u %u %u%s",
+			 all_devices[i]->id, (unsigned int)stats->count,
+			 (unsigned int)TICKS_TO_US(stats->last),
+			 (unsigned int)TICKS_TO_US(stats->max),
+			 (unsigned int)TICKS_TO_US(stats->total),
+			 all_devices[i]->lazy_resume ? " L" : "");
+		TCMD_RSP_PROVISIONAL(ctx, answer);
+	}
+	TCMD_RSP_FINAL(ctx, NULL);
+}
+
+DECLARE_TEST_COMMAND_ENG(pm, resume_stats, pm_resume_stats);
+#endif
@@ -34,18 +34,26 @@
 #include "infra/log.h"
 #include <stdbool.h>
 #include <errno.h>
+#ifdef CONFIG_PM_WAKELOCK_STATS
+#include <stdio.h>
+#include "infra/time.h"
+#include "infra/tcmd/handler.h"
+#endif
 /*! Wakelock management structure */
 struct pm_wakelock_mgr {
-	list_head_t wl_list;  /*!< List that contains locked wakelocks */
+	uint32_t count;       /*!< Number of locked wakelocks */
 	T_TIMER wl_timer;     /*!< Timer to wait for next wakelock to expire */
 	uint8_t is_init;      /*!< Init state of wakelock structure */
 	void (*cb)(void *);   /*!< Callback function to call when wakelock list is empty */
 	void *cb_priv;        /*!< Argument to pass with the callback function */
+#ifdef CONFIG_PM_WAKELOCK_STATS
+	struct pm_wakelock *stats; /*!< Wakelocks with statistics */
+#endif
 };
 
 static volatile struct pm_wakelock_mgr pm_wakelock_inst = {
 	.is_init = 0,
-	.wl_list = { .head = NULL, .tail = NULL },
+	.count = 0,
 	.cb = NULL,
 	.cb_priv = NULL
 };
@@ -59,15 +67,37 @@ void pm_wakelock_init_mgr()
 // *        Wakelock user API        *
 // ***********************************
 
-void pm_wakelock_init(struct pm_wakelock *wli)
+void (pm_wakelock_init)(struct pm_wakelock *wli)
 {
 	wli->lock = 0;
-	wli->list.next = NULL;
+#ifdef CONFIG_PM_WAKELOCK_STATS
+	pm_wakelock_init_named(wli, NULL);
+#endif
 }
 
+#ifdef CONFIG_PM_WAKELOCK_STATS
+void pm_wakelock_init_named(struct pm_wakelock *wli, const char *name)
+{
+	struct pm_wakelock *wl;
+	uint32_t saved = irq_lock();
+
+	wli->lock = 0;
+	wli->name = name;
+	wli->acquire_count = 0;
+	wli->max_hold_time = 0;
+	wli->hold_time = 0;
+	// Record the wakelock once, even if initialized again
+	for (wl = pm_wakelock_inst.stats; wl && wl != wli; wl = wl->next) ;
+	if (!wl) {
+		wli->next = pm_wakelock_inst.stats;
+		pm_wakelock_inst.stats = wli;
+	}
+	irq_unlock(saved);
+}
+#endif
+
 int pm_wakelock_acquire(struct pm_wakelock *wl)
 {
-	list_t *l;
 	int ret = 0;
 	// Acquire wakelock
 	uint32_t saved = irq_lock();
@@ -79,19 +109,11 @@ int pm_wakelock_acquire(struct pm_wakelock *wl)
 	pm_wakelock_set_any_wakelock_taken_on_cpu(true);
 
 	wl->lock = 1;
-
-	if (!(l = pm_wakelock_inst.wl_list.head)) {
-		// List empty, add first item in the list
-		pm_wakelock_inst.wl_list.head = pm_wakelock_inst.wl_list.tail =
-							(list_t *)wl;
-		wl->list.next = NULL;
-	} else {
-		// Insert item  at the end of the list
-		for (; l->next; (l = l->next)) ;
-		pm_wakelock_inst.wl_list.tail = (list_t *)wl;
-		wl->list.next = l->next;
-		l->next = (list_t *)wl;
-	}
+	pm_wakelock_inst.count++;
+#ifdef CONFIG_PM_WAKELOCK_STATS
+	wl->acquire_time = get_uptime_32k();
+	wl->acquire_count++;
+#endif
 exit:
 	irq_unlock(saved);
 	return ret;
@@ -99,7 +121,6 @@ exit:
 
 int pm_wakelock_release(struct pm_wakelock *wl)
 {
-	list_t *l;
 	int ret = 0;
 
 	// Lock IRQs
@@ -112,37 +133,18 @@ int pm_wakelock_release(struct pm_wakelock *wl)
 	}
 	// Release wakelock
 	wl->lock = 0;
-	l = pm_wakelock_inst.wl_list.head;
-
-	if (l == (list_t *)wl) {
-		// Check if there is only one item in the wakelock list
-		if (pm_wakelock_inst.wl_list.tail == (list_t *)wl) {
-			pm_wakelock_inst.wl_list.head =
-				pm_wakelock_inst.wl_list.tail = NULL;
-			pm_wakelock_set_any_wakelock_taken_on_cpu(false);
-			// Call callback function to notify that all wakelocks are free
-			if (pm_wakelock_inst.cb != NULL) {
-				pm_wakelock_inst.cb(pm_wakelock_inst.cb_priv);
-			}
-		} else {
-			// release first item in the wakelock list
-			pm_wakelock_inst.wl_list.head = wl->list.next;
-		}
-	} else {
-		// Find wakelock in the list
-		for (; (l->next) && (l->next != (list_t *)wl); (l = l->next)) ;
-
-		if (l->next != NULL) {
-			// Item before wl found, remove wl item from the list
-			l->next = wl->list.next;
-
-			// Check if wl item is the last one in the list
-			if (pm_wakelock_inst.wl_list.tail == (list_t *)wl) {
-				pm_wakelock_inst.wl_list.tail = l;
-			}
-		} else {
-			//wl list clear
-			ret = -ENOENT;
+#ifdef CONFIG_PM_WAKELOCK_STATS
+	uint32_t held = get_uptime_32k() - wl->acquire_time;
+	wl->hold_time += held;
+	if (held > wl->max_hold_time)
+		wl->max_hold_time = held;
+#endif
+
+	if (!--pm_wakelock_inst.count) {
+		pm_wakelock_set_any_wakelock_taken_on_cpu(false);
+		// Call callback function to notify that all wakelocks are free
+		if (pm_wakelock_inst.cb != NULL) {
+			pm_wakelock_inst.cb(pm_wakelock_inst.cb_priv);
 		}
 	}
 exit:
@@ -152,7 +154,7 @@ exit:
 
 bool pm_wakelock_is_list_empty()
 {
-	return pm_wakelock_inst.wl_list.head == NULL ? true : false;
+	return pm_wakelock_inst.count == 0 ? true : false;
 }
 
 void pm_wakelock_set_list_empty_cb(void (*cb)(void *), void *priv)
@@ -166,3 +168,35 @@ void pm_wakelock_set_list_empty_cb(void (*cb)(void *), void *priv)
 
 	irq_unlock(saved);
 }
+
+#ifdef CONFIG_PM_WAKELOCK_STATS
+#define TICKS_TO_MS(t) ((uint32_t)(((uint64_t)(t) * 1000) / 32768))
+
+/*
+ * Displays the statistics of the wakelocks: pm wakelocks
+ * One line per wakelock: name, acquire count, total and longest hold time
+ * in ms, and '*' if currently held (the current hold is not accounted).
+ *
+ * @param[in]   argc        Number of arguments in the Test Command (including group and name)
+ * @param[in]   argv        Table of null-terminated buffers containing the arguments
+ * @param[in]   ctx         The opaque context to pass to responses
+ */
+void pm_wakelocks_tcmd(int argc, char **argv, struct tcmd_handler_ctx *ctx)
+{
+	struct pm_wakelock *wl;
+	char answer[80];
+
+	for (wl = pm_wakelock_inst.stats; wl; wl = wl->next) {
+		snprintf(answer, sizeof(answer), "%s@%p %u %u %u%s",
+			 wl->name ? wl->name : "", wl,
+			 (unsigned int)wl->acquire_count,
+			 (unsigned int)TICKS_TO_MS(wl->hold_time),
+			 (unsigned int)TICKS_TO_MS(wl->max_hold_time),
+			 wl->lock ? " *" : "");
+		TCMD_RSP_PROVISIONAL(ctx, answer);
+	}
+	TCMD_RSP_FINAL(ctx, NULL);
+}
+
+DECLARE_TEST_COMMAND_ENG(pm, wakelocks, pm_wakelocks_tcmd);
+#endif
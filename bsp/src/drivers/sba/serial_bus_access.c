@@ -46,9 +46,16 @@
 
 #include "machine.h"
 #include "drivers/clk_system.h"
+#include "infra/time.h"
+#ifdef CONFIG_SBA_STATS
+#include <stdio.h>
+#include "infra/tcmd/handler.h"
+#endif
 
 
 static DRIVER_API_RC execute_request(sba_request_t *request);
+static DRIVER_API_RC queue_chain(sba_request_t *	request,
+				 struct sba_device *	device);
 static DRIVER_API_RC sba_dev_init(struct td_device *	dev,
 				  union sba_config *	config);
 static DRIVER_API_RC sba_init(struct sba_master_cfg_data *sba_dev);
@@ -206,6 +213,69 @@ static int sba_resume(struct td_device *dev)
 	return 0;
 }
 
+#define MS_TO_32K(ms) (((uint32_t)(ms) << 15) / 1000)
+
+#ifdef CONFIG_SBA_STATS
+/* Devices that sent requests, for the statistics */
+static struct sba_device *stats_devices;
+
+static void account_delay(struct sba_delay_stats *stats, uint32_t delay)
+{
+	stats->count++;
+	stats->total += delay;
+	if (delay > stats->max)
+		stats->max = delay;
+}
+#endif
+
+/*
+ * Account a request leaving the queue, called with interrupts locked.
+ */
+static void account_request(struct sba_master_cfg_data *	sba_dev,
+			    sba_request_t *			request)
+{
+#ifdef CONFIG_SBA_STATS
+	uint32_t delay = get_uptime_32k() - request->queued;
+
+	account_delay(&sba_dev->stats, delay);
+	if (request->dev) {
+		if (!request->dev->stats.count) {
+			request->dev->stats_next = stats_devices;
+			stats_devices = request->dev;
+		}
+		account_delay(&request->dev->stats, delay);
+	}
+#endif
+}
+
+/*
+ * Get the next request to execute, called with interrupts locked.
+ * The requests past their deadline go first, earliest deadline first,
+ * then the requests of the highest priority class, in arrival order.
+ */
+static sba_request_t *next_request(struct sba_master_cfg_data *sba_dev)
+{
+	uint32_t now = get_uptime_32k();
+	sba_request_t *next = NULL;
+	list_t *l;
+
+	for (l = sba_dev->request_list.head; l; l = l->next) {
+		sba_request_t *r = (sba_request_t *)l;
+		bool late = r->deadline && (int32_t)(now - r->deadline) >= 0;
+		bool next_late = next && next->deadline &&
+				 (int32_t)(now - next->deadline) >= 0;
+
+		if (!next ||
+		    (late && (!next_late ||
+			      (int32_t)(r->deadline - next->deadline) < 0)) ||
+		    (!late && !next_late && r->priority > next->priority))
+			next = r;
+	}
+	if (next)
+		list_remove(&sba_dev->request_list, (list_t *)next);
+	return next;
+}
+
 struct driver serial_bus_access_driver = { .init = pm_sba_init,
 					   .suspend = sba_suspend,
 					   .resume = sba_resume };
@@ -239,14 +309,26 @@ static void sba_generic_callback(uint32_t bus_id, int8_t status)
 		panic(E_OS_ERR_UNKNOWN); // Panic because we should never reach this point.
 	} else {
 		sba_dev->current_request->status = status;
-		if (NULL != sba_dev->current_request->callback) {
-			sba_dev->current_request->callback(
-				sba_dev->current_request);
+
+		// Go on with the transaction, the callback is called at its end
+		if (!status && sba_dev->current_request->chain) {
+			sba_dev->current_request =
+				sba_dev->current_request->chain;
+			if (execute_request(sba_dev->current_request) ==
+			    DRV_RC_OK)
+				return;
+			status = sba_dev->current_request->status = -1;
 		}
 
-		if ((sba_dev->current_request =
-			     (sba_request_t *)list_get(&sba_dev->request_list))
-		    != NULL) {
+		sba_dev->current_chain->status = status;
+		if (NULL != sba_dev->current_chain->callback) {
+			sba_dev->current_chain->callback(
+				sba_dev->current_chain);
+		}
+
+		if ((sba_dev->current_request = sba_dev->current_chain =
+			     next_request(sba_dev)) != NULL) {
+			account_request(sba_dev, sba_dev->current_request);
 			rc = execute_request(sba_dev->current_request);
 			if (rc != DRV_RC_OK) {
 				sba_err_callback(bus_id);
@@ -428,7 +510,20 @@ DRIVER_API_RC sba_exec_dev_request(struct sba_device *	dev,
 	struct td_device *p_dev = dev->parent;
 
 	req->bus_id = ((struct sba_master_cfg_data *)p_dev->priv)->bus_id;
-	return sba_exec_request(req);
+	req->chain = NULL;
+	return queue_chain(req, dev);
+}
+
+DRIVER_API_RC sba_exec_dev_chain(struct sba_device *	dev,
+				 struct sba_request *	req)
+{
+	struct td_device *p_dev = dev->parent;
+	struct sba_request *r;
+
+	for (r = req; r; r = r->chain)
+		r->bus_id =
+			((struct sba_master_cfg_data *)p_dev->priv)->bus_id;
+	return queue_chain(req, dev);
 }
 
 /*! \fn     DRIVER_API_RC sba_exec_request (sba_request_t * request)
@@ -445,8 +540,37 @@ DRIVER_API_RC sba_exec_dev_request(struct sba_device *	dev,
  *           DRV_RC_FAIL                  otherwise
  */
 DRIVER_API_RC sba_exec_request(sba_request_t *request)
+{
+	request->chain = NULL;
+	return queue_chain(request, NULL);
+}
+
+/*! \fn     DRIVER_API_RC sba_exec_chain (sba_request_t * request)
+ *
+ *  \brief   Function to add a chain of requests in the requests list.
+ *           The chain is queued as a single request, the next requests of the
+ *           chain are executed from the completion interrupt of the previous
+ *           ones. Configuration parameters must be valid or an error is
+ *           returned - see return values below.
+ *
+ *  \param   request      : pointer to the first request of the chain
+ *
+ *  \return  DRV_RC_OK on success,
+ *           DRV_RC_INVALID_CONFIG        - if any configuration parameters are not valid
+ *           DRV_RC_INVALID_OPERATION     - if both Rx and Tx while it is not implemented
+ *           DRV_RC_CONTROLLER_IN_USE     - when device is busy
+ *           DRV_RC_FAIL                  otherwise
+ */
+DRIVER_API_RC sba_exec_chain(sba_request_t *request)
+{
+	return queue_chain(request, NULL);
+}
+
+static DRIVER_API_RC queue_chain(sba_request_t *request,
+				 struct sba_device *device)
 {
 	DRIVER_API_RC rc = DRV_RC_OK;
+	sba_request_t *r;
 
 	// Here we have to do a little hack to get the bus device.
 	// We keep in sba driver an array of all bus devices indexed by bus_id
@@ -465,13 +589,30 @@ DRIVER_API_RC sba_exec_request(sba_request_t *request)
 		return DRV_RC_FAIL;
 	}
 
+	// All the requests of a transaction go on the same bus
+	for (r = request->chain; r; r = r->chain) {
+		if (r->bus_id != request->bus_id) {
+			return DRV_RC_INVALID_CONFIG;
+		}
+	}
+
+	request->dev = device;
+	request->priority = device ? device->qos.priority : SBA_PRIO_NORMAL;
+	request->queued = get_uptime_32k();
+	request->deadline = 0;
+	if (device && device->qos.deadline)
+		// Never 0, which means no deadline
+		request->deadline = (request->queued +
+				     MS_TO_32K(device->qos.deadline)) | 1;
+
 	pm_wakelock_acquire(&sba_dev->sba_wakelock);
 
 	uint32_t saved = irq_lock();
 
 	sba_clock_enable(sba_dev);
 	if (sba_dev->current_request == NULL) {
-		sba_dev->current_request = request;
+		sba_dev->current_request = sba_dev->current_chain = request;
+		account_request(sba_dev, request);
 		irq_unlock(saved);
 		rc = execute_request(request);
 	} else {
@@ -665,3 +806,48 @@ static DRIVER_API_RC execute_request(sba_request_t *request)
 
 	return rc;
 }
+
+#ifdef CONFIG_SBA_STATS
+#define TICKS_TO_US(t) ((uint32_t)(((uint64_t)(t) * 1000000) >> 15))
+
+/*
+ * Displays the queueing delay of the SBA requests: sba delay
+ * One line per bus then per device: id, number of requests, average and
+ * longest queueing delays in us.
+ *
+ * @param[in]   argc        Number of arguments in the Test Command (including group and name)
+ * @param[in]   argv        Table of null-terminated buffers containing the arguments
+ * @param[in]   ctx         The opaque context to pass to responses
+ */
+void sba_delay(int argc, char **argv, struct tcmd_handler_ctx *ctx)
+{
+	char answer[48];
+	struct sba_delay_stats *stats;
+	struct sba_device *device;
+	unsigned int i;
+
+	for (i = 0; i < NB_BUS; i++) {
+		if (!sba_bus_device_array[i])
+			continue;
+		stats = &((struct sba_master_cfg_data *)
+			  sba_bus_device_array[i]->priv)->stats;
+		snprintf(answer, sizeof(answer), "bus %u: %u %u %u", i,
+			 (unsigned int)stats->count,
+			 stats->count ? (unsigned int)TICKS_TO_US(
+				 stats->total / stats->count) : 0,
+			 (unsigned int)TICKS_TO_US(stats->max));
+		TCMD_RSP_PROVISIONAL(ctx, answer);
+	}
+	for (device = stats_devices; device; device = device->stats_next) {
+		stats = &device->stats;
+		snprintf(answer, sizeof(answer), "dev %d: %u %u %u",
+			 device->dev.id, (unsigned int)stats->count,
+			 (unsigned int)TICKS_TO_US(stats->total / stats->count),
+			 (unsigned int)TICKS_TO_US(stats->max));
+		TCMD_RSP_PROVISIONAL(ctx, answer);
+	}
+	TCMD_RSP_FINAL(ctx, NULL);
+}
+
+DECLARE_TEST_COMMAND_ENG(sba, delay, sba_delay);
+#endif
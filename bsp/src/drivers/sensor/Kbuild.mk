@@ -4,3 +4,4 @@ obj-$(CONFIG_BMM150) += bmm150_support.o bmm150_drv.o
 obj-$(CONFIG_APDS9190) += apds9190.o
 obj-$(CONFIG_BME280) += bme280.o bme280_support.o bme280_bus.o bme280_drv.o
 obj-$(CONFIG_OHRM_DRIVER) += ohrm_bus.o ohrm_drv.o adxl362_support.o adxl362_bus.o
+obj-$(CONFIG_SENSOR_REPLAY) += sensor_replay.o
@@ -99,8 +99,11 @@ DRIVER_API_RC bmi160_config_bus(struct td_device *dev)
 				  SENSOR_BUS_TYPE_I2C, BMI160_REQ_NUM,
 				  SLEEP);
 #endif
-	if (bmi160_sba_info)
+	if (bmi160_sba_info) {
+		/* IMU samples are latency sensitive: use the device QoS */
+		bmi160_sba_info->sba_dev = sba_dev;
 		return DRV_RC_OK;
+	}
 	return DRV_RC_FAIL;
 }
 extern int bmi160_sensor_register(void);
@@ -129,7 +129,11 @@ DRIVER_API_RC sensor_bus_access(struct sensor_sba_info *info,
 	else
 		config_req_write(tx_buffer, tx_len, req);
 
-	if (sba_exec_request(req)) {
+	if (info->sba_dev)
+		ret = sba_exec_dev_request(info->sba_dev, req);
+	else
+		ret = sba_exec_request(req);
+	if (ret) {
 		pr_debug(LOG_MODULE_DRV, "%s:DEV[%d] request exec error",
 			 __func__,
 			 info->dev_id);
@@ -194,6 +198,7 @@ struct sensor_sba_info *sensor_config_bus(int slave_addr, uint8_t dev_id,
 	info->dev_id = dev_id;
 	info->bus_type = bus_type;
 	info->block_type = block_type;
+	info->sba_dev = NULL;
 
 	for (i = 0; i < req_num; i++) {
 		reqs[i].req.bus_id = bus_id;
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "machine.h"
+#include "os/os.h"
+#include "infra/device.h"
+#include "infra/tcmd/handler.h"
+#include "sensors/phy_sensor_api/phy_sensor_drv_api.h"
+#include "drivers/sensor/sensor_replay.h"
+
+/* Highest polling rate accepted, in 0.1Hz unit */
+#define SENSOR_REPLAY_MAX_ODR_X10 16000
+
+struct sensor_replay_drv_t {
+	struct phy_sensor_t sensor;
+	const uint8_t *frames;
+	uint16_t count;
+	uint16_t pos;
+	bool loop;
+	bool active;
+	uint32_t frames_read;
+	uint32_t underruns;
+	uint64_t first_us;
+	uint64_t last_us;
+};
+
+static int replay_open(struct phy_sensor_t *sensor)
+{
+	return DRV_RC_OK;
+}
+
+static void replay_close(struct phy_sensor_t *sensor)
+{
+	((struct sensor_replay_drv_t *)sensor)->active = false;
+}
+
+static int replay_activate(struct phy_sensor_t *sensor, bool enable)
+{
+	((struct sensor_replay_drv_t *)sensor)->active = enable;
+	return DRV_RC_OK;
+}
+
+static int replay_set_odr(struct phy_sensor_t *sensor, uint16_t odr_hz_x10)
+{
+	return odr_hz_x10 > SENSOR_REPLAY_MAX_ODR_X10 ? DRV_RC_FAIL : DRV_RC_OK;
+}
+
+static int replay_query_odr(struct phy_sensor_t *sensor, uint16_t odr_target,
+			    uint16_t *odr_support)
+{
+	/* Frames are returned on demand: any polling rate is supported */
+	*odr_support = odr_target < SENSOR_REPLAY_MAX_ODR_X10 ?
+		       odr_target : SENSOR_REPLAY_MAX_ODR_X10;
+	return DRV_RC_OK;
+}
+
+static int replay_read(struct phy_sensor_t *sensor, uint8_t *buffer,
+		       uint16_t buff_len)
+{
+	struct sensor_replay_drv_t *replay = (struct sensor_replay_drv_t *)sensor;
+	uint8_t len = sensor->raw_data_len;
+	uint64_t now = get_time_us();
+	uint32_t saved = irq_lock();
+
+	if (buff_len < len || !replay->frames) {
+		irq_unlock(saved);
+		return 0;
+	}
+	if (replay->pos >= replay->count) {
+		if (!replay->loop) {
+			replay->underruns++;
+			irq_unlock(saved);
+			return 0;
+		}
+		replay->pos = 0;
+	}
+	memcpy(buffer, replay->frames + replay->pos * len, len);
+	replay->pos++;
+	if (!replay->frames_read++)
+		replay->first_us = now;
+	replay->last_us = now;
+	irq_unlock(saved);
+
+	return len;
+}
+
+#define SENSOR_REPLAY(_type, _frame)					     \
+	{								     \
+		.sensor = {						     \
+			.type = _type,					     \
+			.raw_data_len = sizeof(_frame),			     \
+			.hw_raw_data_len = sizeof(_frame),		     \
+			.report_mode_mask = PHY_SENSOR_REPORT_MODE_POLL_REG_MASK, \
+			.api = {					     \
+				.open = replay_open,			     \
+				.close = replay_close,			     \
+				.activate = replay_activate,		     \
+				.set_odr = replay_set_odr,		     \
+				.query_odr = replay_query_odr,		     \
+				.read = replay_read,			     \
+			},						     \
+		},							     \
+	}
+
+static struct sensor_replay_drv_t replay_sensors[SENSOR_REPLAY_COUNT] = {
+	[SENSOR_REPLAY_ACCEL] =
+		SENSOR_REPLAY(SENSOR_ACCELEROMETER, phy_accel_data_t),
+	[SENSOR_REPLAY_GYRO] =
+		SENSOR_REPLAY(SENSOR_GYROSCOPE, phy_gyro_data_t),
+	[SENSOR_REPLAY_MAG] =
+		SENSOR_REPLAY(SENSOR_MAGNETOMETER, phy_mag_data_t),
+};
+
+static void replay_reset(struct sensor_replay_drv_t *replay)
+{
+	replay->pos = 0;
+	replay->frames_read = 0;
+	replay->underruns = 0;
+	replay->first_us = replay->last_us = 0;
+}
+
+int sensor_replay_load(enum sensor_replay_id id, const void *frames,
+		       uint16_t count, bool loop)
+{
+	struct sensor_replay_drv_t *replay;
+	uint32_t saved;
+
+	if (id >= SENSOR_REPLAY_COUNT || (frames && !count))
+		return DRV_RC_INVALID_CONFIG;
+
+	replay = &replay_sensors[id];
+	saved = irq_lock();
+	replay->frames = frames;
+	replay->count = frames ? count : 0;
+	replay->loop = loop;
+	replay_reset(replay);
+	irq_unlock(saved);
+
+	return DRV_RC_OK;
+}
+
+int sensor_replay_get_stats(enum sensor_replay_id id,
+			    struct sensor_replay_stats *stats)
+{
+	struct sensor_replay_drv_t *replay;
+	uint32_t saved;
+
+	if (id >= SENSOR_REPLAY_COUNT || !stats)
+		return DRV_RC_INVALID_CONFIG;
+
+	replay = &replay_sensors[id];
+	saved = irq_lock();
+	stats->frames = replay->frames_read;
+	stats->underruns = replay->underruns;
+	stats->elapsed_us = (uint32_t)(replay->last_us - replay->first_us);
+	stats->pos = replay->pos;
+	stats->count = replay->count;
+	irq_unlock(saved);
+
+	return DRV_RC_OK;
+}
+
+void sensor_replay_rewind(enum sensor_replay_id id)
+{
+	uint32_t saved;
+
+	if (id >= SENSOR_REPLAY_COUNT)
+		return;
+
+	saved = irq_lock();
+	replay_reset(&replay_sensors[id]);
+	irq_unlock(saved);
+}
+
+uint8_t sensor_replay_dev_id(uint8_t type)
+{
+	int i;
+
+	for (i = 0; i < SENSOR_REPLAY_COUNT; i++)
+		if (replay_sensors[i].sensor.type == type)
+			return replay_sensors[i].sensor.dev_id;
+	return 0;
+}
+
+static int sensor_replay_init(struct td_device *dev)
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < SENSOR_REPLAY_COUNT; i++)
+		ret += sensor_register(&replay_sensors[i].sensor);
+
+	return ret ? DRV_RC_FAIL : DRV_RC_OK;
+}
+
+struct driver sensor_replay_driver = {
+	.init = sensor_replay_init,
+};
+
+#ifdef CONFIG_SENSOR_REPLAY_TCMD
+static const char *const replay_names[SENSOR_REPLAY_COUNT] = {
+	"accel", "gyro", "mag"
+};
+
+/*
+ * Display the replay statistics of each sensor.
+ *
+ * Replay frames per second are computed between the first and the last
+ * frame returned, so they reflect the rate the sensor core polled at.
+ *
+ * @param[in]   argc        Number of arguments in the Test Command (including group and name)
+ * @param[in]   argv        Table of null-terminated buffers containing the arguments
+ * @param[in]   ctx         The context to pass back to responses
+ */
+void sensor_replay_stats_tcmd(int argc, char *argv[],
+			      struct tcmd_handler_ctx *ctx)
+{
+	struct sensor_replay_stats stats;
+	char buf[80];
+	int i;
+
+	for (i = 0; i < SENSOR_REPLAY_COUNT; i++) {
+		uint32_t rate = 0;
+
+		sensor_replay_get_stats(i, &stats);
+		if (stats.frames > 1 && stats.elapsed_us)
+			rate = (uint32_t)((uint64_t)(stats.frames - 1) *
+					  1000000 / stats.elapsed_us);
+		snprintf(buf, sizeof(buf), "%s %u/%u frames:%u underruns:%u fps:%u",
+			 replay_names[i], stats.pos, stats.count,
+			 (unsigned int)stats.frames,
+			 (unsigned int)stats.underruns, (unsigned int)rate);
+		TCMD_RSP_PROVISIONAL(ctx, buf);
+	}
+	TCMD_RSP_FINAL(ctx, NULL);
+}
+DECLARE_TEST_COMMAND_ENG(replay, stats, sensor_replay_stats_tcmd);
+
+/*
+ * Rewind all the replay sensors to the start of their trace.
+ *
+ * @param[in]   argc        Number of arguments in the Test Command (including group and name)
+ * @param[in]   argv        Table of null-terminated buffers containing the arguments
+ * @param[in]   ctx         The context to pass back to responses
+ */
+void sensor_replay_rewind_tcmd(int argc, char *argv[],
+			       struct tcmd_handler_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < SENSOR_REPLAY_COUNT; i++)
+		sensor_replay_rewind(i);
+	TCMD_RSP_FINAL(ctx, NULL);
+}
+DECLARE_TEST_COMMAND_ENG(replay, rewind, sensor_replay_rewind_tcmd);
+#endif
@@ -36,6 +36,10 @@
 #include "util/list.h"
 #include "usb.h"
 #include "usb_driver_interface.h"
+#ifdef CONFIG_USB_ACM_STREAM_TCMD
+#include <stdlib.h>
+#include "infra/tcmd/handler.h"
+#endif
 
 #define MAX_OUT_XFER 64
 
@@ -414,8 +418,17 @@ struct acm_request {
 	uint8_t direction;
 	uint8_t ep;
 	uint8_t channel;
+	bool in_use;
+	uint8_t *buf;
+	int len;
+	/* bytes of the previous segments of a scatter write */
+	int offset;
 };
 
+/* Requests are taken from fixed pools instead of being allocated per
+ * transfer */
+static struct acm_request acm_reqs[NUM_ACM_CHANNELS][2][CONFIG_USB_ACM_REQS];
+
 
 list_head_t acm_read_requests[NUM_ACM_CHANNELS];
 list_head_t acm_write_requests[NUM_ACM_CHANNELS];
@@ -475,6 +488,54 @@ static int acm_class_handler(usb_device_request_t *pSetup, uint32_t *piLen,
 }
 
 
+static struct acm_request *acm_req_get(int idx, int direction)
+{
+	struct acm_request *req = NULL;
+	uint32_t flags = irq_lock();
+	int i;
+
+	for (i = 0; i < CONFIG_USB_ACM_REQS; i++) {
+		if (!acm_reqs[idx][direction][i].in_use) {
+			req = &acm_reqs[idx][direction][i];
+			req->in_use = true;
+			break;
+		}
+	}
+	irq_unlock(flags);
+	return req;
+}
+
+static void acm_req_put(struct acm_request *req)
+{
+	req->in_use = false;
+}
+
+/* Submit the oldest queued read of a channel, only one read is given to
+ * the controller at a time */
+static int acm_submit_read(int idx)
+{
+	struct acm_request *req;
+	uint32_t flags;
+	int ret = 0;
+
+	while (1) {
+		flags = irq_lock();
+		req = (struct acm_request *)acm_read_requests[idx].head;
+		if (!req || req->state != STATE_READY) {
+			irq_unlock(flags);
+			return ret;
+		}
+		req->state = STATE_PENDING;
+		irq_unlock(flags);
+		ret = usb_ep_read(req->ep, req->buf, req->len, req);
+		if (!ret)
+			return 0;
+		/* read failed, drop the request and try the next one */
+		list_remove(&acm_read_requests[idx], &req->list);
+		acm_req_put(req);
+	}
+}
+
 static void acm_ep_complete(int ep_address, void *priv, int status, int actual)
 {
 	struct acm_request *req = (struct acm_request *)priv;
@@ -486,20 +547,22 @@ static void acm_ep_complete(int ep_address, void *priv, int status, int actual)
 		if (req->direction == DIRECTION_READ) {
 			list_remove(&acm_read_requests[req->channel],
 				    &req->list);
+			/* Arm the next queued read right away */
+			acm_submit_read(req->channel);
 		} else {
 			list_remove(&acm_write_requests[req->channel],
 				    &req->list);
 		}
-	}
-
-	if (req && req->xfer_done) {
 		req->state = STATE_READY;
-		if (!status) {
-			req->xfer_done(actual, req->data);
-		} else {
-			pr_debug(LOG_MODULE_USB, "status: %d", status);
+		if (req->xfer_done) {
+			if (!status) {
+				req->xfer_done(req->offset + actual,
+					       req->data);
+			} else {
+				pr_debug(LOG_MODULE_USB, "status: %d", status);
+			}
 		}
-		bfree(req);
+		acm_req_put(req);
 		return;
 	}
 
@@ -577,28 +640,36 @@ static void acm_event_handler(struct usb_event *event)
 int acm_read(int idx, uint8_t *buffer, int len,
 	     void (*xfer_done)(int actual, void *data), void *data)
 {
-	int ret;
+	struct acm_request *req = acm_req_get(idx, DIRECTION_READ);
 
-	if (!list_empty(&acm_read_requests[idx])) {
+	if (!req)
 		return DRV_RC_BUSY;
-	}
-	struct acm_request *req = (struct acm_request *)balloc(sizeof(*req),
-							       NULL);
-	int flags = irq_lock();
 	req->state = STATE_READY;
 	req->direction = DIRECTION_READ;
 	req->channel = idx;
-	list_add(&acm_read_requests[idx], &req->list);
-	irq_unlock(flags);
 	req->xfer_done = xfer_done;
 	req->data = data;
 	req->ep = (idx == 0) ? 1 : 2;
-	ret = usb_ep_read(req->ep, buffer,
-			  len, req);
+	req->buf = buffer;
+	req->len = len;
+	req->offset = 0;
+	/* Queued reads are armed one after the other from the completion
+	 * interrupt */
+	list_add(&acm_read_requests[idx], &req->list);
+	return acm_submit_read(idx);
+}
+
+static int acm_submit_write(struct acm_request *req)
+{
+	int ret;
+
+	req->state = STATE_PENDING;
+	list_add(&acm_write_requests[req->channel], &req->list);
+	ret = usb_ep_write(req->ep, req->buf, req->len, req);
 	if (ret) {
-		/* read failed, remove the request from list */
-		list_remove(&acm_read_requests[idx], &req->list);
-		bfree(req);
+		/* write failed, remove the request from list */
+		list_remove(&acm_write_requests[req->channel], &req->list);
+		acm_req_put(req);
 	}
 	return ret;
 }
@@ -606,25 +677,50 @@ int acm_read(int idx, uint8_t *buffer, int len,
 int acm_write(int idx, uint8_t *buffer, int len,
 	      void (*xfer_done)(int actual, void *data), void *data)
 {
-	struct acm_request *req = (struct acm_request *)balloc(sizeof(*req),
-							       NULL);
-	int flags = irq_lock();
-	int ret;
+	struct acm_sg sg = { .buf = buffer, .len = len };
 
-	req->state = STATE_READY;
-	req->direction = DIRECTION_WRITE;
-	req->channel = idx;
-	list_add(&acm_write_requests[idx], &req->list);
-	irq_unlock(flags);
-	req->xfer_done = xfer_done;
-	req->data = data;
-	req->ep = (idx == 0) ? 0x82 : 0x84;
-	ret = usb_ep_write(req->ep, buffer,
-			   len, req);
-	if (ret) {
-		/* write failed, remove the request from list */
-		list_remove(&acm_write_requests[idx], &req->list);
-		bfree(req);
+	return acm_write_sg(idx, &sg, 1, xfer_done, data);
+}
+
+int acm_write_sg(int idx, const struct acm_sg *sg, int count,
+		 void (*xfer_done)(int actual, void *data), void *data)
+{
+	struct acm_request *reqs[CONFIG_USB_ACM_REQS];
+	int i, offset = 0, ret = 0;
+
+	if (count <= 0 || count > CONFIG_USB_ACM_REQS)
+		return DRV_RC_INVALID_CONFIG;
+
+	/* Reserve all the requests first so that a segment list is either
+	 * fully queued or refused */
+	for (i = 0; i < count; i++) {
+		reqs[i] = acm_req_get(idx, DIRECTION_WRITE);
+		if (!reqs[i]) {
+			while (i--)
+				acm_req_put(reqs[i]);
+			return DRV_RC_BUSY;
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		struct acm_request *req = reqs[i];
+		bool last = (i == count - 1);
+
+		req->direction = DIRECTION_WRITE;
+		req->channel = idx;
+		req->ep = (idx == 0) ? 0x82 : 0x84;
+		req->buf = sg[i].buf;
+		req->len = sg[i].len;
+		/* Only the last segment reports the whole transfer */
+		req->xfer_done = last ? xfer_done : NULL;
+		req->data = data;
+		req->offset = offset;
+		offset += sg[i].len;
+		if (ret) {
+			acm_req_put(req);
+			continue;
+		}
+		ret = acm_submit_write(req);
 	}
 	return ret;
 }
@@ -648,6 +744,82 @@ int acm_init(int idx, void (*event_cb)(int, int))
 	return 0;
 }
 
+#ifdef CONFIG_USB_ACM_STREAM_TCMD
+/* Two buffers of two segments each are kept in flight */
+#define ACM_STREAM_BUF 512
+
+static struct {
+	uint32_t buf[2][ACM_STREAM_BUF / 4];
+	uint32_t next;  /* next counter value */
+	uint32_t left;  /* counter values not queued yet */
+	int idx;
+} acm_stream;
+
+static void acm_stream_send(int b);
+
+static void acm_stream_done(int actual, void *data)
+{
+	if (acm_stream.left)
+		acm_stream_send((int)data);
+}
+
+static void acm_stream_send(int b)
+{
+	struct acm_sg sg[2];
+	uint32_t n = acm_stream.left;
+	uint32_t i;
+	int len;
+
+	if (n > ACM_STREAM_BUF / 4)
+		n = ACM_STREAM_BUF / 4;
+	for (i = 0; i < n; i++)
+		acm_stream.buf[b][i] = acm_stream.next++;
+	acm_stream.left -= n;
+
+	len = n * 4;
+	sg[0].buf = (uint8_t *)acm_stream.buf[b];
+	sg[0].len = len > ACM_STREAM_BUF / 2 ? ACM_STREAM_BUF / 2 : len;
+	sg[1].buf = sg[0].buf + sg[0].len;
+	sg[1].len = len - sg[0].len;
+	if (acm_write_sg(acm_stream.idx, sg, sg[1].len ? 2 : 1,
+			 acm_stream_done, (void *)b)) {
+		pr_error(LOG_MODULE_USB, "acm stream aborted");
+		acm_stream.left = 0;
+	}
+}
+
+/*
+ * Send <bytes> bytes of an incrementing 32 bits counter on an ACM channel.
+ *
+ * usb acm_stream <idx> <bytes>
+ */
+void acm_stream_tcmd(int argc, char *argv[], struct tcmd_handler_ctx *ctx)
+{
+	uint32_t flags;
+
+	if (argc != 4 || acm_stream.left) {
+		TCMD_RSP_ERROR(ctx, NULL);
+		return;
+	}
+	acm_stream.idx = atoi(argv[2]);
+	if (acm_stream.idx >= NUM_ACM_CHANNELS) {
+		TCMD_RSP_ERROR(ctx, NULL);
+		return;
+	}
+	acm_stream.next = 0;
+	acm_stream.left = strtoul(argv[3], NULL, 0) / 4;
+	TCMD_RSP_FINAL(ctx, NULL);
+	/* The completion interrupt refills the buffers */
+	flags = irq_lock();
+	acm_stream_send(0);
+	if (acm_stream.left)
+		acm_stream_send(1);
+	irq_unlock(flags);
+}
+
+DECLARE_TEST_COMMAND_ENG(usb, acm_stream, acm_stream_tcmd);
+#endif
+
 #define ACM_EP0_BUF_SZ 128
 static uint8_t ep0_buffer[ACM_EP0_BUF_SZ];
 
@@ -58,9 +58,10 @@ static bool active_backend[ARRAY_SIZE(console_backend)];
 
 static void multi_backend_puts(const char *s, uint16_t len);
 static bool is_multi_backend_ready();
+static void multi_backend_flush(void);
 
 struct log_backend log_backend_multi =
-{ multi_backend_puts, is_multi_backend_ready };
+{ multi_backend_puts, is_multi_backend_ready, multi_backend_flush };
 
 int console_manager_activate_log_backend(const char *	console_name,
 					 bool		activate)
@@ -106,6 +107,17 @@ static bool is_multi_backend_ready()
 	return false;
 }
 
+static void multi_backend_flush(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < no_of_backends; i++) {
+		if (active_backend[i] &&
+		    console_backend[i]->log_backend->flush)
+			console_backend[i]->log_backend->flush();
+	}
+}
+
 void console_manager_init(void)
 {
 	uint8_t i;
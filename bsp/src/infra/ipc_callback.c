@@ -86,6 +86,15 @@ int ipc_sync_callback(uint8_t cpu_id, int request, int param1, int param2,
 	case IPC_MSG_TYPE_FREE:
 		message_free(ptr);
 		break;
+	case IPC_MSG_TYPE_FREE_BATCH:
+	{
+		struct message **msgs = ptr;
+		int i;
+
+		for (i = 0; i < param1; i++)
+			message_free(msgs[i]);
+		break;
+	}
 	case IPC_MSG_TYPE_MESSAGE:
 		ret = port_send_message((struct message *)ptr);
 		break;
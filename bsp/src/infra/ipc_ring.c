@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "infra/ipc_ring.h"
+
+/*
+ * The producer publishes an entry, then reads the doorbell; the consumer arms
+ * the doorbell, then reads the head. Both sequences need a full barrier on
+ * cores that can reorder a store with a following load (x86).
+ */
+#if defined(__i386__) || defined(__x86_64__)
+#define ipc_ring_barrier() __sync_synchronize()
+#else
+#define ipc_ring_barrier() __asm__ __volatile__ ("" ::: "memory")
+#endif
+
+void ipc_ring_init(struct ipc_ring *ring)
+{
+	ring->head = 0;
+	ring->tail = 0;
+	ring->doorbell = 1;
+	ring->ready = 0;
+	ring->mask = IPC_RING_SIZE - 1;
+}
+
+void ipc_ring_set_ready(struct ipc_ring *ring)
+{
+	ipc_ring_barrier();
+	ring->ready = 1;
+}
+
+int ipc_ring_push(struct ipc_ring *ring, uint32_t entry)
+{
+	uint32_t head = ring->head;
+
+	if (head - ring->tail > ring->mask)
+		return -1;
+	ring->entries[head & ring->mask] = entry;
+	/* The entry must be visible before the new head */
+	ipc_ring_barrier();
+	ring->head = head + 1;
+	return 0;
+}
+
+bool ipc_ring_take_doorbell(struct ipc_ring *ring)
+{
+	ipc_ring_barrier();
+	if (!ring->doorbell)
+		return false;
+	ring->doorbell = 0;
+	return true;
+}
+
+int ipc_ring_pop(struct ipc_ring *ring, uint32_t *entry)
+{
+	uint32_t tail = ring->tail;
+
+	if (tail == ring->head)
+		return -1;
+	ipc_ring_barrier();
+	*entry = ring->entries[tail & ring->mask];
+	/* The entry must be read before the slot is released */
+	ipc_ring_barrier();
+	ring->tail = tail + 1;
+	return 0;
+}
+
+bool ipc_ring_arm_doorbell(struct ipc_ring *ring)
+{
+	ring->doorbell = 1;
+	ipc_ring_barrier();
+	return ring->tail != ring->head;
+}
@@ -94,7 +94,7 @@ uint8_t cpu_id_to_logcore_id(uint8_t cpu_id)
 #if defined(CONFIG_LOG_MASTER) || !defined(CONFIG_LOG_MULTI_CPU_SUPPORT)
 
 /* The backend used to actually ouput text */
-static struct log_backend out_backend = { NULL, NULL };
+static struct log_backend out_backend = { NULL, NULL, NULL };
 
 void log_set_backend(struct log_backend backend)
 {
@@ -110,6 +110,12 @@ bool log_check_backend(void)
 	return true;
 }
 
+void log_flush_backend(void)
+{
+	if (out_backend.flush)
+		out_backend.flush();
+}
+
 /* Output one message on the backend */
 void output_one_message(const log_message_t *msg)
 {
@@ -88,6 +88,11 @@ typedef struct __packed log_message {
 void output_one_message(const log_message_t *msg);
 
 bool log_check_backend(void);
+
+/**
+ * Write out the text buffered by the backend, if any.
+ */
+void log_flush_backend(void);
 #endif
 
 #ifdef CONFIG_LOG_MASTER
@@ -137,6 +137,7 @@ void log_flush()
 		return;
 	while (log_read_msg(&msg) > 0)
 		output_one_message(&msg);
+	log_flush_backend();
 }
 
 /* Logger task. Should be lower prio than any other tasks that send messages. */
@@ -278,6 +279,7 @@ static void log_task(void)
 void log_flush()
 {
 	log_extract_messages();
+	log_flush_backend();
 }
 
 #endif
@@ -53,6 +53,10 @@
 /* Time */
 #include "infra/time.h"
 
+#ifdef CONFIG_SYSTEM_EVENTS_STAGING
+#include "util/workqueue.h"
+#endif
+
 /* TODO: Use the commonly defined constant instead */
 #define PANIC_NVM_BASE (DEBUGPANIC_START_BLOCK * EMBEDDED_FLASH_BLOCK_SIZE)
 
@@ -69,12 +73,37 @@ static xloop_t *storage_loop = NULL;
 
 static void store_panics(uint32_t);
 
+#ifdef CONFIG_SYSTEM_EVENTS_STAGING
+/*
+ * Staging ring of the pushed events.
+ *
+ * Events are copied in RAM and written to the circular storage in batches:
+ * when the ring is full, CONFIG_SYSTEM_EVENTS_FLUSH_DELAY ms after the first
+ * staged event, or right away for the panic and shutdown events.
+ */
+static uint8_t staged[CONFIG_SYSTEM_EVENTS_STAGING_SIZE][SYSTEM_EVENT_SIZE];
+static uint8_t staged_head;
+static uint8_t staged_count;
+static T_MUTEX flush_mutex;
+static T_TIMER flush_timer;
+
+static void system_events_flush_timeout(void *data);
+#endif
+
 void system_events_init()
 {
 	struct device *rtc_dev;
 
 	BUILD_BUG_ON(sizeof(struct system_event) > SYSTEM_EVENT_SIZE);
 
+#ifdef CONFIG_SYSTEM_EVENTS_STAGING
+	flush_mutex = mutex_create();
+	flush_timer = timer_create(system_events_flush_timeout, NULL,
+				   CONFIG_SYSTEM_EVENTS_FLUSH_DELAY, false,
+				   false, NULL);
+	assert(flush_mutex && flush_timer);
+#endif
+
 	rtc_dev = device_get_binding(RTC_DRV_NAME);
 	assert(rtc_dev != NULL);
 	storage = cir_storage_flash_spi_init(SYSTEM_EVENT_SIZE,
@@ -111,11 +140,85 @@ void system_event_write_job(xloop_job_t *job)
 	bfree(job);
 }
 
+#ifdef CONFIG_SYSTEM_EVENTS_STAGING
+void system_events_flush(void)
+{
+	uint8_t evt[SYSTEM_EVENT_SIZE];
+	uint32_t flags;
+
+	if (!storage)
+		return;
+
+	mutex_lock(flush_mutex, OS_WAIT_FOREVER);
+	while (1) {
+		flags = irq_lock();
+		if (!staged_count) {
+			irq_unlock(flags);
+			break;
+		}
+		memcpy(evt, staged[staged_head], SYSTEM_EVENT_SIZE);
+		staged_head = (staged_head + 1) %
+			      CONFIG_SYSTEM_EVENTS_STAGING_SIZE;
+		staged_count--;
+		irq_unlock(flags);
+
+		cir_storage_push(storage, evt);
+		on_system_event_generated((struct system_event *)evt);
+	}
+	mutex_unlock(flush_mutex);
+}
+
+static void system_events_flush_work(void *data)
+{
+	system_events_flush();
+}
+
+static void system_events_flush_timeout(void *data)
+{
+	workqueue_queue_work(system_events_flush_work, NULL);
+}
+
+/* Copy an event into the staging ring, return the staged count, 0 if full */
+static int system_event_stage(struct system_event *event)
+{
+	uint32_t flags = irq_lock();
+	int count = 0;
+
+	if (staged_count < CONFIG_SYSTEM_EVENTS_STAGING_SIZE) {
+		uint8_t *slot = staged[(staged_head + staged_count) %
+				       CONFIG_SYSTEM_EVENTS_STAGING_SIZE];
+		memcpy(slot, event, sizeof(*event));
+		memset(slot + sizeof(*event), 0,
+		       SYSTEM_EVENT_SIZE - sizeof(*event));
+		count = ++staged_count;
+	}
+	irq_unlock(flags);
+	return count;
+}
+#endif
+
 void system_event_push(struct system_event *event)
 {
 	if (storage && enabled) {
 		memcpy(event->h.hash, version_header.hash,
 		       sizeof(event->h.hash));
+#ifdef CONFIG_SYSTEM_EVENTS_STAGING
+		int count;
+
+		/* Make room in the calling context when the ring is full */
+		while (!(count = system_event_stage(event)))
+			system_events_flush();
+
+		/* The platform is about to stop, do not wait */
+		if (event->h.type == SYSTEM_EVENT_TYPE_PANIC ||
+		    event->h.type == SYSTEM_EVENT_TYPE_SHUTDOWN) {
+			timer_stop(flush_timer);
+			system_events_flush();
+		} else if (count == 1) {
+			timer_start(flush_timer,
+				    CONFIG_SYSTEM_EVENTS_FLUSH_DELAY, NULL);
+		}
+#else
 		if (storage_loop && storage_loop->queue) {
 			struct se_job *job = (struct se_job *)
 					     balloc(
@@ -129,6 +232,7 @@ void system_event_push(struct system_event *event)
 			cir_storage_push(storage, (uint8_t *)event);
 			on_system_event_generated(event);
 		}
+#endif
 	}
 }
 
@@ -136,8 +240,7 @@ struct system_event *system_event_pop()
 {
 	if (storage) {
 		struct system_event *evt = balloc(SYSTEM_EVENT_SIZE, NULL);
-		cir_storage_err_t err = cir_storage_pop(storage, (uint8_t *)evt);
-		if (err == CBUFFER_STORAGE_SUCCESS)
+		if (system_event_pop_bulk((uint8_t *)evt, 1))
 			return evt;
 		else {
 			bfree(evt);
@@ -148,6 +251,24 @@ struct system_event *system_event_pop()
 	}
 }
 
+int system_event_pop_bulk(uint8_t *evts, int count)
+{
+	int i;
+
+	if (!storage)
+		return 0;
+
+#ifdef CONFIG_SYSTEM_EVENTS_STAGING
+	/* Staged events are the most recent ones */
+	system_events_flush();
+#endif
+	for (i = 0; i < count; i++)
+		if (cir_storage_pop(storage, evts + i * SYSTEM_EVENT_SIZE) !=
+		    CBUFFER_STORAGE_SUCCESS)
+			break;
+	return i;
+}
+
 static bool prepare_crash_event_to_store(
 	struct system_event *event_to_store,
 	struct panic_data_flash_header *
@@ -363,6 +484,9 @@ void __attribute__((weak)) project_dump_event(struct system_event *	event,
 {
 }
 
+/* Number of events popped at once */
+#define DUMP_BATCH 4
+
 void dump_events(int argc, char **argv, struct tcmd_handler_ctx *ctx)
 {
 	static const char *type_string[] = {
@@ -379,11 +503,15 @@ void dump_events(int argc, char **argv, struct tcmd_handler_ctx *ctx)
 		"BUTTON",
 	};
 
+	uint8_t *evts = balloc(DUMP_BATCH * SYSTEM_EVENT_SIZE, NULL);
 	struct system_event *evt;
+	int count, i;
 
 	do {
-		evt = system_event_pop();
-		if (evt) {
+		count = system_event_pop_bulk(evts, DUMP_BATCH);
+		for (i = 0; i < count; i++) {
+			evt = (struct system_event *)
+			      (evts + i * SYSTEM_EVENT_SIZE);
 			if (evt->h.type < SYSTEM_EVENT_USER_RANGE_START) {
 #define TMP_BUF_SZ 80
 				/* *INDENT-OFF* */
@@ -457,9 +585,9 @@ void dump_events(int argc, char **argv, struct tcmd_handler_ctx *ctx)
 			} else {
 				project_dump_event(evt, ctx);
 			}
-			bfree(evt);
 		}
-	} while (evt);
+	} while (count == DUMP_BATCH);
+	bfree(evts);
 	TCMD_RSP_FINAL(ctx, NULL);
 }
 
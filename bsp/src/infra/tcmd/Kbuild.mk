@@ -1,4 +1,5 @@
 obj-y += engine.o
+obj-y += lookup.o
 obj-$(CONFIG_TCMD_ASYNC) += async.o
 obj-$(CONFIG_TCMD_MASTER) += master.o
 obj-$(CONFIG_TCMD_SLAVE) += slave.o
@@ -37,6 +37,8 @@
 #include "infra/tcmd/engine.h"
 #include "infra/tcmd/handler.h"
 
+#include "lookup.h"
+
 /** Start address of the code section dedicated to test command handlers **/
 extern const struct tcmd_handler __test_cmds_start[];
 /** End address of the code section dedicated to test command handlers **/
@@ -68,46 +70,6 @@ struct tcmd_context {
 
 /** Private functions **/
 
-/**
- * Find a command handler for the specified group and command name
- *
- * We go through the ordered list of registered test commands that have
- * been put by the linker in a specific section identified by start and
- * end addresses.
- *
- * @param group the command group
- * @param name the command name
- *
- * @return a pointer to a test command handler struct or NULL
- *
- */
-static const struct tcmd_handler *find_command(const char *	group,
-					       const char *	name)
-{
-	const struct tcmd_handler *cmd = __test_cmds_start;
-	const struct tcmd_handler *result = NULL;
-	int grp_len = strlen(group);
-	int name_len = strlen(name);
-	bool exact_match = false;
-
-	while ((!result || !exact_match) && (cmd < __test_cmds_end)) {
-		if ((strncmp(group, cmd->group, grp_len) == 0)
-		    && (strncmp(name, cmd->name, name_len) == 0)) {
-			if ((grp_len == strlen(cmd->group))
-			    && (name_len == strlen(cmd->name))) {
-				exact_match = true;
-				result = cmd;
-			} else {
-				/* only keep the first partial match */
-				if (!result)
-					result = cmd;
-			}
-		}
-		cmd++;
-	}
-	return result;
-}
-
 /**
  * Parse a test command buffer
  *
@@ -254,7 +216,7 @@ static void list_commands(int argc, char **argv, struct tcmd_handler_ctx *ctx)
 		const struct tcmd_handler *last_cmd = first_cmd;
 		const struct tcmd_handler *cmd = first_cmd + 1;
 		while ((cmd < __test_cmds_end)
-		       && (strncmp(cur_grp, cmd->group, cur_grp_len) == 0)) {
+		       && (strcmp(cur_grp, cmd->group) == 0)) {
 			/* Commands are separated by a space */
 			size += strlen(cmd->name) + 1;
 			last_cmd = cmd;
@@ -347,7 +309,8 @@ void tcmd_send(char *command, tcmd_rsp_cb_t callback, void *data)
 			}
 		} else {
 			/* Lookup the test command handlers section to find a match */
-			cmd = find_command(group, name);
+			cmd = tcmd_lookup(__test_cmds_start, __test_cmds_end,
+					  group, name);
 		}
 		if (cmd) {
 			/* Immediately acknowledge the command */
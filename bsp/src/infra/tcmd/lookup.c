@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "lookup.h"
+
+/**
+ * Compare a (group, name) key with a test command handler
+ *
+ * If name is NULL, only the groups are compared and the key is considered
+ * greater than any handler of the same group: this allows to find the end
+ * of a group.
+ */
+static int compare_key(const char *group, const char *name,
+		       const struct tcmd_handler *cmd)
+{
+	int ret = strcmp(group, cmd->group);
+
+	if (ret)
+		return ret;
+	return name ? strcmp(name, cmd->name) : 1;
+}
+
+/**
+ * Return the first handler in [first, last) that is not lower than the key
+ */
+static const struct tcmd_handler *lower_bound(const struct tcmd_handler *first,
+					      const struct tcmd_handler *last,
+					      const char *group,
+					      const char *name)
+{
+	while (first < last) {
+		const struct tcmd_handler *mid = first + (last - first) / 2;
+		if (compare_key(group, name, mid) > 0)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+	return first;
+}
+
+static bool starts_with(const char *str, const char *prefix, int prefix_len)
+{
+	return strncmp(str, prefix, prefix_len) == 0;
+}
+
+const struct tcmd_handler *tcmd_lookup(const struct tcmd_handler *first,
+				       const struct tcmd_handler *last,
+				       const char *group, const char *name)
+{
+	const struct tcmd_handler *cmd;
+	int grp_len = strlen(group);
+	int name_len = strlen(name);
+
+	/* Exact match */
+	cmd = lower_bound(first, last, group, name);
+	if (cmd < last && compare_key(group, name, cmd) == 0)
+		return cmd;
+
+	/*
+	 * Partial match: the groups starting with the provided group are
+	 * contiguous, starting at the first entry not lower than (group, "").
+	 * Walk them in table order and search for the name in each of them.
+	 */
+	cmd = lower_bound(first, last, group, "");
+	while (cmd < last && starts_with(cmd->group, group, grp_len)) {
+		const char *cur_grp = cmd->group;
+		const struct tcmd_handler *grp_end =
+			lower_bound(cmd, last, cur_grp, NULL);
+		cmd = lower_bound(cmd, grp_end, cur_grp, name);
+		if (cmd < grp_end && starts_with(cmd->name, name, name_len))
+			return cmd;
+		cmd = grp_end;
+	}
+	return NULL;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _INFRA_TCMD_LOOKUP_H
+#define _INFRA_TCMD_LOOKUP_H
+
+#include "infra/tcmd/handler.h"
+
+/**
+ * @addtogroup infra_tcmd_engine
+ * @{
+ */
+
+/**
+ * Find a command handler for the specified group and command name
+ *
+ * The handlers table must be sorted by group, then by name, which is what
+ * the linker does for the handlers declared with DECLARE_TEST_COMMAND, as
+ * long as the section is collected with SORT(.test_cmds.*).
+ *
+ * An exact match on both group and name is always preferred. Otherwise,
+ * the first handler (in table order) whose group and name start with the
+ * provided group and name is returned.
+ *
+ * Exact matches are resolved with a single binary search. Partial matches
+ * require one additional binary search per candidate group.
+ *
+ * @param first the first handler of the sorted table
+ * @param last  one past the last handler of the sorted table
+ * @param group the command group
+ * @param name  the command name
+ *
+ * @return a pointer to a test command handler struct or NULL
+ */
+const struct tcmd_handler *tcmd_lookup(const struct tcmd_handler *first,
+				       const struct tcmd_handler *last,
+				       const char *group, const char *name);
+
+/** @} */
+
+#endif /* _INFRA_TCMD_LOOKUP_H */
@@ -31,6 +31,9 @@
 #include "util/workqueue.h"
 
 #include "infra/ipc.h"
+#ifdef CONFIG_IPC_RING
+#include "infra/ipc_ring.h"
+#endif
 #include "infra/log.h"
 #include "infra/port.h"
 #include "infra/tcmd/engine.h"
@@ -59,6 +62,14 @@ T_QUEUE bsp_init(void)
 	set_cpu_message_sender(CPU_ID_QUARK, ipc_async_send_message);
 	set_cpu_free_handler(CPU_ID_QUARK, ipc_async_free_message);
 	ipc_async_init(q);
+#ifdef CONFIG_IPC_RING
+	if (shared_data->ipc_rings) {
+		struct ipc_ring *rings = shared_data->ipc_rings;
+		ipc_ring_attach(&rings[IPC_RING_SS_QRK],
+				&rings[IPC_RING_QRK_SS],
+				ipc_ring_quark_doorbell);
+	}
+#endif
 
 	/* Test Commands initialization */
 #ifdef CONFIG_TCMD_ASYNC
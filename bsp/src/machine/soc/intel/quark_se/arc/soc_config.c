@@ -42,6 +42,9 @@
 #ifdef CONFIG_PATTERN_MATCHING_DRV
 #include "intel_qrk_pattern_matching.h"
 #endif
+#ifdef CONFIG_SENSOR_REPLAY
+#include "drivers/sensor/sensor_replay.h"
+#endif
 
 #define PLATFORM_INIT(devices, buses) \
 	init_devices(devices, (unsigned int)(sizeof(devices) / sizeof(*devices)), \
@@ -65,6 +68,7 @@ struct sba_device pf_sba_device_spi_bmi160 = {
 	.dev.driver = &spi_bmi160_driver,
 	.parent = &pf_bus_sba_ss_spi_1,
 	.addr.cs = BMI160_PRIMARY_BUS_ADDR,
+	.qos.priority = SBA_PRIO_HIGH,
 };
 #endif
 
@@ -89,6 +93,7 @@ struct sba_device pf_sba_device_i2c_bmi160 = {
 	.dev.driver = &i2c_bmi160_driver,
 	.parent = &pf_bus_sba_ss_i2c_0,
 	.addr.slave_addr = BMI160_PRIMARY_BUS_ADDR,
+	.qos.priority = SBA_PRIO_HIGH,
 };
 #endif
 #if defined(CONFIG_BME280) && defined(CONFIG_BME280_I2C)
@@ -372,6 +377,12 @@ struct td_device pf_device_pattern_matching = {
 	}
 };
 #endif
+#ifdef CONFIG_SENSOR_REPLAY
+struct td_device pf_device_sensor_replay = {
+	.id = SENSOR_REPLAY_ID,
+	.driver = &sensor_replay_driver,
+};
+#endif
 
 
 /* Array of arc platform devices (on die memory, spi slave etc ...) */
@@ -440,6 +451,10 @@ static struct td_device *arc_platform_devices[] = {
 	(struct td_device *)&pf_sba_device_i2c_bme280,
 #endif
 #endif
+
+#ifdef CONFIG_SENSOR_REPLAY
+	&pf_device_sensor_replay,
+#endif
 };
 
 void init_all_devices()
@@ -48,6 +48,9 @@ void mbxIsr(void *param)
 
 	if (sts & 0x02) {
 		MBX_STS(IPC_QRK_SS_ASYNC) = sts;
+#ifdef CONFIG_IPC_RING
+		ipc_ring_handle_doorbell();
+#endif
 	}
 	ipc_handle_message();
 }
@@ -59,10 +62,10 @@ extern void mbxIsr(void *param);
 
 int _mbxPollOut(int data)
 {
-	//while((* (volatile unsigned int *)(0xB0800000 + 0xA60 + 20)) & 1)
-	//    ; // STS
 	int flags = irq_lock();
 
+	while (MBX(20) & 1)
+		;  // STS
 	MBX(4) = (unsigned int)data; //DAT0
 	MBX(8) = 1; // DAT1
 	MBX(0) = 0x80000000; // CTRL
@@ -85,6 +88,19 @@ int _mbxPollOut(int data)
 	return data;
 }
 
+#ifdef CONFIG_IPC_RING
+void ipc_ring_quark_doorbell(void)
+{
+	int flags = irq_lock();
+
+	/* Wait for quark to acknowledge the previous doorbell */
+	while (MBX_STS(IPC_SS_QRK_RING) & 1)
+		;
+	MBX_CTRL(IPC_SS_QRK_RING) = 0x80000000;
+	irq_unlock(flags);
+}
+#endif
+
 extern void __printk_hook_install(int (*fn)(int));
 extern void __stdout_hook_install(int (*fn)(int));
 
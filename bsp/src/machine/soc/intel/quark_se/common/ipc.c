@@ -37,6 +37,13 @@
 #include "infra/time.h"
 #include "machine.h"
 #include "os/os.h"
+#ifdef CONFIG_IPC_RING
+#include "infra/ipc_ring.h"
+#endif
+#ifdef CONFIG_TCMD
+#include <stdio.h>
+#include "infra/tcmd/handler.h"
+#endif
 
 #include "quark_se_common.h"
 
@@ -168,9 +175,46 @@ int ipc_request_sync_int(int request_id, int param1, int param2, void *ptr)
 
 #define IPC_MESSAGE_SEND 1
 #define IPC_MESSAGE_FREE 2
+#define IPC_MESSAGE_RING 3
+#define IPC_MESSAGE_FREE_BATCH 4
 
 static uint16_t ipc_port;
 
+#ifdef CONFIG_IPC_RING
+static void ipc_ring_push_backlog(uint32_t entry);
+#endif
+
+#ifdef CONFIG_IPC_FREE_BATCH
+struct ipc_free_batch {
+	/* Set while the batch is being sent to the remote CPU */
+	bool busy;
+	/* Set when the batch is full but its flush request was not posted */
+	bool retry;
+	uint8_t count;
+	struct message *msgs[CONFIG_IPC_FREE_BATCH_SIZE];
+};
+
+/* Messages are added to one batch while the other one is sent */
+static struct ipc_free_batch ipc_free_batches[2];
+static uint8_t ipc_free_batch_fill;
+/* Set while a flush request of the batch being filled is posted */
+static bool ipc_free_flush_posted;
+
+static struct {
+	/* Messages freed through a batch */
+	uint32_t batched;
+	/* Messages freed with their own request, both batches being busy */
+	uint32_t unbatched;
+	/* Batch requests sent, because full or because the queue drained */
+	uint32_t full_flushes;
+	uint32_t drain_flushes;
+	/* Full batches sent by a later flush, their request failed to post */
+	uint32_t retries;
+} ipc_free_stats;
+
+static void ipc_free_batch_flush(struct ipc_free_batch *batch);
+#endif
+
 struct ipc_async_msg {
 	struct message h;
 	void *data;
@@ -202,6 +246,16 @@ static void handle_ipc_request_port(struct message *m, void *data)
 		ipc_request_sync_int(IPC_MSG_TYPE_FREE,
 				     0, 0, msg->data);
 		break;
+#ifdef CONFIG_IPC_RING
+	case IPC_MESSAGE_RING:
+		ipc_ring_push_backlog((uint32_t)msg->data);
+		break;
+#endif
+#ifdef CONFIG_IPC_FREE_BATCH
+	case IPC_MESSAGE_FREE_BATCH:
+		ipc_free_batch_flush(msg->data);
+		break;
+#endif
 	}
 	bfree(msg);
 }
@@ -209,8 +263,9 @@ static void handle_ipc_request_port(struct message *m, void *data)
 /**
  * \brief send a message to handle_ipc_request_port()
  *
- * \param msgid the message id to generate. can be \ref IPC_MESSAGE_FREE
- *              or \ref IPC_MESSAGE_SEND
+ * \param msgid the message id to generate. can be \ref IPC_MESSAGE_FREE,
+ *              \ref IPC_MESSAGE_SEND, \ref IPC_MESSAGE_RING or
+ *              \ref IPC_MESSAGE_FREE_BATCH
  * \param message the message data to send / free
  */
 static int ipc_request_send(uint16_t msgid, void *message)
@@ -229,14 +284,251 @@ static int ipc_request_send(uint16_t msgid, void *message)
 	return err;
 }
 
+#ifdef CONFIG_IPC_RING
+/* Set in ring entries for messages to free, message addresses are aligned */
+#define IPC_RING_FREE 1
+
+static struct ipc_ring *ipc_tx_ring;
+static struct ipc_ring *ipc_rx_ring;
+static void (*ipc_ring_doorbell)(void);
+/* Number of entries waiting for room in the tx ring on the ipc port */
+static volatile uint32_t ipc_ring_backlog;
+
+void ipc_ring_attach(struct ipc_ring *tx, struct ipc_ring *rx,
+		     void (*doorbell)(void))
+{
+	ipc_tx_ring = tx;
+	ipc_rx_ring = rx;
+	ipc_ring_doorbell = doorbell;
+	ipc_ring_set_ready(rx);
+	pr_debug(LOG_MODULE_QUARK_SE, "%s: tx %p rx %p", __func__, tx, rx);
+}
+
+/**
+ * \brief push an entry to the tx ring, called with interrupts locked
+ *
+ * \param entry the message address, or'ed with \ref IPC_RING_FREE
+ *
+ * \return 0 if the entry was pushed, -1 if the ring is full
+ */
+static int ipc_ring_push_locked(uint32_t entry)
+{
+	if (ipc_ring_push(ipc_tx_ring, entry))
+		return -1;
+	if (ipc_ring_take_doorbell(ipc_tx_ring))
+		ipc_ring_doorbell();
+	return 0;
+}
+
+/**
+ * \brief push an entry to the tx ring, or queue it on the ipc port if full
+ *
+ * Entries are queued behind the backlog to keep the message order.
+ *
+ * \param entry the message address, or'ed with \ref IPC_RING_FREE
+ */
+static int ipc_ring_post(uint32_t entry)
+{
+	int ret;
+	uint32_t flags = irq_lock();
+
+	if (!ipc_ring_backlog && !ipc_ring_push_locked(entry)) {
+		irq_unlock(flags);
+		return E_OS_OK;
+	}
+	ipc_ring_backlog++;
+	irq_unlock(flags);
+
+	ret = ipc_request_send(IPC_MESSAGE_RING, (void *)entry);
+	if (ret != E_OS_OK) {
+		flags = irq_lock();
+		ipc_ring_backlog--;
+		irq_unlock(flags);
+	}
+	return ret;
+}
+
+/**
+ * \brief wait for room in the tx ring to push a backlog entry
+ *
+ * The remote CPU drains the ring from its doorbell interrupt, the wait is
+ * short. It is done from the ipc port context, never from an interrupt.
+ */
+static void ipc_ring_push_backlog(uint32_t entry)
+{
+	uint32_t flags;
+
+	for (;;) {
+		flags = irq_lock();
+		if (!ipc_ring_push_locked(entry)) {
+			ipc_ring_backlog--;
+			irq_unlock(flags);
+			return;
+		}
+		irq_unlock(flags);
+	}
+}
+
+void ipc_ring_handle_doorbell(void)
+{
+	uint32_t entry;
+
+	if (!ipc_rx_ring)
+		return;
+	do {
+		while (ipc_ring_pop(ipc_rx_ring, &entry) == 0) {
+			if (entry & IPC_RING_FREE)
+				message_free((struct message *)
+					     (entry & ~IPC_RING_FREE));
+			else
+				port_send_message((struct message *)entry);
+		}
+	} while (ipc_ring_arm_doorbell(ipc_rx_ring));
+}
+#endif
+
 int ipc_async_send_message(struct message *message)
 {
+#ifdef CONFIG_IPC_RING
+	if (ipc_ring_is_ready(ipc_tx_ring))
+		return ipc_ring_post((uint32_t)message);
+#endif
 	return ipc_request_send(IPC_MESSAGE_SEND, message);
 }
 
+#ifdef CONFIG_IPC_FREE_BATCH
+/**
+ * \brief send a busy batch of messages to free to the remote CPU
+ *
+ * \param batch the batch to send
+ */
+static void ipc_free_batch_send(struct ipc_free_batch *batch)
+{
+	uint32_t flags;
+
+	ipc_request_sync_int(IPC_MSG_TYPE_FREE_BATCH, batch->count, 0,
+			     batch->msgs);
+
+	flags = irq_lock();
+	batch->count = 0;
+	batch->retry = false;
+	batch->busy = false;
+	irq_unlock(flags);
+}
+
+/**
+ * \brief send a batch of messages to free to the remote CPU
+ *
+ * Called in the context of the ipc port.
+ *
+ * \param batch the full batch to send, or NULL to send the full batches
+ *              whose flush request failed to post, then the batch being
+ *              filled, once the queue has processed the messages posted
+ *              before its first free.
+ */
+static void ipc_free_batch_flush(struct ipc_free_batch *batch)
+{
+	uint32_t flags;
+	int i;
+
+	if (batch) {
+		ipc_free_stats.full_flushes++;
+		ipc_free_batch_send(batch);
+		return;
+	}
+
+	for (i = 0; i < 2; i++) {
+		flags = irq_lock();
+		batch = &ipc_free_batches[i];
+		if (!batch->retry) {
+			irq_unlock(flags);
+			continue;
+		}
+		ipc_free_stats.retries++;
+		irq_unlock(flags);
+		ipc_free_batch_send(batch);
+	}
+
+	flags = irq_lock();
+	ipc_free_flush_posted = false;
+	batch = &ipc_free_batches[ipc_free_batch_fill];
+	if (batch->busy || !batch->count) {
+		/* Already flushed because full */
+		irq_unlock(flags);
+		return;
+	}
+	batch->busy = true;
+	ipc_free_batch_fill ^= 1;
+	ipc_free_stats.drain_flushes++;
+	irq_unlock(flags);
+
+	ipc_free_batch_send(batch);
+}
+
+/**
+ * \brief add a message to the batch being filled
+ *
+ * The batch is sent when full, or else when the ipc port handles the flush
+ * request posted with its first message: every message queued before the
+ * first free has then been processed, so a burst is freed with one request.
+ *
+ * If a request cannot be posted, the messages stay in their batch and the
+ * next free posts a flush request again.
+ *
+ * \param message the message to free
+ */
+static void ipc_free_batch_add(struct message *message)
+{
+	struct ipc_free_batch *batch;
+	uint16_t msgid = 0;
+	void *data = NULL;
+	uint32_t flags = irq_lock();
+
+	batch = &ipc_free_batches[ipc_free_batch_fill];
+	if (batch->busy) {
+		ipc_free_stats.unbatched++;
+		irq_unlock(flags);
+		ipc_request_send(IPC_MESSAGE_FREE, message);
+		return;
+	}
+	batch->msgs[batch->count++] = message;
+	ipc_free_stats.batched++;
+	if (batch->count == CONFIG_IPC_FREE_BATCH_SIZE) {
+		batch->busy = true;
+		ipc_free_batch_fill ^= 1;
+		msgid = IPC_MESSAGE_FREE_BATCH;
+		data = batch;
+	} else if (!ipc_free_flush_posted) {
+		ipc_free_flush_posted = true;
+		msgid = IPC_MESSAGE_FREE_BATCH;
+	}
+	irq_unlock(flags);
+
+	if (!msgid || ipc_request_send(msgid, data) == E_OS_OK)
+		return;
+
+	pr_warning(LOG_MODULE_QUARK_SE, "free batch flush delayed");
+	flags = irq_lock();
+	if (data)
+		batch->retry = true;
+	ipc_free_flush_posted = false;
+	irq_unlock(flags);
+}
+#endif
+
 void ipc_async_free_message(struct message *message)
 {
+#ifdef CONFIG_IPC_RING
+	if (ipc_ring_is_ready(ipc_tx_ring)) {
+		ipc_ring_post((uint32_t)message | IPC_RING_FREE);
+		return;
+	}
+#endif
+#ifdef CONFIG_IPC_FREE_BATCH
+	ipc_free_batch_add(message);
+#else
 	ipc_request_send(IPC_MESSAGE_FREE, message);
+#endif
 }
 
 void ipc_async_init(T_QUEUE queue)
@@ -245,3 +537,28 @@ void ipc_async_init(T_QUEUE queue)
 	port_set_handler(ipc_port, handle_ipc_request_port, NULL);
 	pr_debug(LOG_MODULE_QUARK_SE, "%s: done port: %d", __func__, ipc_port);
 }
+
+#if defined(CONFIG_TCMD) && defined(CONFIG_IPC_FREE_BATCH)
+/*
+ * Displays the counters of the remote message free batches: ipc free_stats
+ *
+ * @param[in]   argc        Number of arguments in the Test Command (including group and name)
+ * @param[in]   argv        Table of null-terminated buffers containing the arguments
+ * @param[in]   ctx         The opaque context to pass to responses
+ */
+void ipc_free_stats_tcmd(int argc, char **argv, struct tcmd_handler_ctx *ctx)
+{
+	char answer[80];
+
+	snprintf(answer, sizeof(answer),
+		 "batched %u unbatched %u flushes full %u drain %u retry %u",
+		 (unsigned int)ipc_free_stats.batched,
+		 (unsigned int)ipc_free_stats.unbatched,
+		 (unsigned int)ipc_free_stats.full_flushes,
+		 (unsigned int)ipc_free_stats.drain_flushes,
+		 (unsigned int)ipc_free_stats.retries);
+	TCMD_RSP_FINAL(ctx, answer);
+}
+
+DECLARE_TEST_COMMAND_ENG(ipc, free_stats, ipc_free_stats_tcmd);
+#endif
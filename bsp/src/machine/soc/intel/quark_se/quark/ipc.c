@@ -32,6 +32,17 @@
 #include "infra/ipc.h"
 #include "infra/port.h"
 #include "machine.h"
+#ifdef CONFIG_IPC_RING
+#include "infra/ipc_ring.h"
+
+/* Rings live in quark RAM, which is visible from ARC */
+static struct ipc_ring ipc_rings[2];
+
+static void ipc_ring_arc_doorbell(void)
+{
+	MBX_CTRL(IPC_QRK_SS_ASYNC) = 0x80000000;
+}
+#endif
 
 T_QUEUE ipc_setup(void)
 {
@@ -48,5 +59,15 @@ T_QUEUE ipc_setup(void)
 	set_cpu_id(CPU_ID_QUARK);
 	set_cpu_message_sender(CPU_ID_ARC, ipc_async_send_message);
 	set_cpu_free_handler(CPU_ID_ARC, ipc_async_free_message);
+
+#ifdef CONFIG_IPC_RING
+	ipc_ring_init(&ipc_rings[IPC_RING_QRK_SS]);
+	ipc_ring_init(&ipc_rings[IPC_RING_SS_QRK]);
+	ipc_ring_attach(&ipc_rings[IPC_RING_QRK_SS],
+			&ipc_rings[IPC_RING_SS_QRK], ipc_ring_arc_doorbell);
+	shared_data->ipc_rings = ipc_rings;
+#else
+	shared_data->ipc_rings = NULL;
+#endif
 	return queue;
 }
@@ -28,31 +28,134 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string.h>
+
 #include "util/assert.h"
 #include "machine/soc/intel/quark_se/quark/log_backend_flash.h"
 #include "machine/soc/intel/quark_se/soc_config.h"
 #include "project_mapping.h"
+#include "os/os.h"
+#ifdef CONFIG_WORKQUEUE
+#include "util/workqueue.h"
+#endif
 
 #include <board.h>
 #include <infra/device.h>
 #include <infra/log.h>
 #include <drivers/spi_flash.h>
 
+/*
+ * The first sector of the log partition is a journal of the end offset of
+ * the logs, the other sectors are a circular buffer of log text.
+ * Log text is accumulated in a page buffer and programmed one page at a
+ * time; the journal is updated once per page, or when the logs are flushed.
+ */
 
 #define FLASH_SECTOR_SIZE       SERIAL_FLASH_BLOCK_SIZE
 #define LOG_FLASH_ADDRESS_START (SPI_LOG_START_BLOCK * SERIAL_FLASH_BLOCK_SIZE)
 #define LOG_FLASH_SECTOR_START  (SPI_LOG_START_BLOCK)
-#define FLASH_LOG_SECTOR_COUNT  (SPI_LOG_END_BLOCK)
+/* Sectors are numbered from the start of the partition, like the offsets */
+#define FLASH_LOG_SECTOR_COUNT  (SPI_LOG_NB_BLOCKS)
+#define FLASH_PAGE_SIZE         256
 #define READ_BLOCK_LEN          256
 #define READ_BLOCK_COUNT        (FLASH_SECTOR_SIZE / READ_BLOCK_LEN)
+#define JOURNAL_ENTRIES         (FLASH_SECTOR_SIZE / 4)
 #define SPARE                   0xFFFFFFFF
 
-static uint32_t flash_index; /* current write pointer to flash */
-static int current_index = 0; /* current write pointer in header contains all flash_index */
+static uint32_t flash_index; /* offset in the partition of the page buffer */
+static int current_index = 0; /* next entry of the journal */
 static int current_sector = 0; /* current write sector */
 
+/* Text not yet programmed, up to the end of the page of flash_index */
+static uint8_t page_buf[FLASH_PAGE_SIZE];
+static uint16_t page_len;
+
+/* Sector erased ahead of current_sector, maybe still being erased */
+static int next_sector = 0;
+#ifdef CONFIG_WORKQUEUE
+static T_SEMAPHORE erase_done;
+#endif
+
 static struct td_device *spi_dev;
 
+static void erase_sector(int sector)
+{
+	spi_flash_sector_erase(spi_dev, LOG_FLASH_SECTOR_START + sector, 1);
+}
+
+#ifdef CONFIG_WORKQUEUE
+static void erase_work(void *data)
+{
+	erase_sector((int)data);
+	semaphore_give(erase_done, NULL);
+}
+#endif
+
+/* Prepare one erased sector after current_sector, in the background */
+static void erase_ahead(void)
+{
+	next_sector = current_sector + 1;
+	if (next_sector >= FLASH_LOG_SECTOR_COUNT)
+		next_sector = 1;
+#ifdef CONFIG_WORKQUEUE
+	if (workqueue_queue_work(erase_work, (void *)next_sector) == E_OS_OK)
+		return;
+#endif
+	erase_sector(next_sector);
+#ifdef CONFIG_WORKQUEUE
+	semaphore_give(erase_done, NULL);
+#endif
+}
+
+/* Move to next_sector once its erase is complete */
+static void enter_next_sector(void)
+{
+#ifdef CONFIG_WORKQUEUE
+	semaphore_take(erase_done, OS_WAIT_FOREVER);
+#endif
+	current_sector = next_sector;
+	flash_index = current_sector * FLASH_SECTOR_SIZE;
+	erase_ahead();
+}
+
+/* Record the end of the programmed logs in the journal */
+static void commit_index(void)
+{
+	unsigned int wlen = 0;
+
+	if (current_index >= JOURNAL_ENTRIES) {
+		erase_sector(0);
+		current_index = 0;
+	}
+	spi_flash_write_byte(spi_dev, LOG_FLASH_ADDRESS_START +
+			     (current_index * 4),
+			     sizeof(flash_index), &wlen,
+			     (uint8_t *)&flash_index);
+	current_index++;
+}
+
+/* Program the page buffer, and move to the next page if it is full */
+static void program_page(void)
+{
+	unsigned int wlen = 0;
+	bool full = (flash_index % FLASH_PAGE_SIZE) + page_len ==
+		    FLASH_PAGE_SIZE;
+
+	if (!page_len)
+		return;
+	spi_flash_write_byte(spi_dev, LOG_FLASH_ADDRESS_START + flash_index,
+			     page_len, &wlen, page_buf);
+	assert(wlen == page_len);
+	flash_index += page_len;
+	page_len = 0;
+
+	/* Only record the start of the next sector once it is erased: the
+	 * logs never resume in a partly erased sector after a power loss */
+	if (full && flash_index % FLASH_SECTOR_SIZE == 0)
+		enter_next_sector();
+	commit_index();
+}
+
 void log_backend_flash_init()
 {
 	spi_dev = (struct td_device *)&pf_sba_device_flash_spi0;
@@ -60,14 +163,23 @@ void log_backend_flash_init()
 	unsigned int retlen;
 	int i, j;
 
+#ifdef CONFIG_WORKQUEUE
+	if (!erase_done)
+		erase_done = semaphore_create(0);
+	else
+		/* Wait for the erase of a previous activation */
+		semaphore_take(erase_done, OS_WAIT_FOREVER);
+#endif
+
+	page_len = 0;
 	current_sector = 1;
-	flash_index = LOG_FLASH_ADDRESS_START + current_sector *
-		      FLASH_SECTOR_SIZE;
+	flash_index = current_sector * FLASH_SECTOR_SIZE;
 	current_index = 0;
 
 	/* TODO check if OTA pacakage and erase block */
 	for (i = READ_BLOCK_COUNT; i > 0; i--) {
-		spi_flash_read(spi_dev, READ_BLOCK_LEN * (i - 1),
+		spi_flash_read(spi_dev, LOG_FLASH_ADDRESS_START +
+			       READ_BLOCK_LEN * (i - 1),
 			       READ_BLOCK_LEN / 4,
 			       &retlen,
 			       data);
@@ -81,47 +193,43 @@ void log_backend_flash_init()
 				break;
 			}
 		}
-		if (flash_index != LOG_FLASH_ADDRESS_START + current_sector *
-		    FLASH_SECTOR_SIZE)
+		if (current_index)
 			break;
 	}
+
+	/* Restart from an erased first sector if the journal is empty or out
+	 * of range */
+	current_sector = flash_index / FLASH_SECTOR_SIZE;
+	if (!current_index || current_sector < 1 ||
+	    current_sector >= FLASH_LOG_SECTOR_COUNT) {
+		current_sector = 1;
+		flash_index = current_sector * FLASH_SECTOR_SIZE;
+		erase_sector(current_sector);
+	}
+	/* The current sector was erased ahead, prepare the next one */
+	erase_ahead();
 }
 
 static void spi_flash_puts(const char *s, uint16_t len)
 {
-	unsigned int wlen = 0;
-	int next_sector;
-
-	if ((flash_index + len) >
-	    (FLASH_LOG_SECTOR_COUNT * FLASH_SECTOR_SIZE)) {
-		flash_index = FLASH_SECTOR_SIZE;
+	uint16_t room, chunk;
+
+	while (len) {
+		room = FLASH_PAGE_SIZE - (flash_index % FLASH_PAGE_SIZE) -
+		       page_len;
+		chunk = len < room ? len : room;
+		memcpy(&page_buf[page_len], s, chunk);
+		page_len += chunk;
+		s += chunk;
+		len -= chunk;
+		if (chunk == room)
+			program_page();
 	}
+}
 
-	spi_flash_write_byte(spi_dev, LOG_FLASH_ADDRESS_START + flash_index,
-			     len, &wlen,
-			     (uint8_t *)s);
-	assert(wlen == len);
-	flash_index += wlen;
-
-	if (current_index >= READ_BLOCK_LEN / 4 * READ_BLOCK_COUNT) {
-		spi_flash_sector_erase(spi_dev, LOG_FLASH_SECTOR_START, 1);
-		current_index = 0;
-	}
-	spi_flash_write_byte(spi_dev, LOG_FLASH_ADDRESS_START +
-			     (current_index * 4),
-			     sizeof(flash_index), &wlen,
-			     (uint8_t *)&flash_index);
-	current_index++;
-
-	next_sector = flash_index / FLASH_SECTOR_SIZE;
-	if (next_sector != current_sector) {
-		current_sector = next_sector;
-		/* Prepare one erased sector */
-		spi_flash_sector_erase(spi_dev, LOG_FLASH_SECTOR_START +
-				       ((next_sector +
-					 1) % FLASH_LOG_SECTOR_COUNT), 1);
-	}
-	;
+static void spi_flash_flush(void)
+{
+	program_page();
 }
 
 static bool is_spi_flash_ready(void)
@@ -131,5 +239,6 @@ static bool is_spi_flash_ready(void)
 
 struct log_backend log_backend_flash = {
 	.put_one_msg = spi_flash_puts,
-	.is_backend_ready = is_spi_flash_ready
+	.is_backend_ready = is_spi_flash_ready,
+	.flush = spi_flash_flush
 };
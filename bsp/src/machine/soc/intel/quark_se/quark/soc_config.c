@@ -98,10 +98,13 @@ static struct sba_master_cfg_data qrk_sba_spi_1_cfg = {
 	},
 };
 
+/* The SPI flash is the only device of the SPI0 bus: both are resumed when
+ * the flash is first accessed after a deep sleep, see device_resume() */
 struct td_device pf_bus_sba_spi_0 = {
 	.id = SBA_SPI0_ID,
 	.driver = &serial_bus_access_driver,
-	.priv = &qrk_sba_spi_0_cfg
+	.priv = &qrk_sba_spi_0_cfg,
+	.lazy_resume = 1
 };
 struct td_device pf_bus_sba_spi_1 = {
 	.id = SBA_SPI1_ID,
@@ -161,6 +164,7 @@ struct sba_device pf_sba_device_flash_spi0 = {
 #elif defined(CONFIG_SPI_FLASH_MX25R1635F)
 	.dev.driver = (struct driver *)&spi_flash_mx25r1635f_driver,
 #endif
+	.dev.lazy_resume = 1,
 	.parent = &pf_bus_sba_spi_0,
 	.addr.cs = SPI_FLASH_CS
 };
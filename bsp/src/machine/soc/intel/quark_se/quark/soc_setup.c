@@ -115,21 +115,37 @@ void mbx_out_channel()
 enum {
 	IPC_RX_REQ = 0,
 	IPC_RX_ACK,
-	IPC_RX_ASYNC
+	IPC_RX_ASYNC,
+#ifdef CONFIG_IPC_RING
+	IPC_RX_RING
+#endif
 };
 
 static void (*ipc_callbacks[])() = {
 	[IPC_RX_ASYNC] = mbx_out_channel,
 	[IPC_RX_REQ] = NULL,
-	[IPC_RX_ACK] = NULL
+	[IPC_RX_ACK] = NULL,
+#ifdef CONFIG_IPC_RING
+	[IPC_RX_RING] = ipc_ring_handle_doorbell
+#endif
 };
 
 static const uint8_t ipc_channels[] = {
 	[IPC_RX_ASYNC] = IPC_SS_QRK_ASYNC,
 	[IPC_RX_REQ] = IPC_SS_QRK_REQ,
-	[IPC_RX_ACK] = IPC_SS_QRK_ACK
+	[IPC_RX_ACK] = IPC_SS_QRK_ACK,
+#ifdef CONFIG_IPC_RING
+	[IPC_RX_RING] = IPC_SS_QRK_RING
+#endif
 };
 
+/* Interrupt status bits of the rx channels in MBX_CHALL_STS */
+#ifdef CONFIG_IPC_RING
+#define IPC_RX_CHALL_STS 0x0510
+#else
+#define IPC_RX_CHALL_STS 0x0500
+#endif
+
 void notrace mbxIsr(int param)
 {
 	do {
@@ -144,10 +160,11 @@ void notrace mbxIsr(int param)
 				ipc_callbacks[i]();
 			}
 			/* Acknowledge ipc interrupt */
-			if (ipc_channels[i] == IPC_SS_QRK_ASYNC)
+			if (ipc_channels[i] == IPC_SS_QRK_ASYNC ||
+			    ipc_channels[i] == IPC_SS_QRK_RING)
 				MBX_STS(ipc_channels[i]) = sts;
 		}
-	} while (MBX_CHALL_STS & 0x0500);
+	} while (MBX_CHALL_STS & IPC_RX_CHALL_STS);
 }
 
 static void display_boot_target(void)
@@ -218,6 +235,9 @@ void soc_setup(void)
 	/* Enable interrupt for ipc channels */
 	SOC_MBX_INT_UNMASK(IPC_SS_QRK_ASYNC);
 	SOC_MBX_INT_UNMASK(IPC_SS_QRK_REQ);
+#ifdef CONFIG_IPC_RING
+	SOC_MBX_INT_UNMASK(IPC_SS_QRK_RING);
+#endif
 
 	/* Enable Always on timer */
 	SCSS_REG_VAL(SCSS_AONC_CFG) = AONC_CNT_EN;
@@ -27,15 +27,31 @@
  * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
  */
-
+#define _GNU_SOURCE
+/* Keep the libc POSIX timer prototypes out of the way of the OS API ones */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#undef timer_create
+#undef timer_delete
 #include "os/os.h"
 #include "infra/log.h"
-#include <stdlib.h>
 #include "util/list.h"
 
 /**
  * @defgroup os_linux Linux OS Abstraction Layer
- * Implements the linux OS abstraction layer.
+ * Implements the linux OS abstraction layer on top of POSIX threads.
+ *
+ * The "interrupt lock" is a process-wide recursive mutex: the timer thread
+ * runs its callbacks with it held, the same way the hardware timer ISR
+ * preempts tasks on target. Blocking objects (queues, semaphores) use a
+ * separate leaf mutex and condition variable so that a task blocked on
+ * them never holds the interrupt lock.
+ *
+ * Binaries using this layer must be linked with -lpthread.
  * @ingroup os
  * @{
  */
@@ -49,6 +65,101 @@ DEFINE_LOG_MODULE(LOG_MODULE_OS, "  OS")
 	do { if (err_ptr == NULL) pr_error(LOG_MODULE_OS, "panic!"); \
 	     else *err_ptr = errno; } while (0)
 
+/** Number of queues that can be created */
+#define OS_LINUX_QUEUES 16
+
+/*************************    IRQ LOCK   *************************/
+
+static pthread_mutex_t irq_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+/* Protects queue and semaphore state, never held while taking irq_mutex */
+static pthread_mutex_t os_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+unsigned int irq_lock(void)
+{
+	pthread_mutex_lock(&irq_mutex);
+	return 0;
+}
+
+void irq_unlock(unsigned int key)
+{
+	pthread_mutex_unlock(&irq_mutex);
+}
+
+void disable_scheduling(void)
+{
+	irq_lock();
+}
+
+void enable_scheduling(void)
+{
+	irq_unlock(0);
+}
+
+/*************************    TIME   *************************/
+
+static uint64_t monotonic_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Compute the CLOCK_MONOTONIC absolute deadline for a relative timeout.
+ * Condition variables used by this layer are bound to CLOCK_MONOTONIC.
+ */
+static void deadline_from_ms(struct timespec *ts, int timeout)
+{
+	clock_gettime(CLOCK_MONOTONIC, ts);
+	ts->tv_sec += timeout / 1000;
+	ts->tv_nsec += (timeout % 1000) * 1000000L;
+	if (ts->tv_nsec >= 1000000000L) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000L;
+	}
+}
+
+static void monotonic_cond_init(pthread_cond_t *cond)
+{
+	pthread_condattr_t attr;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+/**
+ * Wait on cond (with os_mutex held) according to the OS timeout semantic.
+ *
+ * @return 0 when signaled, ETIMEDOUT otherwise
+ */
+static int os_cond_wait(pthread_cond_t *cond, const struct timespec *deadline,
+			int timeout)
+{
+	if (timeout == OS_WAIT_FOREVER)
+		return pthread_cond_wait(cond, &os_mutex);
+	return pthread_cond_timedwait(cond, &os_mutex, deadline);
+}
+
+uint32_t get_time_ms(void)
+{
+	return (uint32_t)(monotonic_us() / 1000);
+}
+
+uint64_t get_time_us(void)
+{
+	return monotonic_us();
+}
+
+void local_task_sleep_ms(int time)
+{
+	struct timespec ts = { time / 1000, (time % 1000) * 1000000L };
+
+	while (nanosleep(&ts, &ts) != 0 && errno == EINTR) ;
+}
 
 /*************************    MEMORY   *************************/
 
@@ -58,124 +169,233 @@ int alloc_count = 0;
 
 void *balloc(uint32_t size, OS_ERR_TYPE *err)
 {
-	void *ptr;
-	unsigned int flags = irq_lock();
+	void *ptr = malloc(size);
 
-	ptr = malloc(size + sizeof(void *));
-	if (ptr) {
-		(*(int *)ptr) = size;
+	if (!ptr) {
+		set_error_panic(err, E_OS_ERR_NO_MEMORY);
+		return NULL;
+	}
+	reset_err_ptr(err);
 #ifdef TRACK_ALLOCS
-		alloc_count++;
+	__sync_fetch_and_add(&alloc_count, 1);
 #endif
-	}
-	irq_unlock(flags);
 	return ptr;
 }
 
 OS_ERR_TYPE bfree(void *ptr)
 {
-	int flags = irq_lock();
-
 #ifdef TRACK_ALLOCS
-	alloc_count--;
+	__sync_fetch_and_sub(&alloc_count, 1);
 #endif
 	free(ptr);
-	irq_unlock(flags);
 	return E_OS_OK;
 }
 
 
 /*************************    QUEUES   *************************/
 
+/*
+ * Messages are chained through their leading list_t, as on target. The list
+ * is manipulated directly under os_mutex rather than through util/list so
+ * that queue operations never nest the interrupt lock inside os_mutex.
+ */
 typedef struct queue_ {
 	list_head_t lh;
-	int count;
+	pthread_cond_t cond;
+	uint32_t count;
+	uint32_t max_size;
 	int used;
 } q_t;
 
-q_t q_pool[10] = { { 0 }, };
+static q_t q_pool[OS_LINUX_QUEUES];
 
-void queue_put(void *queue, void *msg)
+static void queue_push(q_t *q, list_t *elem, bool head)
 {
-	q_t *q = (q_t *)queue;
-
-	list_add(&q->lh, (list_t *)msg);
-#ifdef DEBUG_OS
-	pr_debug(LOG_MODULE_OS, "queue_put: %p <- %p", queue, msg);
-#endif
+	if (head) {
+		elem->next = q->lh.head;
+		q->lh.head = elem;
+		if (!q->lh.tail)
+			q->lh.tail = elem;
+	} else {
+		elem->next = NULL;
+		if (q->lh.tail)
+			q->lh.tail->next = elem;
+		else
+			q->lh.head = elem;
+		q->lh.tail = elem;
+	}
+	q->count++;
 }
-void queue_put_head(void *queue, void *msg)
+
+static list_t *queue_pop(q_t *q)
 {
-	q_t *q = (q_t *)queue;
+	list_t *elem = q->lh.head;
 
-	list_add_head(&q->lh, (list_t *)msg);
-#ifdef DEBUG_OS
-	pr_debug(LOG_MODULE_OS, "queue_put: %p <- %p", queue, msg);
-#endif
+	if (elem) {
+		q->lh.head = elem->next;
+		if (!q->lh.head)
+			q->lh.tail = NULL;
+		q->count--;
+	}
+	return elem;
 }
 
-void *queue_wait(void *queue)
+static void queue_send(T_QUEUE queue, T_QUEUE_MESSAGE message, bool head,
+		       OS_ERR_TYPE *err)
 {
 	q_t *q = (q_t *)queue;
-	void *elem = (void *)list_get(&q->lh);
 
+	if (!q || !q->used || !message) {
+		set_error_panic(err, E_OS_ERR);
+		return;
+	}
+	pthread_mutex_lock(&os_mutex);
+	if (q->max_size && q->count >= q->max_size) {
+		pthread_mutex_unlock(&os_mutex);
+		set_error_panic(err, E_OS_ERR_OVERFLOW);
+		return;
+	}
+	queue_push(q, (list_t *)message, head);
+	pthread_cond_signal(&q->cond);
+	pthread_mutex_unlock(&os_mutex);
+	reset_err_ptr(err);
 #ifdef DEBUG_OS
-	pr_debug(LOG_MODULE_OS, "queue_wait: %p -> %p", queue, elem);
+	pr_debug(LOG_MODULE_OS, "queue_put: %p <- %p", queue, message);
 #endif
-	return elem;
 }
 
 void queue_get_message(T_QUEUE queue, T_QUEUE_MESSAGE *message, int timeout,
 		       OS_ERR_TYPE *err)
 {
-	*message = queue_wait(queue);
+	q_t *q = (q_t *)queue;
+	struct timespec deadline;
+	list_t *elem;
+
+	*message = NULL;
+	if (!q || !q->used) {
+		set_error_panic(err, E_OS_ERR);
+		return;
+	}
+	if (timeout != OS_NO_WAIT && timeout != OS_WAIT_FOREVER)
+		deadline_from_ms(&deadline, timeout);
+
+	pthread_mutex_lock(&os_mutex);
+	while ((elem = queue_pop(q)) == NULL && timeout != OS_NO_WAIT) {
+		if (os_cond_wait(&q->cond, &deadline, timeout) == ETIMEDOUT) {
+			elem = queue_pop(q);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&os_mutex);
+
+	if (!elem) {
+		if (err)
+			*err = (timeout == OS_NO_WAIT) ?
+			       E_OS_ERR_EMPTY : E_OS_ERR_TIMEOUT;
+		return;
+	}
+	*message = elem;
+	reset_err_ptr(err);
+#ifdef DEBUG_OS
+	pr_debug(LOG_MODULE_OS, "queue_wait: %p -> %p", queue, elem);
+#endif
 }
 
 void queue_send_message(T_QUEUE queue, T_QUEUE_MESSAGE message,
 			OS_ERR_TYPE *err)
 {
-	queue_put(queue, message);
+	queue_send(queue, message, false, err);
 }
 
 void queue_send_message_head(T_QUEUE queue, T_QUEUE_MESSAGE message,
 			     OS_ERR_TYPE *err)
 {
-	queue_put_head(queue, message);
+	queue_send(queue, message, true, err);
 }
 
 T_QUEUE queue_create(uint32_t max_size)
 {
-	int i, found = 0;
-	q_t *q;
+	q_t *q = NULL;
+	int i;
 
-	for (i = 0; i < 10; i++) {
-		q = &q_pool[i];
-		if (q->used == 0) {
+	pthread_mutex_lock(&os_mutex);
+	for (i = 0; i < OS_LINUX_QUEUES; i++) {
+		if (!q_pool[i].used) {
+			q = &q_pool[i];
 			q->used = 1;
-			found = 1;
 			break;
 		}
 	}
-	if (!found) return (T_QUEUE)NULL;
-	list_init(&q->lh);
+	pthread_mutex_unlock(&os_mutex);
+	if (!q) {
+		pr_error(LOG_MODULE_OS, "no more queues");
+		return (T_QUEUE)NULL;
+	}
+	q->lh.head = q->lh.tail = NULL;
 	q->count = 0;
+	q->max_size = max_size;
+	monotonic_cond_init(&q->cond);
 	return (T_QUEUE)q;
 }
 
 void queue_delete(T_QUEUE queue)
 {
-	void *element = NULL;
 	q_t *q = (q_t *)queue;
 
-	while ((element = list_get(&q->lh)) != NULL)
-		list_remove(&q->lh, element);
-	bfree(q);
+	/* Pending messages are not owned by the queue: they are dropped */
+	pthread_mutex_lock(&os_mutex);
+	q->lh.head = q->lh.tail = NULL;
+	q->count = 0;
+	pthread_cond_destroy(&q->cond);
+	q->used = 0;
+	pthread_mutex_unlock(&os_mutex);
 }
 
 
 /*************************    TIMERS   *************************/
 
-//timer HAL
+/*
+ * Timer HAL: a dedicated thread sleeps until the next requested expiration
+ * and then runs the timer callback with the interrupt lock held.
+ */
+static struct {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	void (*cb)(void *param);
+	void *param;
+	uint64_t deadline_us;
+	bool armed;
+} timer_hal;
+
+static void *timer_hal_thread(void *arg)
+{
+	pthread_mutex_lock(&timer_hal.lock);
+	for (;;) {
+		if (!timer_hal.armed) {
+			pthread_cond_wait(&timer_hal.cond, &timer_hal.lock);
+			continue;
+		}
+		if (monotonic_us() < timer_hal.deadline_us) {
+			struct timespec ts;
+			ts.tv_sec = timer_hal.deadline_us / 1000000;
+			ts.tv_nsec = (timer_hal.deadline_us % 1000000) * 1000;
+			pthread_cond_timedwait(&timer_hal.cond, &timer_hal.lock,
+					       &ts);
+			continue;
+		}
+		timer_hal.armed = false;
+		pthread_mutex_unlock(&timer_hal.lock);
+
+		irq_lock();
+		timer_hal.cb(timer_hal.param);
+		irq_unlock(0);
+
+		pthread_mutex_lock(&timer_hal.lock);
+	}
+	return NULL;
+}
+
 /**
  * this function is called by the os abstraction in order to initialize
  * the hardware timer.
@@ -184,13 +404,26 @@ void queue_delete(T_QUEUE queue)
  *           when it expires.
  * \param param the parameter passed to the callback function.
  */
-void timer_hal_init(void (*cb)(void *param), void *param);
+static void timer_hal_init(void (*cb)(void *param), void *param)
+{
+	timer_hal.cb = cb;
+	timer_hal.param = param;
+	timer_hal.armed = false;
+	pthread_mutex_init(&timer_hal.lock, NULL);
+	monotonic_cond_init(&timer_hal.cond);
+	if (pthread_create(&timer_hal.thread, NULL, timer_hal_thread, NULL))
+		pr_error(LOG_MODULE_OS, "timer thread creation failed");
+}
+
 /**
  * this function should return the current time in ms of the hardware timer.
  *
  * \return the current hardware timer time in milliseconds
  */
-int timer_hal_get_ms();
+static uint32_t timer_hal_get_ms(void)
+{
+	return get_time_ms();
+}
 
 /**
  * This function request the harware timer callback to be called after the
@@ -198,8 +431,17 @@ int timer_hal_get_ms();
  *
  * \param delay the delay after which the timer callback is requested
  */
-void timer_hal_trigger(int delay);
-
+static void timer_hal_trigger(uint32_t delay)
+{
+	/* An already expired timer shows up as a negative delay */
+	if ((int32_t)delay < 0)
+		delay = 0;
+	pthread_mutex_lock(&timer_hal.lock);
+	timer_hal.deadline_us = monotonic_us() + (uint64_t)delay * 1000;
+	timer_hal.armed = true;
+	pthread_cond_signal(&timer_hal.cond);
+	pthread_mutex_unlock(&timer_hal.lock);
+}
 /**
  * Timer internal structure.
  * This structure is allocated by timer_create()
@@ -403,6 +645,7 @@ void timer_delete(T_TIMER tmr)
 
 /*************************    SEMAPHORES   *************************/
 typedef struct {
+	pthread_cond_t cond;
 	uint32_t available;
 	uint32_t waiting;
 } sem_t;
@@ -414,6 +657,7 @@ T_SEMAPHORE semaphore_create(uint32_t initialCount)
 	if (sem == NULL) {
 		pr_error(LOG_MODULE_OS, "panic!");
 	} else {
+		monotonic_cond_init(&sem->cond);
 		sem->available = initialCount;
 		sem->waiting = 0;
 	}
@@ -426,13 +670,13 @@ void semaphore_delete(T_SEMAPHORE semaphore)
 	sem_t *sema = (sem_t *)semaphore;
 
 	/* Make sure nobody is waiting on it otherwise report a failure */
-	int flags = irq_lock();
-
+	pthread_mutex_lock(&os_mutex);
 	if (sema->waiting != 0) {
 		pr_error(LOG_MODULE_OS, "panic!");
 	}
-	irq_unlock(flags);
+	pthread_mutex_unlock(&os_mutex);
 
+	pthread_cond_destroy(&sema->cond);
 	bfree((void *)semaphore);
 }
 
@@ -442,41 +686,38 @@ void semaphore_give(T_SEMAPHORE semaphore, OS_ERR_TYPE *err)
 
 	reset_err_ptr(err);
 
-	int flags = irq_lock();
+	pthread_mutex_lock(&os_mutex);
 	sema->available++;
-	irq_unlock(flags);
+	pthread_cond_signal(&sema->cond);
+	pthread_mutex_unlock(&os_mutex);
 }
 
 OS_ERR_TYPE semaphore_take(T_SEMAPHORE semaphore, int timeout)
 {
 	sem_t *sema = (sem_t *)semaphore;
 	OS_ERR_TYPE error = E_OS_ERR_TIMEOUT;
-	uint32_t time = timer_hal_get_ms();
+	struct timespec deadline;
 
-	int flags = irq_lock();
+	if (timeout != OS_NO_WAIT && timeout != OS_WAIT_FOREVER)
+		deadline_from_ms(&deadline, timeout);
 
+	pthread_mutex_lock(&os_mutex);
+	if (sema->available == 0 && timeout != OS_NO_WAIT) {
+		sema->waiting++;
+		while (sema->available == 0 &&
+		       os_cond_wait(&sema->cond, &deadline, timeout) !=
+		       ETIMEDOUT) ;
+		sema->waiting--;
+	}
 	if (sema->available > 0) {
 		sema->available--;
 		error = E_OS_OK;
-	} else if (timeout != OS_NO_WAIT) {
-		sema->waiting++;
-
-		do {
-			/* Let a chance to an ISR to give us the semaphore */
-			irq_unlock(flags);
-			flags = irq_lock();
-
-			if (sema->available > 0) {
-				sema->available--;
-				sema->waiting--;
-				error = E_OS_OK;
-				break;
-			}
-		} while (((int)(timer_hal_get_ms() - time) < timeout) ||
-			 (timeout == OS_WAIT_FOREVER));
+	} else if (timeout == OS_NO_WAIT) {
+		/* As on target: busy when the caller did not wait */
+		error = E_OS_ERR_BUSY;
 	}
+	pthread_mutex_unlock(&os_mutex);
 
-	irq_unlock(flags);
 	return error;
 }
 
@@ -486,116 +727,88 @@ int32_t semaphore_get_count(T_SEMAPHORE semaphore, OS_ERR_TYPE *err)
 
 	reset_err_ptr(err);
 
-	int flags = irq_lock();
+	pthread_mutex_lock(&os_mutex);
 	int32_t count = sema->available - sema->waiting;
-	irq_unlock(flags);
+	pthread_mutex_unlock(&os_mutex);
 
 	return count;
 }
 
 /*************************    MUTEXES   *************************/
-// Sema HAL
 int8_t is_in_isr_context()
 {
-	return 0; /* linux runs only non-isr context */
-}
-
-/* List containing all locked mutexes in the system */
-list_head_t mutex_list;
-
-typedef struct {
-	list_t list;
-	uint32_t requestor;
-	uint32_t count;
-} mutex_t;
-
-static bool list_finder_cb(list_t *plist, void *data)
-{
-	return plist == data;
+	/* The timer thread is the only "interrupt" context on linux */
+	return pthread_equal(pthread_self(), timer_hal.thread) ? 1 : 0;
 }
 
 T_MUTEX mutex_create(void)
 {
-	mutex_t *pmutex = (mutex_t *)balloc(sizeof(mutex_t), NULL);
+	pthread_mutex_t *pmutex =
+		(pthread_mutex_t *)balloc(sizeof(pthread_mutex_t), NULL);
+	pthread_mutexattr_t attr;
 
 	if (pmutex == NULL) {
 		pr_error(LOG_MODULE_OS, "panic!");
-	} else {
-		pmutex->requestor = (uint32_t)__builtin_return_address(0);
-		pmutex->count = 0;
+		return NULL;
 	}
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(pmutex, &attr);
+	pthread_mutexattr_destroy(&attr);
 
 	return (T_MUTEX)pmutex;
 }
 
 void mutex_delete(T_MUTEX mutex)
 {
-	int flags = irq_lock();
-
 	if (mutex == NULL) {
 		pr_error(LOG_MODULE_OS, "panic!");
-	} else if (list_find_first(&mutex_list, list_finder_cb,
-				   mutex) != NULL) {
+	} else if (pthread_mutex_destroy((pthread_mutex_t *)mutex) == EBUSY) {
+		/* Deleting a locked mutex is a bug */
 		pr_error(LOG_MODULE_OS, "panic!");
 	} else {
 		bfree((void *)mutex);
 	}
-
-	irq_unlock(flags);
 }
 
 void mutex_unlock(T_MUTEX mutex)
 {
-	mutex_t *pmutex = (mutex_t *)mutex;
-
 	if ((is_in_isr_context() != 0) || (mutex == NULL)) {
 		pr_error(LOG_MODULE_OS, "panic!");
 	} else {
-		int flags = irq_lock();
-
-		if (list_find_first(&mutex_list, list_finder_cb,
-				    mutex) != NULL) {
-			pmutex->count--;
-
-			if (pmutex->count == 0)
-				list_remove(&mutex_list, &pmutex->list);
-		}
-
-		irq_unlock(flags);
+		pthread_mutex_unlock((pthread_mutex_t *)mutex);
 	}
 }
 
 OS_ERR_TYPE mutex_lock(T_MUTEX mutex, int timeout)
 {
-	mutex_t *pmutex = (mutex_t *)mutex;
-	OS_ERR_TYPE error = E_OS_ERR_TIMEOUT;
-
-	if ((is_in_isr_context() != 0) || (mutex == NULL)) {
-		error = E_OS_ERR_NOT_ALLOWED;
-	} else {
-		int flags = irq_lock();
-
-		pmutex->count++;
-
-		/* If mutex not already locked add it to the lock list */
-		if (list_find_first(&mutex_list, list_finder_cb,
-				    mutex) == NULL) {
-			list_add(&mutex_list, &pmutex->list);
-		}
-		error = E_OS_OK;
-
-		irq_unlock(flags);
+	pthread_mutex_t *pmutex = (pthread_mutex_t *)mutex;
+	struct timespec deadline;
+
+	if ((is_in_isr_context() != 0) || (mutex == NULL))
+		return E_OS_ERR_NOT_ALLOWED;
+
+	if (timeout == OS_WAIT_FOREVER)
+		return pthread_mutex_lock(pmutex) ? E_OS_ERR : E_OS_OK;
+	if (timeout == OS_NO_WAIT)
+		return pthread_mutex_trylock(pmutex) ? E_OS_ERR_BUSY : E_OS_OK;
+
+	/* pthread_mutex_timedlock() is specified against CLOCK_REALTIME */
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeout / 1000;
+	deadline.tv_nsec += (timeout % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
 	}
-
-	return error;
+	return pthread_mutex_timedlock(pmutex, &deadline) ?
+	       E_OS_ERR_TIMEOUT : E_OS_OK;
 }
 
 /*************************    INIT   *************************/
 void os_init()
 {
 	timer_hal_init(timer_callback, NULL);
-
-	list_init(&mutex_list);
 }
 
 /** @} */
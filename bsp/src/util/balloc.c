@@ -35,6 +35,7 @@
  */
 
 #include <zephyr.h>
+#include <stddef.h>
 #include <stdio.h>
 
 #include "os/os.h"
@@ -43,13 +44,14 @@
 #include "infra/tcmd/handler.h"
 #include "infra/time.h"
 #include "util/compiler.h"
+#include "util/misc.h"
 
-#ifdef CONFIG_MEMORY_POOLS_BALLOC_TRACK_OWNER
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_STATISTICS
 #include "misc/printk.h"
 #include <string.h>
-#ifdef CONFIG_NANOKERNEL
-#include <nanokernel.h>
 #endif
+#if defined(CONFIG_MEMORY_POOLS_BALLOC_TRACK_OWNER) && defined(CONFIG_NANOKERNEL)
+#include <nanokernel.h>
 #endif
 
 #define BITS_PER_U32 (sizeof(uint32_t) * 8)
@@ -72,6 +74,11 @@ typedef struct {
 	uint32_t cur;           /** current number of allocated blocks */
 	uint32_t sum;           /** Cumulative size in bytes */
 	uint32_t nbrs;          /** Cumulative block allocated */
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_HISTOGRAM
+	uint8_t *bucket;        /** histogram bucket of each allocated block */
+	uint32_t fallback;      /** requests of this class served by a larger pool */
+	uint32_t fail;          /** requests of this class that found no block */
+#endif
 #endif
 }T_POOL_DESC;
 
@@ -79,19 +86,45 @@ typedef struct {
 ************** Private variables  ************************
 **********************************************************/
 
+/** Memory blocks of all the pools, contiguous and in pool order */
+typedef struct {
+#define DECLARE_MEMORY_POOL(index, size, count)	\
+	uint8_t mblock_ ## index[count][size];
+#include "memory_pool_list.def"
+} T_POOL_ARENA;
+
+static T_POOL_ARENA mpool_arena __aligned(4);
+
 #ifdef CONFIG_MEMORY_POOLS_BALLOC_STATISTICS
 
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_HISTOGRAM
+/** Requested sizes are counted in buckets of a quarter power of two */
+#define BALLOC_HIST_BUCKETS 40
+
+static uint32_t hist_count[BALLOC_HIST_BUCKETS];
+static uint16_t hist_live[BALLOC_HIST_BUCKETS];
+static uint16_t hist_peak[BALLOC_HIST_BUCKETS];
+
+#define DECLARE_POOL_HIST(index, count)	\
+	uint8_t mblock_bucket_ ## index[count];
+#define POOL_HIST_DESC(index) \
+	, mblock_bucket_ ## index, 0, 0
+#else
+#define DECLARE_POOL_HIST(index, count)
+#define POOL_HIST_DESC(index)
+#endif
+
 /** Allocate the memory blocks and tracking variables for each pool */
 #ifdef CONFIG_MEMORY_POOLS_BALLOC_TRACK_OWNER
 #define DECLARE_MEMORY_POOL(index, size, count)	\
-	uint8_t mblock_ ## index[count][size] __aligned(4);	\
 	uint32_t mblock_alloc_track_ ## index[count / BITS_PER_U32 + 1] = { 0 }; \
-	uint32_t *mblock_owners_ ## index[count] = { 0 };
+	uint32_t *mblock_owners_ ## index[count] = { 0 }; \
+	DECLARE_POOL_HIST(index, count)
 #else
 #define DECLARE_MEMORY_POOL(index, size, count)	\
-	uint8_t mblock_ ## index[count][size] __aligned(4);	\
 	uint32_t mblock_alloc_track_ ## index[count / BITS_PER_U32 + \
-					      1] = { 0 };
+					      1] = { 0 }; \
+	DECLARE_POOL_HIST(index, count)
 #endif
 
 #include "memory_pool_list.def"
@@ -104,8 +137,8 @@ T_POOL_DESC mpool[] =
 #define DECLARE_MEMORY_POOL(index, size, count)	\
 	{ \
 /* T_POOL_DESC.track */ mblock_alloc_track_ ## index, \
-/* T_POOL_DESC.start */ (uint32_t)mblock_ ## index,	\
-/* T_POOL_DESC.end */ (uint32_t)mblock_ ## index + count * size, \
+/* T_POOL_DESC.start */ (uint32_t)mpool_arena.mblock_ ## index, \
+/* T_POOL_DESC.end */ (uint32_t)mpool_arena.mblock_ ## index + count * size, \
 /* T_POOL_DESC.count */ count, \
 /* T_POOL_DESC.size */ size, \
 /* T_POOL_DESC.owners */ mblock_owners_ ## index, \
@@ -113,19 +146,21 @@ T_POOL_DESC mpool[] =
 /* T_POOL_DESC.cur */ 0, \
 /* T_POOL_DESC.sum */ 0, \
 /* T_POOL_DESC.nbrs */ 0 \
+	POOL_HIST_DESC(index) \
 	},
 #else
 #define DECLARE_MEMORY_POOL(index, size, count)	\
 	{ \
 /* T_POOL_DESC.track */ mblock_alloc_track_ ## index, \
-/* T_POOL_DESC.start */ (uint32_t)mblock_ ## index,	\
-/* T_POOL_DESC.end */ (uint32_t)mblock_ ## index + count * size, \
+/* T_POOL_DESC.start */ (uint32_t)mpool_arena.mblock_ ## index, \
+/* T_POOL_DESC.end */ (uint32_t)mpool_arena.mblock_ ## index + count * size, \
 /* T_POOL_DESC.count */ count, \
 /* T_POOL_DESC.size */ size, \
 /* T_POOL_DESC.max */ 0, \
 /* T_POOL_DESC.cur */ 0, \
 /* T_POOL_DESC.sum */ 0, \
 /* T_POOL_DESC.nbrs */ 0 \
+	POOL_HIST_DESC(index) \
 	},
 #endif
 
@@ -137,7 +172,6 @@ T_POOL_DESC mpool[] =
 
 /** Allocate the memory blocks and tracking variables for each pool */
 #define DECLARE_MEMORY_POOL(index, size, count)	\
-	uint8_t mblock_ ## index[count][size]; \
 	uint32_t mblock_alloc_track_ ## index[count / BITS_PER_U32 + 1] = { 0 };
 
 #include "memory_pool_list.def"
@@ -150,8 +184,8 @@ T_POOL_DESC mpool [] =
 #define DECLARE_MEMORY_POOL(index, size, count)	\
 	{ \
 /* T_POOL_DESC.track */ mblock_alloc_track_ ## index, \
-/* T_POOL_DESC.start */ (uint32_t)mblock_ ## index,	\
-/* T_POOL_DESC.end */ (uint32_t)mblock_ ## index + count * size, \
+/* T_POOL_DESC.start */ (uint32_t)mpool_arena.mblock_ ## index, \
+/* T_POOL_DESC.end */ (uint32_t)mpool_arena.mblock_ ## index + count * size, \
 /* T_POOL_DESC.count */ count, \
 /* T_POOL_DESC.size */ size \
 	},
@@ -167,49 +201,173 @@ T_POOL_DESC mpool [] =
 /** Number of memory pools */
 #define NB_MEMORY_POOLS   (sizeof(mpool) / sizeof(T_POOL_DESC))
 
+/* Pools are selected through a 32 bits availability mask */
+STATIC_ASSERT(NB_MEMORY_POOLS <= BITS_PER_U32);
+
+/** Requested sizes are mapped to pools by granules of 4 bytes */
+#define BALLOC_SIZE_SHIFT 2
+/** The arena is mapped to pools by chunks of 64 bytes */
+#define BALLOC_CHUNK_SHIFT 6
+
+/*
+ * Block sizes must be multiples of the granule, which also keeps every
+ * block of the arena 4 bytes aligned. Each pool must span at least one
+ * chunk so that a chunk never overlaps more than two pools.
+ */
+#define DECLARE_MEMORY_POOL(index, size, count)	\
+	STATIC_ASSERT((size) % (1 << BALLOC_SIZE_SHIFT) == 0); \
+	STATIC_ASSERT((size) * (count) >= (1 << BALLOC_CHUNK_SHIFT));
+#include "memory_pool_list.def"
+
+/** Largest block size */
+typedef union {
+#define DECLARE_MEMORY_POOL(index, size, count)	\
+	uint8_t size_ ## index[size];
+#include "memory_pool_list.def"
+} T_POOL_MAX_BLOCK;
+#define BALLOC_MAX_SIZE sizeof(T_POOL_MAX_BLOCK)
+
+/**
+ * Pool serving each requested size, indexed by size granule.
+ *
+ * Each pool sets the granules above its block size to the next pool.
+ * Later ranges override earlier ones, so with pools sorted by increasing
+ * block size every granule maps to the first pool large enough.
+ */
+static const uint8_t mpool_size_class[(BALLOC_MAX_SIZE >> BALLOC_SIZE_SHIFT) +
+				      2] = {
+#define DECLARE_MEMORY_POOL(index, size, count)	\
+	[((size) >> BALLOC_SIZE_SHIFT) + 1 ... \
+	 (BALLOC_MAX_SIZE >> BALLOC_SIZE_SHIFT) + 1] = (index) + 1,
+#include "memory_pool_list.def"
+};
+
+/**
+ * Pool owning the end of each chunk of the arena.
+ *
+ * A chunk shared by two pools maps to the second one, so a pointer below
+ * the start of the mapped pool belongs to the previous pool.
+ */
+static const uint8_t mpool_chunk[((sizeof(T_POOL_ARENA) - 1) >>
+				  BALLOC_CHUNK_SHIFT) + 1] = {
+#define DECLARE_MEMORY_POOL(index, size, count)	\
+	[offsetof(T_POOL_ARENA, mblock_ ## index) >> BALLOC_CHUNK_SHIFT ... \
+	 (offsetof(T_POOL_ARENA, mblock_ ## index) + (size) * (count) - 1) >> \
+	 BALLOC_CHUNK_SHIFT] = (index),
+#include "memory_pool_list.def"
+};
+
+/** Number of free blocks of each pool */
+static uint16_t mpool_free[] = {
+#define DECLARE_MEMORY_POOL(index, size, count)	\
+	(count),
+#include "memory_pool_list.def"
+};
+
+/** Mask of the pools having at least one free block */
+static uint32_t mpool_avail =
+	(uint32_t)(((uint64_t)1 << NB_MEMORY_POOLS) - 1);
+
 /**********************************************************
 ************** Private functions  ************************
 **********************************************************/
 
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_HISTOGRAM
+/**
+ * Return the histogram bucket of a requested size.
+ *
+ * Sizes up to 16 bytes use 4 bytes buckets, larger sizes are split in
+ * 4 buckets per power of two, so that every bucket bound is a multiple
+ * of 4 and a possible pool size.
+ */
+static uint8_t hist_bucket(uint32_t size)
+{
+	uint32_t k, idx;
+
+	if (size <= 16)
+		return (size - 1) >> 2;
+	/* 2^(k-1) < size <= 2^k */
+	k = 32 - __builtin_clz(size - 1);
+	idx = 4 + (k - 5) * 4 + ((size - 1 - (1 << (k - 1))) >> (k - 3));
+	return idx < BALLOC_HIST_BUCKETS ? idx : BALLOC_HIST_BUCKETS - 1;
+}
+
+/** Return the largest size counted in a histogram bucket */
+static uint32_t hist_bound(uint8_t idx)
+{
+	uint32_t k;
+
+	if (idx < 4)
+		return (idx + 1) * 4;
+	k = 5 + (idx - 4) / 4;
+	return (1 << (k - 1)) + ((idx - 4) % 4 + 1) * (1 << (k - 3));
+}
+
+/**
+ * Account a successful allocation in the histogram.
+ *
+ * @param req_pool first pool large enough for the request
+ * @param pool pool the block was taken from
+ * @param ptr allocated block
+ * @param size requested size
+ */
+static void hist_alloc(uint8_t req_pool, uint8_t pool, void *ptr,
+		       uint32_t size)
+{
+	uint16_t block = ((uint32_t)ptr - mpool[pool].start) /
+			 mpool[pool].size;
+	uint8_t b = hist_bucket(size);
+	uint32_t flags = irq_lock();
+
+	mpool[pool].bucket[block] = b;
+	hist_count[b]++;
+	if (++hist_live[b] > hist_peak[b])
+		hist_peak[b] = hist_live[b];
+	if (pool != req_pool)
+		mpool[req_pool].fallback++;
+	irq_unlock(flags);
+}
+#endif
+
 /**
  * Return the next free block of a pool and
  *   mark it as reserved/allocated.
  *
+ * Must be called with interrupts locked, on a pool
+ * flagged in mpool_avail.
+ *
  * @param pool index of the pool in mpool
  *
- * @return allocated buffer or NULL if none is
- *   available
+ * @return allocated buffer
  */
 static void *memblock_alloc(uint32_t pool)
 {
+	uint32_t *track = mpool[pool].track;
 	uint16_t block;
-	uint32_t flags = irq_lock();
+	uint32_t unused;
+
+	/* The pool has a free block: find the first word showing it */
+	while (!(unused = ~*track))
+		track++;
+	block = (track - mpool[pool].track) * BITS_PER_U32 +
+		__builtin_clz(unused);
+	*track |= 1 << (BITS_PER_U32 - 1 - (block % BITS_PER_U32));
 
-	for (block = 0; block < mpool[pool].count; block++) {
-		if (((mpool[pool].track)[block / BITS_PER_U32] & 1 <<
-		     (BITS_PER_U32 - 1 - (block % BITS_PER_U32))) == 0) {
-			(mpool[pool].track)[block / BITS_PER_U32] =
-				(mpool[pool].track)[block / BITS_PER_U32] |
-				(1 << (BITS_PER_U32 - 1 - (block % BITS_PER_U32)));
+	if (--mpool_free[pool] == 0)
+		mpool_avail &= ~(1 << pool);
 #ifdef CONFIG_MEMORY_POOLS_BALLOC_STATISTICS
-			mpool[pool].cur = mpool[pool].cur + 1;
+	mpool[pool].cur = mpool[pool].cur + 1;
 #ifdef CONFIG_MEMORY_POOLS_BALLOC_TRACK_OWNER
-			/* get return address */
-			uint32_t ret_a = (uint32_t)__builtin_return_address(0);
-			mpool[pool].owners[block] =
-				(uint32_t *)(((ret_a & 0xFFFF0U) >> 4) |
-					     ((get_uptime_ms() & 0xFFFF0) << 12));
+	/* get return address */
+	uint32_t ret_a = (uint32_t)__builtin_return_address(0);
+	mpool[pool].owners[block] =
+		(uint32_t *)(((ret_a & 0xFFFF0U) >> 4) |
+			     ((get_uptime_ms() & 0xFFFF0) << 12));
 #endif
-			if (mpool[pool].cur > mpool[pool].max)
-				mpool[pool].max = mpool[pool].cur;
+	if (mpool[pool].cur > mpool[pool].max)
+		mpool[pool].max = mpool[pool].cur;
 #endif
-			irq_unlock(flags);
-			return (void *)(mpool[pool].start +
-					mpool[pool].size * block);
-		}
-	}
-	irq_unlock(flags);
-	return NULL;
+	return (void *)(mpool[pool].start + mpool[pool].size * block);
 }
 
 
@@ -233,9 +391,14 @@ static void memblock_free(uint32_t pool, void *ptr)
 		flags = irq_lock();
 		(mpool[pool].track)[block / BITS_PER_U32] &=
 			~(1 << (BITS_PER_U32 - 1 - (block % BITS_PER_U32)));
+		mpool_free[pool]++;
+		mpool_avail |= 1 << pool;
 		irq_unlock(flags);
 #ifdef CONFIG_MEMORY_POOLS_BALLOC_STATISTICS
 		mpool[pool].cur = mpool[pool].cur - 1;
+#endif
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_HISTOGRAM
+		hist_live[mpool[pool].bucket[block]]--;
 #endif
 	} else {
 		pr_debug(
@@ -274,7 +437,6 @@ static bool memblock_used(uint32_t pool, void *ptr)
 
 
 #ifdef CONFIG_MEMORY_POOLS_BALLOC_STATISTICS
-#ifdef CONFIG_MEMORY_POOLS_BALLOC_TRACK_OWNER
 
 #define PRINT_METHOD_PRINTK   0
 #define PRINT_METHOD_TCMD_RSP 1
@@ -291,6 +453,8 @@ static bool memblock_used(uint32_t pool, void *ptr)
 			local_task_sleep_ms(100); \
 		} \
 	} while (0);
+
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_TRACK_OWNER
 static void print_pool(int method, void *ctx)
 {
 	char tmp[128];
@@ -349,7 +513,44 @@ static void print_pool(int method, void *ctx)
 	}
 	PRINT_POOL(method, "*** END", ctx);
 }
+#endif
+
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_HISTOGRAM
+/**
+ * Print the pool classes and the requested size histogram.
+ *
+ * Each "hist" entry is <bucket bound>:<allocations>/<peak live blocks>.
+ * This output is the input of tools/tests/pool_advisor.c.
+ */
+static void print_hist(int method, void *ctx)
+{
+	char tmp[128];
+	int len = 0;
+	uint32_t pool;
+	uint8_t b;
 
+	for (pool = 0; pool < NB_MEMORY_POOLS; pool++) {
+		snprintf(tmp, sizeof(tmp),
+			 "class %d bytes count:%d max:%d fallback:%d fail:%d",
+			 mpool[pool].size, mpool[pool].count, mpool[pool].max,
+			 mpool[pool].fallback, mpool[pool].fail);
+		PRINT_POOL(method, tmp, ctx);
+	}
+	for (b = 0; b < BALLOC_HIST_BUCKETS; b++) {
+		if (!hist_count[b])
+			continue;
+		if (len == 0)
+			len = snprintf(tmp, sizeof(tmp), "hist");
+		len += snprintf(tmp + len, sizeof(tmp) - len, " %d:%d/%d",
+				hist_bound(b), hist_count[b], hist_peak[b]);
+		if (len > 80) {
+			PRINT_POOL(method, tmp, ctx);
+			len = 0;
+		}
+	}
+	if (len)
+		PRINT_POOL(method, tmp, ctx);
+}
 #endif
 #endif
 
@@ -405,48 +606,49 @@ void *balloc(uint32_t size, OS_ERR_TYPE *err)
 {
 	OS_ERR_TYPE localErr = E_OS_OK;
 	void *buffer = NULL;
-	uint8_t poolIdx;
+	uint8_t poolIdx, reqIdx;
+	uint32_t avail;
+	uint32_t flags;
 
-	if (size > 0) {
-		/* find the first block size greater or equal to requested size */
-		poolIdx = 0;
-		while (poolIdx < NB_MEMORY_POOLS &&
-		       (size > mpool[poolIdx].size))
-			poolIdx++;
+	if (size > 0 && size <= BALLOC_MAX_SIZE) {
+		/* first pool whose block size is greater or equal to requested size */
+		reqIdx = mpool_size_class[(size + (1 << BALLOC_SIZE_SHIFT) - 1) >>
+					  BALLOC_SIZE_SHIFT];
 
-		/* reserve the block */
-		if (poolIdx < NB_MEMORY_POOLS) {
+		flags = irq_lock();
 #ifdef MALLOC_ALLOW_OUTCLASS
-			/* loop until an available (maybe larger) block is found */
-			do {
-				if (size <= mpool[poolIdx].size) { /* this condition may be false if pools are not sorted according to block size */
+		/* use a larger block when all blocks of this size are reserved */
+		avail = mpool_avail & (~0U << reqIdx);
+#else
+		avail = mpool_avail & (1U << reqIdx);
 #endif
+		if (avail) {
+			poolIdx = __builtin_ctz(avail);
 			buffer = memblock_alloc(poolIdx);
+		}
+		irq_unlock(flags);
+
+		if (NULL == buffer) { /* All blocks of relevant size are already reserved */
+			pr_debug(LOG_MODULE_UTIL,
+				 "Attempt to allocate %d bytes failed",
+				 size);
+			localErr = E_OS_ERR_NO_MEMORY;
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_HISTOGRAM
+			mpool[reqIdx].fail++;
+#endif
+		} else {
 #ifdef CONFIG_MEMORY_POOLS_BALLOC_STATISTICS
-			if ((buffer != NULL) &&
-			    ((poolIdx == 0) ||
-			     (size > mpool[poolIdx - 1].size))) {
+			if (poolIdx == reqIdx) {
 				mpool[poolIdx].nbrs += 1;
 				mpool[poolIdx].sum += size;
 			}
 #endif
-#ifdef MALLOC_ALLOW_OUTCLASS
-		}
-
-		if (NULL == buffer)
-			poolIdx++;
-	}
-	while ((poolIdx < NB_MEMORY_POOLS) && (NULL == buffer)) ;
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_HISTOGRAM
+			hist_alloc(reqIdx, poolIdx, buffer, size);
 #endif
-			if (NULL == buffer) { /* All blocks of relevant size are already reserved */
-				pr_debug(LOG_MODULE_UTIL,
-					 "Attempt to allocate %d bytes failed",
-					 size);
-				localErr = E_OS_ERR_NO_MEMORY;
-			}
-		} else { /* Configuration does not define blocks large enough for the requested size */
-			localErr = E_OS_ERR_NOT_ALLOWED;
 		}
+	} else if (size > 0) { /* Configuration does not define blocks large enough for the requested size */
+		localErr = E_OS_ERR_NOT_ALLOWED;
 	} else { /* invalid function parameter */
 		localErr = E_OS_ERR;
 	}
@@ -496,32 +698,28 @@ void *balloc(uint32_t size, OS_ERR_TYPE *err)
 OS_ERR_TYPE bfree(void *buffer)
 {
 	OS_ERR_TYPE err = E_OS_ERR;
+	uint32_t offset = (uint32_t)buffer - (uint32_t)&mpool_arena;
 	uint8_t poolIdx;
 	unsigned int imask;
 
 	/* find which pool the buffer was allocated from */
-	poolIdx = 0;
-	while ((NULL != buffer) && (poolIdx < NB_MEMORY_POOLS)) {
-		/* check if buffer is within mpool[poolIdx] */
-		if (((uint32_t)buffer >= mpool[poolIdx].start) &&
-		    ((uint32_t)buffer < mpool[poolIdx].end)) {
-			imask = irq_lock();
-			if (false != memblock_used(poolIdx, buffer)) {
-				memblock_free(poolIdx, buffer);
-				err = E_OS_OK;
-			}
-			/* else: buffer is not marked as used, keep err = E_OS_ERR */
-			else {
-				pr_debug(
-					LOG_MODULE_UTIL,
-					"ERR: memory_free: buffer %p is already free\n",
-					buffer);
-			}
-			irq_unlock(imask);
-			buffer = NULL;  /* buffer was found in the pools, end the loop */
-		} else {                /* buffer does not belong to mpool[poolIdx], go to the next one */
-			poolIdx++;
+	if (offset < sizeof(mpool_arena)) {
+		poolIdx = mpool_chunk[offset >> BALLOC_CHUNK_SHIFT];
+		if ((uint32_t)buffer < mpool[poolIdx].start)
+			poolIdx--;
+		imask = irq_lock();
+		if (false != memblock_used(poolIdx, buffer)) {
+			memblock_free(poolIdx, buffer);
+			err = E_OS_OK;
 		}
+		/* else: buffer is not marked as used, keep err = E_OS_ERR */
+		else {
+			pr_debug(
+				LOG_MODULE_UTIL,
+				"ERR: memory_free: buffer %p is already free\n",
+				buffer);
+		}
+		irq_unlock(imask);
 	}
 	return err;
 }
@@ -533,11 +731,21 @@ void tcmd_pool(int argc, char *argv[], struct tcmd_handler_ctx *ctx)
 {
 #ifdef CONFIG_QUARK
 	/* Display with TCMD response on Quark */
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_HISTOGRAM
+	print_hist(PRINT_METHOD_TCMD_RSP, ctx);
+#endif
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_TRACK_OWNER
 	print_pool(PRINT_METHOD_TCMD_RSP, ctx);
 #endif
+#endif
 #ifdef CONFIG_ARC
 	/* Display with pr_info on ARC to avoid message overflow and panic */
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_HISTOGRAM
+	print_hist(PRINT_METHOD_PR_INFO, ctx);
+#endif
+#ifdef CONFIG_MEMORY_POOLS_BALLOC_TRACK_OWNER
 	print_pool(PRINT_METHOD_PR_INFO, ctx);
+#endif
 #endif
 	TCMD_RSP_FINAL(ctx, "");
 }
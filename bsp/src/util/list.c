@@ -28,7 +28,11 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#ifdef CONFIG_OS_LINUX
+#include "os/os.h"
+#else
 #include <zephyr.h>
+#endif
 #include "util/list.h"
 
 void list_init(list_head_t *list)
@@ -52,7 +52,7 @@ void wakelock_test(void)
 	int ret;
 
 	// Declare wakelock for test
-	struct pm_wakelock pm0;
+	static struct pm_wakelock pm0;
 
 	cu_print("##################################################\n");
 	cu_print("# Purpose of wakelock tests (No HW cfg needed):  #\n");
@@ -63,7 +63,7 @@ void qrk_pwm_test(void)
 {
 	struct td_device *dev = &pf_device_pwm;
 	struct soc_pwm_channel_config config0, config1;
-	struct pm_wakelock pwm_wakelock;
+	static struct pm_wakelock pwm_wakelock;
 
 	cu_print("##################################################\n");
 	cu_print("# Purpose of PWM tests :                         #\n");
@@ -120,6 +120,8 @@ struct cfw_message {
 	void (*cb)(struct cfw_message *);
 	/** The private data passed with the request. */
 	void *priv;
+	/** Link in the deferred message list of a service, see cfw_defer_message() */
+	list_t deferred;
 };
 
 #define CFW_MESSAGE_ID(msg)     MESSAGE_ID(&(msg)->m)
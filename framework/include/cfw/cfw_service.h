@@ -113,6 +113,13 @@ typedef struct service {
 	 * deferred by the service to handle concurrent requests.
 	 */
 	list_head_t deferred_message_list;
+	/** Number of messages in the deferred message list */
+	uint8_t deferred_count;
+	/**
+	 * Maximum number of deferred messages, CONFIG_CFW_DEFER_QUEUE_LEN if
+	 * left to 0.
+	 */
+	uint8_t deferred_max;
 	/**
 	 * This callback is called during the system shutdown
 	 * to handle pending client requests.
@@ -322,10 +329,17 @@ void cfw_send_event(struct cfw_message *msg);
  * deferred message will be posted on the service's queue head when
  * cfw_defer_complete() will be called.
  *
+ * The message is linked in the service's deferred list through its header, so
+ * this does not allocate memory. The list is bounded by the service's
+ * deferred_max (or CONFIG_CFW_DEFER_QUEUE_LEN): once it is full, the message
+ * is not deferred and the service is expected to reject it (for instance
+ * with a busy status), so that the client retries later.
+ *
  * @param svc service that defers the message.
  * @param msg message to be deferred.
  *
- * @return 0 if no error occured.
+ * @return 0 if no error occured, E_OS_ERR_OVERFLOW if the deferred list of
+ *         the service is full.
  */
 int cfw_defer_message(service_t *svc, struct cfw_message *msg);
 
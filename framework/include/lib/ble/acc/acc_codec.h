@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __ACC_CODEC_H__
+#define __ACC_CODEC_H__
+
+#include <stdint.h>
+
+/**
+ * @defgroup ble_acc_codec ACC streaming codec
+ *
+ * Lossless streaming codec for 3-axis int16 samples.
+ *
+ * Samples are packed in self-contained packets of at most one notification
+ * payload, so that a lost notification does not prevent the following ones
+ * from being decoded:
+ *
+ *     byte 0     sequence number (wraps around)
+ *     byte 1     number of samples in the packet
+ *     bytes 2..7 first sample, x, y and z as little endian int16
+ *     blocks     the following samples, by blocks of up to
+ *                ACC_CODEC_BLOCK_SAMPLES samples
+ *
+ * Each block starts with one byte giving the bit width w (0 to 16) of its
+ * values, followed by the x, y, z zig-zag encoded deltas (modulo 2^16) of
+ * each sample against the previous one, packed on w bits each, LSB first,
+ * and padded to a byte boundary.
+ *
+ * The reference decoder is tools/scripts/acc_decode.py.
+ *
+ * @ingroup ble_services
+ * @{
+ */
+
+/** Number of samples per bit-packed block */
+#define ACC_CODEC_BLOCK_SAMPLES 4
+
+/** Size of the packet header, including the first (raw) sample */
+#define ACC_CODEC_HEADER_LEN 8
+
+/** Maximum size of an encoded packet */
+#define ACC_CODEC_MAX_PACKET 244
+
+/**
+ * Callback used to send a complete packet.
+ *
+ * @param packet the encoded packet
+ * @param len    the packet length
+ *
+ * @return 0 in case of success or negative value in case of error.
+ */
+typedef int (*acc_codec_send_t)(uint8_t *packet, uint8_t len);
+
+/** Streaming encoder state */
+struct acc_codec {
+	/** Callback sending complete packets */
+	acc_codec_send_t send;
+	/** Maximum packet length (notification payload) */
+	uint8_t max_len;
+	/** Sequence number of the packet being built */
+	uint8_t seq;
+	/** Length of the packet being built, 0 if empty */
+	uint8_t len;
+	/** Number of samples encoded in the packet being built */
+	uint8_t count;
+	/** Number of pending samples, not yet encoded in the packet */
+	uint8_t pending;
+	/** Last sample encoded in the packet */
+	int16_t last[3];
+	/** Samples waiting for their block to be complete */
+	int16_t block[ACC_CODEC_BLOCK_SAMPLES][3];
+	/** Packet being built */
+	uint8_t packet[ACC_CODEC_MAX_PACKET];
+};
+
+/**
+ * Initialize a streaming encoder.
+ *
+ * @param codec   the encoder
+ * @param send    the callback sending complete packets
+ * @param max_len the maximum packet length, ie the notification payload
+ *                (ATT MTU - 3), between ACC_CODEC_HEADER_LEN + 7 and
+ *                ACC_CODEC_MAX_PACKET
+ *
+ * @return 0 in case of success or -1 if max_len is out of range.
+ */
+int acc_codec_init(struct acc_codec *codec, acc_codec_send_t send,
+		   uint8_t max_len);
+
+/**
+ * Add a sample to the stream.
+ *
+ * The packet being built is sent when it is full. If a previous send failed
+ * with a full block still pending, that block is encoded again first, and
+ * the sample is refused if this fails.
+ *
+ * @param codec  the encoder
+ * @param sample the x, y and z values
+ *
+ * @return 0 in case of success or the error returned by the send callback.
+ */
+int acc_codec_push(struct acc_codec *codec, const int16_t sample[3]);
+
+/**
+ * Encode the pending samples and send the packet being built, if any.
+ *
+ * @param codec  the encoder
+ *
+ * @return 0 in case of success or the error returned by the send callback.
+ */
+int acc_codec_flush(struct acc_codec *codec);
+
+/**
+ * @}
+ */
+
+#endif /* __ACC_CODEC_H__ */
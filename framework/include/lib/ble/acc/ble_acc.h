@@ -76,6 +76,40 @@
   */
  const struct bt_gatt_attr *ble_acc_attr(void);
 
+ #ifdef CONFIG_BLE_ACC_STREAM
+ /**
+  * (Re)start the compressed raw data stream.
+  *
+  * Samples are packed losslessly in notifications of at most payload_len
+  * bytes, each carrying a sequence number. See @ref ble_acc_codec for the
+  * format.
+  *
+  * @param payload_len notification payload length (ATT MTU - 3), or 0 for
+  *                    CONFIG_BLE_ACC_STREAM_PAYLOAD
+  *
+  * @return 0 in case of success or negative value in case of error.
+  */
+ int ble_acc_stream_init(uint8_t payload_len);
+
+ /**
+  * Add a raw sample to the compressed stream.
+  *
+  * A notification is sent each time a packet is full.
+  *
+  * @param sample x, y and z values
+  *
+  * @return 0 in case of success or negative value in case of error.
+  */
+ int ble_acc_stream_push(const int16_t sample[3]);
+
+ /**
+  * Send the pending samples of the compressed stream.
+  *
+  * @return 0 in case of success or negative value in case of error.
+  */
+ int ble_acc_stream_flush(void);
+ #endif
+
  /**
   * @}
   */
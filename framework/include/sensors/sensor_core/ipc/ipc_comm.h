@@ -44,7 +44,12 @@
  * @ingroup sensor_core_ipc
  * @{
  */
-#define MAX_IPC_2CORE_NUM_MSG CONFIG_QUEUE_ELEMENT_POOL_SIZE
+#define MAX_IPC_2CORE_NUM_MSG 32  /* power of 2 */
+/* Slots that only the sensor core itself can fill */
+#define IPC_2CORE_RESERVED_MSG 8
+/* Slots, among the reserved ones, left to the sensor core fiber: the
+ * commands notified from interrupts are dropped instead */
+#define IPC_2CORE_FIBER_RESERVED_MSG 4
 #define MAX_IPC_2SVC_NUM_MSG  100
 
 /**
@@ -110,6 +115,15 @@ extern IPC_ERR_TYPE ipc_svc_core_create();
  */
 extern IPC_ERR_TYPE ipc_core_receive(struct ia_cmd **cmd, int timeout);
 
+/**
+ * @brief sensor_core wait for the messages sent since the previous wait,
+ *        leaving them queued for ipc_core_receive
+ *        Authorized execution levels:  task, fiber.
+ * @param[in] timeout   maximum number of milliseconds to wait for the message.
+ * @return  negative: failure or timeout, 0 success.
+ */
+extern IPC_ERR_TYPE ipc_core_wait(int timeout);
+
 /**
  * @brief SVC send a message  to sensor_core on a queue
  *        Authorized execution levels:  task, fiber, ISR.
@@ -118,6 +132,28 @@ extern IPC_ERR_TYPE ipc_core_receive(struct ia_cmd **cmd, int timeout);
  */
 extern IPC_ERR_TYPE ipc_2core_send(struct ia_cmd *cmd);
 
+/**
+ * @brief Notify sensor_core of an interrupt event
+ *        Unlike ipc_2core_send, never panic: when the sensor core is
+ *        behind, the command is freed and counted as dropped, the drops
+ *        are reported by the next ipc_core_wait.
+ *        Authorized execution levels:  task, fiber, ISR.
+ * @param[in] cmd       common struct to transmit, balloc'ed
+ * @return  IPC_STS_ERR_OVERFLOW: cmd was dropped, 0 success.
+ */
+extern IPC_ERR_TYPE ipc_2core_notify(struct ia_cmd *cmd);
+
+/**
+ * @brief SVC send a client request to sensor_core
+ *        Unlike ipc_2core_send, refuse the request when the sensor core
+ *        is behind, so that the client can be answered instead.
+ *        Authorized execution levels:  task, fiber, ISR.
+ * @param[in] cmd       common struct to transmit
+ * @return  IPC_STS_ERR_OVERFLOW: sensor_core is busy and cmd was not
+ *          sent, the caller still owns it, 0 success.
+ */
+extern IPC_ERR_TYPE ipc_2core_request(struct ia_cmd *cmd);
+
 /**
  * sensor_service recieve message
  * @param[in] cmd       common struct to transmit
@@ -139,6 +139,7 @@ typedef enum {
 	RESP_DEVICE_EXCEPTION,
 	RESP_WRONG_CMD,
 	RESP_INVALID_PARAM,
+	RESP_DEVICE_BUSY,	/* sensor_core has too many pending requests */
 } sensor_service_ret_type;
 
 /**
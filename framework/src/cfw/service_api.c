@@ -32,6 +32,7 @@
 #include <string.h>
 
 #include "util/list.h"
+#include "util/misc.h"
 #include "infra/message.h"
 #include "infra/port.h"
 #include "infra/log.h"
@@ -74,42 +75,39 @@ struct cfw_message *cfw_clone_message(struct cfw_message *msg)
 	return ret;
 }
 
-struct deferred_message {
-	list_t list;
-	struct cfw_message *msg;
-};
-
 int cfw_defer_message(service_t *svc, struct cfw_message *msg)
 {
-	OS_ERR_TYPE err;
+	uint8_t max = svc->deferred_max ? svc->deferred_max :
+		      CONFIG_CFW_DEFER_QUEUE_LEN;
 
 	if (!msg)
 		return E_OS_ERR;
-	struct deferred_message *dm = (struct deferred_message *)
-				      balloc(sizeof(*dm), &err);
-	if (dm == NULL) {
-		return err;
+	if (svc->deferred_count >= max) {
+		pr_warning(LOG_MODULE_CFW, "Deferred list full (svc %d)",
+			   svc->service_id);
+		return E_OS_ERR_OVERFLOW;
 	}
-	dm->msg = msg;
 	MESSAGE_QUEUE_HEAD(&msg->m) = true;
-	list_add(&svc->deferred_message_list, &dm->list);
+	list_add(&svc->deferred_message_list, &msg->deferred);
+	svc->deferred_count++;
 	return E_OS_OK;
 }
 
 int cfw_defer_complete(service_t *svc)
 {
-	struct deferred_message *dm = (struct deferred_message *)
-				      list_get(&svc->deferred_message_list);
+	list_t *element = list_get(&svc->deferred_message_list);
 
-	if (dm != NULL) {
-		assert(dm->msg);
+	if (element != NULL) {
+		struct cfw_message *msg = container_of(element,
+						       struct cfw_message,
+						       deferred);
 		int ret;
-		ret = cfw_send_message(dm->msg);
+		svc->deferred_count--;
+		ret = cfw_send_message(msg);
 		if (ret != E_OS_OK) {
 			pr_error(LOG_MODULE_CFW, "Failed sending deferred msg");
 			panic(-1);
 		}
-		bfree(dm);
 		return ret;
 	}
 	return E_OS_OK;
@@ -123,6 +121,7 @@ int cfw_register_service(T_QUEUE queue, service_t *svc,
 	cfw_port_set_handler(port_id, handle_message, data);
 	svc->port_id = port_id;
 	list_init(&svc->deferred_message_list);
+	svc->deferred_count = 0;
 	return _cfw_register_service(svc);
 }
 
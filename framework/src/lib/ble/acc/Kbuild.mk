@@ -1 +1,2 @@
 obj-$(CONFIG_BLE_ACC_LIB) += ble_acc.o
+obj-$(CONFIG_BLE_ACC_STREAM) += acc_codec.o
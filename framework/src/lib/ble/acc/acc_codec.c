@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "lib/ble/acc/acc_codec.h"
+
+/* Zig-zag encoding of the delta between two samples, modulo 2^16 */
+static uint16_t zigzag_delta(int16_t cur, int16_t prev)
+{
+	int16_t delta = (int16_t)(uint16_t)((uint16_t)cur - (uint16_t)prev);
+
+	return (uint16_t)(((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15));
+}
+
+static uint8_t bit_width(uint16_t value)
+{
+	uint8_t width = 0;
+
+	while (value) {
+		width++;
+		value >>= 1;
+	}
+	return width;
+}
+
+/* Bit width needed to encode the first nb pending samples */
+static uint8_t block_width(struct acc_codec *codec, int nb)
+{
+	const int16_t *prev = codec->last;
+	uint16_t bits = 0;
+	int i, axis;
+
+	for (i = 0; i < nb; i++) {
+		for (axis = 0; axis < 3; axis++)
+			bits |= zigzag_delta(codec->block[i][axis], prev[axis]);
+		prev = codec->block[i];
+	}
+	return bit_width(bits);
+}
+
+static int block_len(int nb, uint8_t width)
+{
+	return 1 + (3 * nb * width + 7) / 8;
+}
+
+static void start_packet(struct acc_codec *codec, const int16_t sample[3])
+{
+	uint8_t *p = &codec->packet[2];
+	int axis;
+
+	for (axis = 0; axis < 3; axis++) {
+		*p++ = (uint16_t)sample[axis] & 0xFF;
+		*p++ = (uint16_t)sample[axis] >> 8;
+		codec->last[axis] = sample[axis];
+	}
+	codec->len = ACC_CODEC_HEADER_LEN;
+	codec->count = 1;
+}
+
+static int send_packet(struct acc_codec *codec)
+{
+	int ret;
+
+	if (!codec->len)
+		return 0;
+	codec->packet[0] = codec->seq++;
+	codec->packet[1] = codec->count;
+	ret = codec->send(codec->packet, codec->len);
+	codec->len = 0;
+	codec->count = 0;
+	return ret;
+}
+
+/* Append the first nb pending samples as a block */
+static void append_block(struct acc_codec *codec, int nb, uint8_t width)
+{
+	uint8_t *p = &codec->packet[codec->len];
+	uint32_t acc = 0;
+	int acc_bits = 0;
+	int i, axis;
+
+	*p++ = width;
+	memset(p, 0, block_len(nb, width) - 1);
+	for (i = 0; i < nb; i++) {
+		for (axis = 0; axis < 3; axis++) {
+			acc |= (uint32_t)zigzag_delta(codec->block[i][axis],
+						      codec->last[axis])
+			       << acc_bits;
+			acc_bits += width;
+			while (acc_bits >= 8) {
+				*p++ = acc & 0xFF;
+				acc >>= 8;
+				acc_bits -= 8;
+			}
+		}
+		memcpy(codec->last, codec->block[i], sizeof(codec->last));
+	}
+	if (acc_bits)
+		*p = acc & 0xFF;
+	codec->len += block_len(nb, width);
+	codec->count += nb;
+	codec->pending -= nb;
+	memmove(codec->block, codec->block[nb],
+		codec->pending * sizeof(codec->block[0]));
+}
+
+/*
+ * Encode the pending samples, by complete blocks unless flushing. A block
+ * shorter than ACC_CODEC_BLOCK_SAMPLES can only be the last one of a packet,
+ * so the packet is sent right after.
+ */
+static int encode_pending(struct acc_codec *codec, bool flush)
+{
+	int ret = 0;
+
+	while (codec->pending && (flush || !codec->len ||
+				  codec->pending >= ACC_CODEC_BLOCK_SAMPLES)) {
+		int nb = codec->pending;
+		uint8_t width;
+
+		if (!codec->len) {
+			start_packet(codec, codec->block[0]);
+			codec->pending--;
+			memmove(codec->block, codec->block[1],
+				codec->pending * sizeof(codec->block[0]));
+			continue;
+		}
+		if (codec->count + nb > UINT8_MAX)
+			nb = 0;
+		for (; nb > 0; nb--) {
+			width = block_width(codec, nb);
+			if (codec->len + block_len(nb, width) <= codec->max_len)
+				break;
+		}
+		if (nb)
+			append_block(codec, nb, width);
+		if (nb < ACC_CODEC_BLOCK_SAMPLES) {
+			ret = send_packet(codec);
+			if (ret)
+				break;
+		}
+	}
+	return ret;
+}
+
+int acc_codec_init(struct acc_codec *codec, acc_codec_send_t send,
+		   uint8_t max_len)
+{
+	if (max_len < ACC_CODEC_HEADER_LEN + 7 ||
+	    max_len > ACC_CODEC_MAX_PACKET)
+		return -1;
+	memset(codec, 0, sizeof(*codec));
+	codec->send = send;
+	codec->max_len = max_len;
+	return 0;
+}
+
+int acc_codec_push(struct acc_codec *codec, const int16_t sample[3])
+{
+	/* A failed send can leave a full block pending, encode it first */
+	if (codec->pending == ACC_CODEC_BLOCK_SAMPLES) {
+		int ret = encode_pending(codec, false);
+
+		if (ret)
+			return ret;
+		if (codec->pending == ACC_CODEC_BLOCK_SAMPLES)
+			return -1;
+	}
+	memcpy(codec->block[codec->pending++], sample, sizeof(codec->block[0]));
+	if (codec->pending < ACC_CODEC_BLOCK_SAMPLES)
+		return 0;
+	return encode_pending(codec, false);
+}
+
+int acc_codec_flush(struct acc_codec *codec)
+{
+	int ret = encode_pending(codec, true);
+
+	if (ret)
+		return ret;
+	return send_packet(codec);
+}
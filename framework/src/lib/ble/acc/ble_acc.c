@@ -30,6 +30,11 @@
 
  #include "lib/ble/acc/ble_acc.h"
  #include "infra/log.h"
+ #ifdef CONFIG_BLE_ACC_STREAM
+ #include <errno.h>
+ #include <stdbool.h>
+ #include "lib/ble/acc/acc_codec.h"
+ #endif
 
  #include <bluetooth/gatt.h>
  #include <bluetooth/uuid.h>
@@ -124,3 +129,38 @@ static ssize_t write_Config(struct bt_conn *conn,
  {
  	return acc_value;
  }
+
+ #ifdef CONFIG_BLE_ACC_STREAM
+ /* Compressed raw data stream */
+ static struct acc_codec acc_stream;
+ static bool acc_stream_ready;
+
+ static int acc_stream_send(uint8_t *packet, uint8_t len)
+ {
+ 	return ble_acc_update(packet, len);
+ }
+
+ int ble_acc_stream_init(uint8_t payload_len)
+ {
+ 	if (!payload_len)
+ 		payload_len = CONFIG_BLE_ACC_STREAM_PAYLOAD;
+ 	if (acc_codec_init(&acc_stream, acc_stream_send, payload_len))
+ 		return -EINVAL;
+ 	acc_stream_ready = true;
+ 	return 0;
+ }
+
+ int ble_acc_stream_push(const int16_t sample[3])
+ {
+ 	if (!acc_stream_ready)
+ 		ble_acc_stream_init(0);
+ 	return acc_codec_push(&acc_stream, sample);
+ }
+
+ int ble_acc_stream_flush(void)
+ {
+ 	if (!acc_stream_ready)
+ 		return 0;
+ 	return acc_codec_flush(&acc_stream);
+ }
+ #endif
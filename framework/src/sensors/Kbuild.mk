@@ -1,2 +1,2 @@
-obj-$(CONFIG_BMI160) += phy_sensor_api/
+obj-$(CONFIG_PHY_SENSOR_API) += phy_sensor_api/
 obj-$(CONFIG_SENSOR_CORE) += sensor_core/
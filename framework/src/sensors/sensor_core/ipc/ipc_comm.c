@@ -31,12 +31,24 @@
 #include <stdio.h>
 #include <string.h>
 #include "ipc_comm.h"
+#include <nanokernel.h>
 #include "os/os.h"
 #include "infra/log.h"
 
 DEFINE_LOG_MODULE(LOG_MODULE_SC_IPC, "SIPC")
 
-void *IPC_2CORE_QUEUE;
+/*
+ * Commands to the sensor core are kept in a static ring instead of an OS
+ * queue, so that sending one does not take a queue element. The semaphore
+ * is given once per command sent. It is taken once per command read, or
+ * all at once by ipc_core_wait() which leaves the commands in the ring.
+ */
+static struct ia_cmd *ipc_2core_ring[MAX_IPC_2CORE_NUM_MSG];
+static uint32_t ipc_2core_head;
+static uint32_t ipc_2core_tail;
+static T_SEMAPHORE ipc_2core_sem;
+/* Interrupt notifications dropped since the last ipc_core_wait() */
+static uint32_t ipc_2core_dropped;
 #define CONVERT_OS_ERR_TYPE_TO_GENERIC_ERROR(err) ((int)0 | err)
 #define ipc_log(fmt, arg ...) pr_info(LOG_MODULE_SC_IPC, "[%s]:"fmt, __func__, \
 				      ## arg)
@@ -69,14 +81,27 @@ static const char *_get_name_err_type(IPC_ERR_TYPE id)
  * */
 IPC_ERR_TYPE ipc_svc_core_create( )
 {
-	IPC_2CORE_QUEUE = (void *)queue_create(MAX_IPC_2CORE_NUM_MSG);
-	if (IPC_2CORE_QUEUE == NULL) {
+	ipc_2core_sem = semaphore_create(0);
+	if (ipc_2core_sem == NULL) {
 		ipc_log("Create IPC_2CORE ERR\n");
 		return IPC_STS_ERR;
 	}
 	return IPC_STS_OK;
 }
 
+static int ipc_2core_pop(struct ia_cmd **cmd)
+{
+	uint32_t key = irq_lock();
+
+	if (ipc_2core_head == ipc_2core_tail) {
+		irq_unlock(key);
+		return 0;
+	}
+	*cmd = ipc_2core_ring[ipc_2core_head++ & (MAX_IPC_2CORE_NUM_MSG - 1)];
+	irq_unlock(key);
+	return 1;
+}
+
 /**
  * \brief Read a message from sensor_CORE
  *     Read and dequeue a message.
@@ -94,17 +119,86 @@ IPC_ERR_TYPE ipc_svc_core_create( )
  */
 IPC_ERR_TYPE ipc_core_receive(struct ia_cmd **cmd, int timeout)
 {
-	OS_ERR_TYPE err = 0;
+	OS_ERR_TYPE err = E_OS_ERR_BUSY;
 
-	if (!IPC_2CORE_QUEUE) {
+	if (!ipc_2core_sem) {
 		ipc_log("ERR: please create ipc first\n");
 		return IPC_STS_ERR_EMPTY;
 	}
-	queue_get_message(IPC_2CORE_QUEUE, (void **)cmd, timeout, &err);
-	if (err < 0 && err != -2) {
-		ipc_log("Receive cmd err,err_id=%s\n", _get_name_err_type(err));
+	while (!ipc_2core_pop(cmd)) {
+		err = semaphore_take(ipc_2core_sem, timeout);
+		if (err == E_OS_ERR_TIMEOUT)
+			return IPC_STS_ERR_TIMEOUT;
+		if (err == E_OS_ERR_BUSY)
+			return IPC_STS_ERR_EMPTY;
+		if (err < 0) {
+			ipc_log("Receive cmd err,err_id=%s\n",
+				_get_name_err_type(err));
+			panic(CONVERT_OS_ERR_TYPE_TO_GENERIC_ERROR(err));
+		}
+	}
+	if (err != E_OS_OK)
+		semaphore_take(ipc_2core_sem, OS_NO_WAIT);
+	return IPC_STS_OK;
+}
+
+/**
+ * \brief Wait for new messages to sensor_CORE, without dequeuing them
+ *
+ * \param timeout: maximum number of milliseconds to wait. Special values
+ *                OS_NO_WAIT and OS_WAIT_FOREVER may be used.
+ * \return 0 when a message was sent since the previous wait.
+ */
+IPC_ERR_TYPE ipc_core_wait(int timeout)
+{
+	OS_ERR_TYPE err;
+
+	if (!ipc_2core_sem) {
+		ipc_log("ERR: please create ipc first\n");
+		return IPC_STS_ERR_EMPTY;
+	}
+	err = semaphore_take(ipc_2core_sem, timeout);
+	if (err < 0 && err != E_OS_ERR_TIMEOUT) {
+		ipc_log("Wait cmd err,err_id=%s\n", _get_name_err_type(err));
 		panic(CONVERT_OS_ERR_TYPE_TO_GENERIC_ERROR(err));
 	}
+	/* One wakeup for all the commands sent since the last wait */
+	while (err == E_OS_OK &&
+	       semaphore_take(ipc_2core_sem, OS_NO_WAIT) == E_OS_OK) ;
+	if (ipc_2core_dropped) {
+		uint32_t key = irq_lock();
+		uint32_t dropped = ipc_2core_dropped;
+
+		ipc_2core_dropped = 0;
+		irq_unlock(key);
+		pr_warning(LOG_MODULE_SC_IPC, "%u interrupt cmds dropped",
+			   (unsigned int)dropped);
+	}
+	return err;
+}
+
+static IPC_ERR_TYPE ipc_2core_push(struct ia_cmd *cmd, uint32_t reserved)
+{
+	OS_ERR_TYPE err = 0;
+	uint32_t key;
+
+	if (!cmd) {
+		ipc_log("Message is NULL\n");
+		return IPC_STS_ERR_EMPTY;
+	}
+	if (!ipc_2core_sem) {
+		ipc_log("ERR: please create ipc first\n");
+		return IPC_STS_ERR_EMPTY;
+	}
+	key = irq_lock();
+	if (ipc_2core_tail - ipc_2core_head >=
+	    MAX_IPC_2CORE_NUM_MSG - reserved) {
+		irq_unlock(key);
+		return IPC_STS_ERR_OVERFLOW;
+	}
+	ipc_2core_ring[ipc_2core_tail++ & (MAX_IPC_2CORE_NUM_MSG - 1)] = cmd;
+	irq_unlock(key);
+	semaphore_give(ipc_2core_sem, &err);
 	return err;
 }
 
@@ -120,24 +214,53 @@ IPC_ERR_TYPE ipc_core_receive(struct ia_cmd **cmd, int timeout)
  */
 IPC_ERR_TYPE ipc_2core_send(struct ia_cmd *cmd)
 {
-	OS_ERR_TYPE err = 0;
+	IPC_ERR_TYPE err = ipc_2core_push(cmd, 0);
 
-	if (!cmd) {
-		ipc_log("Message is NULL\n");
-		return IPC_STS_ERR_EMPTY;
-	}
-	if (!IPC_2CORE_QUEUE) {
-		ipc_log("ERR: please create ipc first\n");
-		return IPC_STS_ERR_EMPTY;
-	}
-	queue_send_message(IPC_2CORE_QUEUE, (void *)cmd, &err);
-	if (err < 0) {
+	if (err < 0 && err != IPC_STS_ERR_EMPTY) {
 		ipc_log("Ipc err[%s]\n", _get_name_err_type(err));
 		panic(CONVERT_OS_ERR_TYPE_TO_GENERIC_ERROR(err));
 	}
 	return err;
 }
 
+/**
+ * \brief Notify sensor_core of an interrupt event
+ *     Interrupt events can come faster than the sensor core reads its
+ *     commands: when only the IPC_2CORE_FIBER_RESERVED_MSG last slots are
+ *     left, the command is freed and counted instead of sent.
+ *     Authorized execution levels:  task, fiber, ISR.
+ *
+ * \param ia_cmd : balloc'ed message to send, should not be NULL
+ * \return 0:sucessed  IPC_STS_ERR_OVERFLOW:dropped
+ */
+IPC_ERR_TYPE ipc_2core_notify(struct ia_cmd *cmd)
+{
+	IPC_ERR_TYPE err = ipc_2core_push(cmd, IPC_2CORE_FIBER_RESERVED_MSG);
+
+	if (err == IPC_STS_ERR_OVERFLOW) {
+		uint32_t key;
+
+		bfree(cmd);
+		key = irq_lock();
+		ipc_2core_dropped++;
+		irq_unlock(key);
+	}
+	return err;
+}
+
+/**
+ * \brief SVC send a client request to sensor_core
+ *     The request is refused when the last IPC_2CORE_RESERVED_MSG slots
+ *     would be used, these are kept for the sensor core own commands.
+ *
+ * \param ia_cmd : message to send, left to the caller when refused
+ * \return 0:sucessed  IPC_STS_ERR_OVERFLOW:sensor_core is busy
+ */
+IPC_ERR_TYPE ipc_2core_request(struct ia_cmd *cmd)
+{
+	return ipc_2core_push(cmd, IPC_2CORE_RESERVED_MSG);
+}
+
 /**
  * \brief Sensor-core send a message  to svc on a queue
  *     This service may panic if err parameter is NULL and:
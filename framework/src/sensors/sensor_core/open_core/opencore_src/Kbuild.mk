@@ -4,3 +4,5 @@ obj-y += opencore_algo_engine.o
 obj-y += opencore_method.o
 obj-y += opencore_rawdata.o
 
+obj-y += opencore_sched.o
+obj-y += opencore_lookup.o
@@ -63,9 +63,89 @@ void OpencoreCommitSensData(uint8_t type, uint8_t id, void* data_ptr, int data_l
 	}
 }
 
+#ifdef CONFIG_SENSOR_CORE_FEED_STATS
+#include <stdio.h>
+#include <string.h>
+#include "infra/tcmd/handler.h"
+
+#define FEED_STATS_MAX 16
+
+/* Execution statistics of an algo feed, one exec consumes one sample set */
+typedef struct {
+	feed_general_t* feed;
+	uint32_t execs;
+	uint32_t reports;
+	uint64_t cycles;
+	uint32_t max_cycles;
+	int last_ret;
+}feed_stats_t;
+
+static feed_stats_t feed_stats[FEED_STATS_MAX];
+
+static void UpdateFeedStats(feed_general_t* feed, uint32_t cycles, int ret)
+{
+	feed_stats_t* stats = NULL;
+	for(int i = 0; i < FEED_STATS_MAX; i++){
+		if(feed_stats[i].feed == feed || feed_stats[i].feed == NULL){
+			stats = &feed_stats[i];
+			break;
+		}
+	}
+	if(stats == NULL)
+		return;
+
+	stats->feed = feed;
+	stats->execs++;
+	stats->cycles += cycles;
+	if(cycles > stats->max_cycles)
+		stats->max_cycles = cycles;
+	if(ret != 0)
+		stats->reports++;
+	stats->last_ret = ret;
+}
+
+/*
+ * Display the execution statistics of each algo feed: number of sample sets
+ * processed, number of reports, average and worst cycles per sample set.
+ * "ss feedstats reset" clears them.
+ *
+ * @param[in]   argc        Number of arguments in the Test Command (including group and name)
+ * @param[in]   argv        Table of null-terminated buffers containing the arguments
+ * @param[in]   ctx         The context to pass back to responses
+ */
+void feed_stats_tcmd(int argc, char* argv[], struct tcmd_handler_ctx* ctx)
+{
+	char buf[96];
+
+	if(argc == 3 && !strcmp(argv[2], "reset")){
+		memset(feed_stats, 0, sizeof(feed_stats));
+		TCMD_RSP_FINAL(ctx, NULL);
+		return;
+	}
+
+	for(int i = 0; i < FEED_STATS_MAX && feed_stats[i].feed != NULL; i++){
+		feed_stats_t* stats = &feed_stats[i];
+		snprintf(buf, sizeof(buf), "feed %p type:%d samples:%u reports:%u last:%d cyc/sample:%u max:%u",
+			stats->feed, stats->feed->type, (unsigned int)stats->execs,
+			(unsigned int)stats->reports, stats->last_ret,
+			(unsigned int)(stats->cycles / stats->execs),
+			(unsigned int)stats->max_cycles);
+		TCMD_RSP_PROVISIONAL(ctx, buf);
+	}
+	TCMD_RSP_FINAL(ctx, NULL);
+}
+DECLARE_TEST_COMMAND_ENG(ss, feedstats, feed_stats_tcmd);
+#endif
+
 static void HandleAlgo(feed_general_t* feed, void** data_ptr)
 {
+#ifdef CONFIG_SENSOR_CORE_FEED_STATS
+	uint32_t start = sys_cycle_get_32();
 	int ret = feed->ctl_api.exec(data_ptr, feed);
+	UpdateFeedStats(feed, sys_cycle_get_32() - start, ret);
+#else
+	int ret = feed->ctl_api.exec(data_ptr, feed);
+#endif
 	if(ret != 0){
 		for(list_t* next = exposed_sensor_list.head; next != NULL; next = next->next){
 			exposed_sensor_t* exposed_sensor = (exposed_sensor_t*)next;
@@ -462,8 +542,10 @@ static void handle_algo_ref_port(struct message* m, void* data)
 					}
 				}
 
-				if(phy_type_fifo_clean_cnt == phy_type_fifo_cnt)
+				if(phy_type_fifo_clean_cnt == phy_type_fifo_cnt){
 					read_out_fifo_flag = 0;
+					PollSchedInvalidate();
+				}
 
 				FeedSensData2Algo();
 
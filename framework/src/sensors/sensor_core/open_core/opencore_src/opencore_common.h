@@ -63,6 +63,12 @@
 #define RAW_DATA_HEAD_CNT    2
 #define FOREVER_VALUE ~((uint32_t)0)
 
+#define POLL_SCHED_MAX_SENSORS  16
+#define MS_TO_32K(ms)           ((uint32_t)((ms) * 32768 / 1000))
+/* Rounded down: the poll timeout expires before the due point and the
+ * remainder, below 1 ms, is waited on the 32 kHz counter */
+#define TICKS_32K_TO_MS(t)      ((uint32_t)(((uint64_t)(t) * 1000) >> 15))
+
 #define DIRECT_RAW (1 << 1)
 //#define SUPPORT_INTERRUPT_MODE
 
@@ -130,7 +136,8 @@ typedef struct {
 	uint8_t sensor_data_frame_size;
 	uint8_t sensor_data_raw_size;
 
-	double npp;
+	uint32_t npp;		/* next poll point in 32 kHz ticks, 0 means now */
+	uint32_t pi_32k;
 	float pi;
 	float pi_used_balloc;
 	uint16_t freq;
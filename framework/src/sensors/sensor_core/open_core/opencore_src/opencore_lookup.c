@@ -0,0 +1,121 @@
+/****************************************************************************************
+ *
+ * BSD LICENSE
+ *
+ * Copyright(c) 2016 Intel Corporation.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in
+ * the documentation and/or other materials provided with the
+ * distribution.
+ * * Neither the name of Intel Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***************************************************************************************/
+#include <stddef.h>
+#include "opencore_lookup.h"
+
+#if (LOOKUP_TABLE_SIZE & (LOOKUP_TABLE_SIZE - 1)) != 0
+#error "LOOKUP_TABLE_SIZE must be a power of 2"
+#endif
+
+#define LOOKUP_MASK (LOOKUP_TABLE_SIZE - 1)
+
+/* A key of 0 marks an empty slot, kinds start at 1 so no key is 0 */
+#define LOOKUP_KEY(kind, type, id) \
+	(((uint32_t)(kind) << 16) | ((uint32_t)(type) << 8) | (id))
+
+struct lookup_entry {
+	uint32_t key;
+	void *handle;
+};
+
+static struct lookup_entry lookup_table[LOOKUP_TABLE_SIZE];
+static int lookup_count;
+static int lookup_max_probe;
+static int lookup_overflow;
+
+static inline uint32_t LookupSlot(uint32_t key)
+{
+	/* Fibonacci hashing spreads the consecutive types and ids */
+	return (key * 2654435769u) >> 16 & LOOKUP_MASK;
+}
+
+int LookupAdd(lookup_kind_t kind, uint8_t type, uint8_t id, void *handle)
+{
+	uint32_t key = LOOKUP_KEY(kind, type, id);
+	uint32_t slot = LookupSlot(key);
+	int probe;
+
+	if (lookup_count == LOOKUP_TABLE_SIZE - 1) {
+		/* Keep one empty slot so that a miss always terminates */
+		lookup_overflow = 1;
+		return -1;
+	}
+
+	for (probe = 1; lookup_table[slot].key != 0; probe++) {
+		if (lookup_table[slot].key == key)
+			return -1;
+		slot = (slot + 1) & LOOKUP_MASK;
+	}
+
+	lookup_table[slot].key = key;
+	lookup_table[slot].handle = handle;
+	lookup_count++;
+	if (probe > lookup_max_probe)
+		lookup_max_probe = probe;
+	return 0;
+}
+
+void *LookupGet(lookup_kind_t kind, uint8_t type, uint8_t id)
+{
+	uint32_t key = LOOKUP_KEY(kind, type, id);
+	uint32_t slot = LookupSlot(key);
+
+	while (lookup_table[slot].key != 0) {
+		if (lookup_table[slot].key == key)
+			return lookup_table[slot].handle;
+		slot = (slot + 1) & LOOKUP_MASK;
+	}
+	return NULL;
+}
+
+int LookupOverflowed(void)
+{
+	return lookup_overflow;
+}
+
+int LookupMaxProbe(void)
+{
+	return lookup_max_probe;
+}
+
+void LookupReset(void)
+{
+	for (int i = 0; i < LOOKUP_TABLE_SIZE; i++) {
+		lookup_table[i].key = 0;
+		lookup_table[i].handle = NULL;
+	}
+	lookup_count = 0;
+	lookup_max_probe = 0;
+	lookup_overflow = 0;
+}
@@ -0,0 +1,92 @@
+/****************************************************************************************
+ *
+ * BSD LICENSE
+ *
+ * Copyright(c) 2016 Intel Corporation.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in
+ * the documentation and/or other materials provided with the
+ * distribution.
+ * * Neither the name of Intel Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***************************************************************************************/
+#ifndef __OPENCORE_LOOKUP_H__
+#define __OPENCORE_LOOKUP_H__
+
+#include <stdint.h>
+
+/*
+ * Handle lookup table: maps (kind, type, id) to the sensor, feed or exposed
+ * sensor registered under it. Entries are added once by SensorCoreInit()
+ * and never removed, so the table is an open-addressed array with linear
+ * probing and no tombstones.
+ */
+
+/* Number of slots, must be a power of 2. Keep it at least twice the number
+ * of registered handles so that probe sequences stay short. */
+#ifndef LOOKUP_TABLE_SIZE
+#define LOOKUP_TABLE_SIZE 64
+#endif
+
+typedef enum {
+	LOOKUP_INT = 1,
+	LOOKUP_POLL,
+	LOOKUP_FEED,
+	LOOKUP_EXPOSED,
+} lookup_kind_t;
+
+/**
+ * Register a handle.
+ *
+ * If a handle is already registered under the same key, the first one is
+ * kept, as the list walks it replaces returned the first match.
+ *
+ * @return 0 on success, -1 if the key is already used or the table is full.
+ */
+int LookupAdd(lookup_kind_t kind, uint8_t type, uint8_t id, void *handle);
+
+/**
+ * Get the handle registered under a key.
+ *
+ * @return the handle, or NULL if none is registered.
+ */
+void *LookupGet(lookup_kind_t kind, uint8_t type, uint8_t id);
+
+/**
+ * Check whether a registration failed because the table was full.
+ */
+int LookupOverflowed(void);
+
+/**
+ * Longest probe sequence seen by LookupAdd(). Lookups of a registered key
+ * never probe more slots.
+ */
+int LookupMaxProbe(void);
+
+/**
+ * Empty the table.
+ */
+void LookupReset(void);
+
+#endif
@@ -42,95 +42,78 @@ static int loop;
 static int reg_mark;
 static int fifo_mark;
 static uint32_t read_ohrm_consume;
-static list_head_t cmd_head;
 
-#define THRESHOLD_CMD_COUNT 10
 static int SensorCoreProcess(int* poll_timeout)
 {
 	loop = reg_mark = fifo_mark = read_ohrm_consume = 0;
-	static double last_ct = 0;
 	static int last_poll_timeout = 0;
-	int act_npp, act_algo = 0;
+	int act_algo = 0;
 	while(1){
-		double min_npp = 0;
-		double ct = get_uptime_32k() * (double)1000 / 32768;
-		if(ct < last_ct)
-			RefleshSensorCore();
-
-		last_ct = ct;
-		act_npp = 0;
-		for(list_t* next = phy_sensor_poll_active_list.head; next != NULL; next = next->next){
-			sensor_handle_t* phy_sensor = (sensor_handle_t*)((void*)next
-				- offsetof(sensor_handle_t, links.poll.poll_active_link));
-			if((phy_sensor->stat_flag & IDLE) != 0)
-				continue;
-
-			if(phy_sensor->fifo_length > 0 && phy_sensor->fifo_use_flag != 0 && read_out_fifo_flag != 0)
-				continue;
-
-			if(phy_sensor->need_poll != 0){
-				if(min_npp == 0 || min_npp > phy_sensor->npp)
-					min_npp = phy_sensor->npp;
-				act_npp++;
-			}
-		}
+		sensor_handle_t* due[POLL_SCHED_MAX_SENSORS];
+		int due_count = 0;
+		uint32_t ct = get_uptime_32k();
+		sensor_handle_t* next_sensor = PollSchedPeek(ct);
 
-		if(act_npp == 0){
+		if(next_sensor == NULL){
 			last_poll_timeout = FOREVER_VALUE;
 			*poll_timeout = FOREVER_VALUE;
 			return act_algo;
 		}
 
-		if(ct < min_npp && min_npp - ct > 1){
-			last_poll_timeout = min_npp - ct;
-			*poll_timeout = min_npp - ct;
-			return act_algo;
+		if((int32_t)(next_sensor->npp - ct) > 0){
+			if(TICKS_32K_TO_MS(next_sensor->npp - ct) > 0){
+				last_poll_timeout = TICKS_32K_TO_MS(next_sensor->npp - ct);
+				*poll_timeout = last_poll_timeout;
+				return act_algo;
+			}
+			/* Less than 1 ms to go: at most 32 ticks of spinning */
+			while((int32_t)(next_sensor->npp - (ct = get_uptime_32k())) > 0)
+				;
 		}
 
 		loop++;
 		act_algo = 0;
-		for(list_t* node = phy_sensor_poll_active_list.head; node != NULL; node = node->next){
-			sensor_handle_t* phy_sensor = (sensor_handle_t*)((void*)node - offsetof(sensor_handle_t, links.poll.poll_active_link));
-			if((phy_sensor->stat_flag & IDLE) != 0)
-				continue;
-			if(phy_sensor->need_poll != 0 && ct >= phy_sensor->npp && phy_sensor->buffer != NULL){
-				int ret = 0;
-				if(phy_sensor->fifo_length > 0 && phy_sensor->fifo_use_flag != 0 && read_out_fifo_flag == 0){
-					//get node and buffer
-					TriggerAlgoEngine(READ_FIFO, (void*)phy_sensor);
-					phy_sensor->npp = ct + phy_sensor->pi;
-					act_algo++;
-					fifo_mark++;
-				}else if(phy_sensor->fifo_use_flag == 0){
-					void* temp_ptr = phy_sensor->buffer - offsetof(struct sensor_data, data);
-					int ct_local = get_uptime_ms();
-					ret = phy_sensor_data_read(phy_sensor->ptr, (struct sensor_data*)temp_ptr);
-					read_ohrm_consume = get_uptime_ms() - ct_local;
-					if(ret != 0){
-						raw_data_node_t* node = (raw_data_node_t*)AllocFromDss(sizeof(raw_data_node_t));
-						if(node == NULL)
-							pr_error(LOG_MODULE_OPEN_CORE, "fail to alloc raw data node reg");
-						void* buffer = AllocFromDss(phy_sensor->buffer_length);
-						if(buffer == NULL)
-							pr_error(LOG_MODULE_OPEN_CORE, "fail to alloc raw data buffer reg");
-						if(node != NULL && buffer != NULL){
-							memcpy(buffer, phy_sensor->buffer, ret);
-							node->buffer = buffer;
-							node->raw_data_count = ret / phy_sensor->sensor_data_frame_size;
-							uint8_t head_for_raw = phy_sensor->head_for_algo == 0 ? 1 : 0;
-							list_add(&phy_sensor->raw_data_head[head_for_raw], &node->raw_data_node);
-							act_algo++;
-						}else{
-							if(node != NULL)
-								FreeInDss((void*)node);
-							if(buffer != NULL)
-								FreeInDss(buffer);
-						}
+		/* Take all the due sensors out first, each is read once per pass */
+		while((next_sensor = PollSchedPop(ct)) != NULL)
+			due[due_count++] = next_sensor;
+
+		for(int i = 0; i < due_count; i++){
+			sensor_handle_t* phy_sensor = due[i];
+			int ret = 0;
+			if(phy_sensor->fifo_length > 0 && phy_sensor->fifo_use_flag != 0 && read_out_fifo_flag == 0){
+				//get node and buffer
+				TriggerAlgoEngine(READ_FIFO, (void*)phy_sensor);
+				act_algo++;
+				fifo_mark++;
+			}else if(phy_sensor->fifo_use_flag == 0){
+				void* temp_ptr = phy_sensor->buffer - offsetof(struct sensor_data, data);
+				int ct_local = get_uptime_ms();
+				ret = phy_sensor_data_read(phy_sensor->ptr, (struct sensor_data*)temp_ptr);
+				read_ohrm_consume = get_uptime_ms() - ct_local;
+				if(ret != 0){
+					raw_data_node_t* node = (raw_data_node_t*)AllocFromDss(sizeof(raw_data_node_t));
+					if(node == NULL)
+						pr_error(LOG_MODULE_OPEN_CORE, "fail to alloc raw data node reg");
+					void* buffer = AllocFromDss(phy_sensor->buffer_length);
+					if(buffer == NULL)
+						pr_error(LOG_MODULE_OPEN_CORE, "fail to alloc raw data buffer reg");
+					if(node != NULL && buffer != NULL){
+						memcpy(buffer, phy_sensor->buffer, ret);
+						node->buffer = buffer;
+						node->raw_data_count = ret / phy_sensor->sensor_data_frame_size;
+						uint8_t head_for_raw = phy_sensor->head_for_algo == 0 ? 1 : 0;
+						list_add(&phy_sensor->raw_data_head[head_for_raw], &node->raw_data_node);
+						act_algo++;
+					}else{
+						if(node != NULL)
+							FreeInDss((void*)node);
+						if(buffer != NULL)
+							FreeInDss(buffer);
 					}
-					phy_sensor->npp = ct + phy_sensor->pi;
-					reg_mark++;
 				}
+				reg_mark++;
 			}
+			PollSchedReschedule(phy_sensor, ct);
 		}
 	}
 }
@@ -208,6 +191,7 @@ static struct ia_cmd* CoreSensorControl(struct sensor_id* sensor_id, core_sensor
 							phy_sensor->npp = 0;
 							if((phy_sensor->stat_flag&IDLE) != 0 && (exposed_sensor->stat_flag & DIRECT_RAW) != 0)
 								phy_sensor->stat_flag &= ~IDLE;
+							PollSchedInvalidate();
 						}
 						if((exposed_sensor->stat_flag & DIRECT_RAW) != 0){
 							if(calibration_flag == 1 || rt <= 0 || freq <= 0 || (1000 / freq) > rt){
@@ -578,6 +562,7 @@ static void PrepareSWtappingDetect(void)
 						phy_sensor_enable_hwfifo_with_buffer(phy_sensor->ptr, 1,
 							(uint8_t *)phy_sensor->buffer, phy_sensor->buffer_length);
 						phy_sensor->fifo_use_flag = 1;
+						PollSchedInvalidate();
 					}
 					break;
 				}
@@ -679,6 +664,7 @@ static void ClearIdle(void)
 					if(phy_sensor != NULL){
 						phy_sensor->idle_ref++;
 						phy_sensor->stat_flag &= ~IDLE;
+						PollSchedInvalidate();
 					}
 				}
 			}
@@ -992,34 +978,16 @@ static void opencore_fiber(void)
 	uint32_t ts_last;
 	int ret;
 	int act_algo = 0;
-	int queued_cmd_count = 0;
 
 	while(1){
 		ret = -2;
 		ts_last = get_uptime_ms();
 
 		if(poll_timeout > 0 || poll_timeout == OS_WAIT_FOREVER)
-			ret = ipc_core_receive(&cmd, poll_timeout);
+			ret = ipc_core_wait(poll_timeout);
 
 		pm_wakelock_acquire(&opencore_main_wl);
 
-		if(ret == 0){
-			cmd_node_t* cmd_node = (cmd_node_t*)balloc(sizeof(cmd_node_t), NULL);
-			memset(cmd_node, 0, sizeof(cmd_node_t));
-			cmd_node->cmd = cmd;
-			if (queued_cmd_count < THRESHOLD_CMD_COUNT) {
-				queued_cmd_count++;
-			} else {
-					list_t* node = list_get(&cmd_head);
-					cmd_node_t* cmd_node = (cmd_node_t*)((void*)node
-						- offsetof(cmd_node_t, cmd_link));
-					bfree(cmd_node->cmd);
-					bfree(cmd_node);
-					pr_error(LOG_MODULE_OPEN_CORE, "discarding oldest command");
-			}
-			list_add(&cmd_head, &cmd_node->cmd_link);
-		}
-
 		if(1 == 1){
 			uint32_t actual_elapse = get_uptime_ms() - ts_last;
 			if(actual_elapse > poll_timeout && actual_elapse - poll_timeout > 3)
@@ -1041,22 +1009,15 @@ back:
 
 		if(poll_timeout == FOREVER_VALUE || poll_timeout >= 5){
 			int ret = 0;
-			for(list_t* node = cmd_head.head; node != NULL;){
-				cmd_node_t* cmd_node = (cmd_node_t*)((void*)node
-					- offsetof(cmd_node_t, cmd_link));
-				if(cmd_node != NULL && cmd_node->cmd != NULL){
-					resp = ParseCmd(cmd_node->cmd);
-					if(resp != NULL){
-						ipc_2svc_send(resp);
-						bfree(resp);
-					}
+			//commands wait in the ipc ring until here, take them all
+			while(ipc_core_receive(&cmd, OS_NO_WAIT) == IPC_STS_OK){
+				resp = ParseCmd(cmd);
+				if(resp != NULL){
+					ipc_2svc_send(resp);
+					bfree(resp);
 				}
-				node = node->next;
-				bfree(cmd_node);
 				ret++;
-				queued_cmd_count--;
 			}
-			memset(&cmd_head, 0, sizeof(list_head_t));
 			if(ret != 0)
 				goto back;
 		}
@@ -61,11 +61,6 @@ typedef enum {
 	ALGO_CTL_TOP,
 }core_sensor_ctl_t;
 
-typedef struct {
-	struct ia_cmd *cmd;
-	list_t cmd_link;
-}cmd_node_t;
-
 extern struct pm_wakelock opencore_main_wl;
 extern struct pm_wakelock opencore_cali_wl;
 
@@ -85,6 +80,10 @@ void TriggerAlgoEngine(uint16_t msg_id, void *priv_data);
 void AlgoEngineInit(T_QUEUE service_mgr_queue);
 int motion_detect_callback(struct sensor_data *sensor_data, void *priv_data);
 void RefleshSensorCore(void);
+void PollSchedInvalidate(void);
+sensor_handle_t *PollSchedPeek(uint32_t now);
+sensor_handle_t *PollSchedPop(uint32_t now);
+void PollSchedReschedule(sensor_handle_t *phy_sensor, uint32_t now);
 void SensorCoreInit(void);
 void OpenIntSensor(sensor_handle_t *phy_sensor);
 void CloseIntSensor(sensor_handle_t *phy_sensor);
@@ -32,8 +32,38 @@
  *
  ***************************************************************************************/
 #include "opencore_main.h"
+/*
+ * The getters below resolve through the lookup table filled at registration.
+ * They only walk the lists if the table overflowed during SensorCoreInit().
+ */
+void RegisterIntSens(sensor_handle_t *phy_sensor)
+{
+	LookupAdd(LOOKUP_INT, phy_sensor->type, phy_sensor->id, phy_sensor);
+	/* DEFAULT_ID resolves to the first sensor registered for the type */
+	LookupAdd(LOOKUP_INT, phy_sensor->type, DEFAULT_ID, phy_sensor);
+}
+
+void RegisterPollSens(sensor_handle_t *phy_sensor)
+{
+	LookupAdd(LOOKUP_POLL, phy_sensor->type, phy_sensor->id, phy_sensor);
+}
+
+void RegisterFeed(feed_general_t *feed)
+{
+	LookupAdd(LOOKUP_FEED, feed->type, 0, feed);
+}
+
+void RegisterExposed(exposed_sensor_t *exposed_sensor)
+{
+	LookupAdd(LOOKUP_EXPOSED, exposed_sensor->type, exposed_sensor->id,
+		  exposed_sensor);
+}
+
 sensor_handle_t *GetIntSensStruct(uint8_t type, uint8_t id)
 {
+	if (!LookupOverflowed())
+		return LookupGet(LOOKUP_INT, type, id);
+
 	for (list_t *next = phy_sensor_list_int.head;
 	     next != NULL;
 	     next = next->next) {
@@ -50,6 +80,9 @@ sensor_handle_t *GetIntSensStruct(uint8_t type, uint8_t id)
 
 feed_general_t *GetFeedStruct(basic_algo_type_t type)
 {
+	if (!LookupOverflowed())
+		return LookupGet(LOOKUP_FEED, type, 0);
+
 	for (list_t *next = feed_list.head; next != NULL; next = next->next)
 		if (((feed_general_t *)next)->type == type)
 			return (feed_general_t *)next;
@@ -58,6 +91,9 @@ feed_general_t *GetFeedStruct(basic_algo_type_t type)
 
 exposed_sensor_t *GetExposedStruct(uint8_t type, uint8_t id)
 {
+	if (!LookupOverflowed())
+		return LookupGet(LOOKUP_EXPOSED, type, id);
+
 	for (list_t *next = exposed_sensor_list.head;
 	     next != NULL;
 	     next = next->next) {
@@ -94,6 +130,9 @@ sensor_handle_t *GetActivePollSensStruct(int8_t type, uint8_t id)
 
 sensor_handle_t *GetPollSensStruct(uint8_t type, uint8_t id)
 {
+	if (!LookupOverflowed())
+		return LookupGet(LOOKUP_POLL, type, id);
+
 	for (list_t *next = phy_sensor_list_poll.head;
 	     next != NULL;
 	     next = next->next) {
@@ -34,6 +34,16 @@
 #ifndef __OPENCORE_METHOD_H__
 #define __OPENCORE_METHOD_H__
 
+#include "opencore_lookup.h"
+
+void RegisterIntSens(sensor_handle_t *phy_sensor);
+
+void RegisterPollSens(sensor_handle_t *phy_sensor);
+
+void RegisterFeed(feed_general_t *feed);
+
+void RegisterExposed(exposed_sensor_t *exposed_sensor);
+
 sensor_handle_t *GetIntSensStruct(uint8_t type, uint8_t id);
 
 feed_general_t *GetFeedStruct(basic_algo_type_t type);
@@ -0,0 +1,169 @@
+/****************************************************************************************
+ *
+ * BSD LICENSE
+ *
+ * Copyright(c) 2016 Intel Corporation.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in
+ * the documentation and/or other materials provided with the
+ * distribution.
+ * * Neither the name of Intel Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***************************************************************************************/
+/* *INDENT-OFF* */
+#include "opencore_main.h"
+
+/*
+ * Poll schedule: a min-heap of the polled physical sensors ordered by their
+ * next poll point.
+ *
+ * The heap holds the sensors that could be polled when it was last built. A
+ * sensor that can no longer be polled is dropped when it reaches the top, so
+ * any change that makes a sensor pollable again has to call
+ * PollSchedInvalidate(): the heap is then rebuilt before the next poll.
+ */
+static sensor_handle_t* poll_heap[POLL_SCHED_MAX_SENSORS];
+static int poll_heap_count;
+static volatile uint8_t poll_heap_valid;
+
+extern int read_out_fifo_flag;
+
+static inline int NppBefore(sensor_handle_t* a, sensor_handle_t* b)
+{
+	return (int32_t)(a->npp - b->npp) < 0;
+}
+
+static void SiftDown(int i)
+{
+	sensor_handle_t* phy_sensor = poll_heap[i];
+	while(1){
+		int child = 2 * i + 1;
+		if(child >= poll_heap_count)
+			break;
+		if(child + 1 < poll_heap_count && NppBefore(poll_heap[child + 1], poll_heap[child]))
+			child++;
+		if(!NppBefore(poll_heap[child], phy_sensor))
+			break;
+		poll_heap[i] = poll_heap[child];
+		i = child;
+	}
+	poll_heap[i] = phy_sensor;
+}
+
+static void SiftUp(int i)
+{
+	sensor_handle_t* phy_sensor = poll_heap[i];
+	while(i > 0){
+		int parent = (i - 1) / 2;
+		if(!NppBefore(phy_sensor, poll_heap[parent]))
+			break;
+		poll_heap[i] = poll_heap[parent];
+		i = parent;
+	}
+	poll_heap[i] = phy_sensor;
+}
+
+static int PollSchedEligible(sensor_handle_t* phy_sensor)
+{
+	if((phy_sensor->stat_flag & IDLE) != 0 || phy_sensor->need_poll == 0 || phy_sensor->buffer == NULL)
+		return 0;
+	if(phy_sensor->fifo_length > 0 && phy_sensor->fifo_use_flag != 0 && read_out_fifo_flag != 0)
+		return 0;
+	return 1;
+}
+
+static void PollSchedRebuild(uint32_t now)
+{
+	/* Cleared again by any invalidation that races with the walk below */
+	poll_heap_valid = 1;
+	poll_heap_count = 0;
+	for(list_t* next = phy_sensor_poll_active_list.head; next != NULL; next = next->next){
+		sensor_handle_t* phy_sensor = (sensor_handle_t*)((void*)next
+			- offsetof(sensor_handle_t, links.poll.poll_active_link));
+		if(!PollSchedEligible(phy_sensor))
+			continue;
+		if(poll_heap_count == POLL_SCHED_MAX_SENSORS){
+			pr_error(LOG_MODULE_OPEN_CORE, "too many polled sensors");
+			break;
+		}
+		phy_sensor->pi_32k = MS_TO_32K(phy_sensor->pi);
+		/* 0, or a point more than a period ahead (set before the tick
+		 * counter wrapped), means poll now */
+		if(phy_sensor->npp == 0 || (int32_t)(phy_sensor->npp - now) > (int32_t)phy_sensor->pi_32k)
+			phy_sensor->npp = now;
+		poll_heap[poll_heap_count++] = phy_sensor;
+	}
+	for(int i = poll_heap_count / 2 - 1; i >= 0; i--)
+		SiftDown(i);
+}
+
+void PollSchedInvalidate(void)
+{
+	poll_heap_valid = 0;
+}
+
+/* Returns the sensor to poll first, rebuilding the heap if needed */
+sensor_handle_t* PollSchedPeek(uint32_t now)
+{
+	if(!poll_heap_valid)
+		PollSchedRebuild(now);
+	return poll_heap_count > 0 ? poll_heap[0] : NULL;
+}
+
+/*
+ * Removes and returns the next sensor due at now, NULL when there is none.
+ * The heap is not rebuilt here: the popped sensors are pushed back once
+ * polled and must not be in it twice.
+ */
+sensor_handle_t* PollSchedPop(uint32_t now)
+{
+	while(poll_heap_count > 0){
+		sensor_handle_t* phy_sensor = poll_heap[0];
+		if((int32_t)(phy_sensor->npp - now) > 0)
+			return NULL;
+		poll_heap[0] = poll_heap[--poll_heap_count];
+		if(poll_heap_count > 0)
+			SiftDown(0);
+		if(PollSchedEligible(phy_sensor))
+			return phy_sensor;
+	}
+	return NULL;
+}
+
+/*
+ * Puts a polled sensor back, due one period after its last due point so
+ * that a late read does not lower its rate. A sensor late by more than a
+ * period is due one period from now.
+ */
+void PollSchedReschedule(sensor_handle_t* phy_sensor, uint32_t now)
+{
+	phy_sensor->npp += phy_sensor->pi_32k;
+	if((int32_t)(phy_sensor->npp - now) <= 0)
+		phy_sensor->npp = now + phy_sensor->pi_32k;
+	if(poll_heap_count == POLL_SCHED_MAX_SENSORS)
+		return;
+	poll_heap[poll_heap_count] = phy_sensor;
+	SiftUp(poll_heap_count++);
+}
+/* *INDENT-ON* */
@@ -33,6 +33,9 @@
  ***************************************************************************************/
 /* *INDENT-OFF* */
 #include "opencore_support.h"
+#ifdef CONFIG_SENSOR_REPLAY
+#include "drivers/sensor/sensor_replay.h"
+#endif
 list_head_t feed_list;
 list_head_t exposed_sensor_list;
 
@@ -255,6 +258,7 @@ static void ResetPhySensorList(void)
 	}
 	phy_sensor_poll_active_list.head = phy_sensor_poll_active_list.tail = NULL;
 	memset(phy_sensor_poll_active_array, 0, sizeof(phy_sensor_poll_active_array));
+	PollSchedInvalidate();
 }
 
 static void ResetDemandDelayBuffer(sensor_data_demand_t* demand, int count, sensor_handle_t* phy_sensor)
@@ -431,7 +435,7 @@ void RefleshSensorCore(void)
 		return;
 	}
 
-	double ct = get_uptime_32k() * (double)1000 / 32768;
+	uint32_t ct = get_uptime_32k();
 
 	//set fifo phy sensor freq and no_fifo phy_sensor pi
 	for(list_t* next = phy_sensor_poll_active_list.head; next != NULL; next = next->next){
@@ -489,7 +493,7 @@ void RefleshSensorCore(void)
 				float si = (float)1000 * 10 / phy_sensor->freq;
 				phy_sensor->pi = final_pi;
 				if((phy_sensor->stat_flag & IDLE) != 0)
-					phy_sensor->npp = ct + final_pi;
+					phy_sensor->npp = ct + MS_TO_32K(final_pi);
 				if(final_pi > si && final_pi >= POLLING_TOLERANCE)
 					phy_sensor->fifo_use_flag = 1;
 			}
@@ -660,12 +664,12 @@ void RefleshSensorCore(void)
 					if(min_pi > si && min_pi >= POLLING_TOLERANCE){
 						phy_sensor_node->pi = min_pi;
 						if((phy_sensor_node->stat_flag & IDLE) != 0)
-							phy_sensor->npp = ct + min_pi;
+							phy_sensor->npp = ct + MS_TO_32K(min_pi);
 						phy_sensor_node->fifo_use_flag = 1;
 					}else{
 						phy_sensor_node->pi =  si;
 						if((phy_sensor_node->stat_flag & IDLE) != 0)
-							phy_sensor->npp = ct + si;
+							phy_sensor->npp = ct + MS_TO_32K(si);
 					}
 				}
 				share_list_head = share_list_head->next;
@@ -769,7 +773,7 @@ static void raw_data_fifo_int_cb(phy_sensor_event_t* event, void* priv_data)
 	memcpy(cmd->param, &priv_data, param_length);
 	cmd->length = param_length;
 	cmd->cmd_id = CMD_RAWDATA_FIFO_INT_SC;
-	ipc_2core_send(cmd);
+	ipc_2core_notify(cmd);
 	return;
 }
 
@@ -780,7 +784,7 @@ static int raw_data_reg_int_cb(struct sensor_data* sensor_data, void* priv_data)
 
 	memcpy(cmd->param, sensor_data, sizeof(struct sensor_data) + sensor_data->data_length);
 	cmd->cmd_id = CMD_RAWDATA_REG_INT_SC;
-	ipc_2core_send(cmd);
+	ipc_2core_notify(cmd);
 	return 0;
 }
 #endif
@@ -811,7 +815,7 @@ int motion_detect_callback(struct sensor_data* sensor_data, void* priv_data)
 
 		memset(cmd, 0, sizeof(struct ia_cmd));
 		cmd->cmd_id = id;
-		ipc_2core_send(cmd);
+		ipc_2core_notify(cmd);
 	}
 	return 0;
 }
@@ -894,6 +898,7 @@ out:
 
 				memset(phy_sensor->feed_data_buffer, 0, phy_sensor->sensor_data_frame_size);
 				list_add(&phy_sensor_list_poll, &phy_sensor->links.poll.poll_link);
+				RegisterPollSens(phy_sensor);
 				count++;
 			}else{
 				if(sens_list[i].sensor_type == SENSOR_ANY_MOTION
@@ -902,6 +907,7 @@ out:
 				}
 
 				list_add(&phy_sensor_list_int, &phy_sensor->links.int_link);
+				RegisterIntSens(phy_sensor);
 			}
 		}
 	}
@@ -930,6 +936,7 @@ out:
 		exposed_sensor->stat_flag = DIRECT_RAW;
 
 		list_add(&exposed_sensor_list, (list_t*)exposed_sensor);
+		RegisterExposed(exposed_sensor);
 	}
 }
 
@@ -952,6 +959,11 @@ static void FeedInit(void)
 					demand[i].type == SENSOR_GYROSCOPE ||
 					demand[i].type == SENSOR_MAGNETOMETER)
 					feed->motion_sensor_flag = 1;	/* Mark the algo depends on motion sensor data*/
+#ifdef CONFIG_SENSOR_REPLAY
+				/* Replayed types feed the algorithms from the replay sensors */
+				if(demand[i].id == DEFAULT_ID && sensor_replay_dev_id(demand[i].type) != 0)
+					demand[i].id = sensor_replay_dev_id(demand[i].type);
+#endif
 
 				for(list_t* next = phy_sensor_list_poll.head; next != NULL; next = next->next){
 					//	void* temp_ptr = phy_sensor[core_type]->buffer - offsetof(struct sensor_data, data);
@@ -1010,6 +1022,7 @@ static void FeedInit(void)
 			list_add(&feed_list, (list_t*)feed);
 		else
 			list_add_head(&feed_list, (list_t*)feed);
+		RegisterFeed(feed);
 skip:
 		feed_p++;
 	}
@@ -1032,17 +1045,22 @@ static void ExposedSensorInit(void)
 			}
 		}
 
-		if(valid != 0)
+		if(valid != 0){
 			list_add(&exposed_sensor_list, (list_t*)exposed_sensor);
+			RegisterExposed(exposed_sensor);
+		}
 		sensor_p++;
 	}
 }
 
 void SensorCoreInit(void)
 {
+	LookupReset();
 	PhySensorsInit();
 	FeedInit();
 	ExposedSensorInit();
+	if(LookupOverflowed())
+		pr_warning(LOG_MODULE_OPEN_CORE, "lookup table full, raise LOOKUP_TABLE_SIZE");
 	PMInit();
 	RefleshSensorCore();
 }
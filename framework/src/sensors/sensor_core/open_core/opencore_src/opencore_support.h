@@ -46,6 +46,7 @@ void OpencoreCommitSensData(uint8_t type, uint8_t id, void *data_ptr,
 			    int data_length);
 int motion_detect_callback(struct sensor_data *sensor_data, void *priv_data);
 void TriggerAlgoEngine(uint16_t msg_id, void *priv_data);
+void PollSchedInvalidate(void);
 
 #ifdef SUPPORT_INTERRUPT_MODE
 static int raw_data_reg_int_cb(struct sensor_data *sensor_data, void *priv_data);
@@ -77,6 +77,35 @@ static inline void adc_svc_ss_adc_read(adc_service_request_t *adc_svc_req);
 static struct td_device *adc_dev;
 static struct td_device *ss_dev;
 
+#ifdef CONFIG_SS_ADC_SEQ
+/* Subscriptions per channel: subscribed channels are sampled continuously
+ * and their periodic reads are served from the sequencer ring buffer */
+static uint8_t adc_seq_users[ADC_MAX_CHANNEL + 1];
+
+static void adc_seq_update(uint8_t channel, bool add)
+{
+	uint8_t channels[SS_ADC_SEQ_MAX_CHANNELS];
+	uint8_t count = 0;
+	int i;
+
+	/* Restart the sequence only when the channel set changes */
+	if (add) {
+		if (adc_seq_users[channel]++)
+			return;
+	} else {
+		if (!adc_seq_users[channel] || --adc_seq_users[channel])
+			return;
+	}
+
+	/* Channels beyond the sequencer capacity use one-shot reads */
+	for (i = ADC_MIN_CHANNEL;
+	     i <= ADC_MAX_CHANNEL && count < SS_ADC_SEQ_MAX_CHANNELS; i++)
+		if (adc_seq_users[i])
+			channels[count++] = i;
+	ss_adc_seq_start(channels, count, 0);
+}
+#endif
+
 static service_t adc_service = {
 	.service_id = SS_ADC_SERVICE_ID,
 	.client_connected = adc_client_connected,
@@ -208,6 +237,9 @@ static void handle_unsubscribe(struct cfw_message *msg)
 		bfree(gpio_list);
 	}
 	timer_delete(adc_svc_cli_handle->adc_timer);
+#ifdef CONFIG_SS_ADC_SEQ
+	adc_seq_update(adc_svc_cli_handle->adc_svc_cli.adc_channel, false);
+#endif
 	bfree(adc_svc_cli_handle);
 	adc_svc_cli_handle = NULL;
 	resp->status = DRV_RC_OK;
@@ -305,6 +337,9 @@ static void *adc_service_subscribe_request(cfw_service_conn_t *c,
 			adc_svc_req->adc_svc_cli.
 			time2, false, true, NULL);
 	}
+#ifdef CONFIG_SS_ADC_SEQ
+	adc_seq_update(channel, true);
+#endif
 	return (void *)adc_svc_req;
 }
 
@@ -45,6 +45,7 @@
 #include "battery_LUT/battery_LUT.h"
 #include "battery_property.h"
 #include "fuel_gauge_api.h"
+#include "fg_soc.h"
 #include "charging_sm.h"
 #if (CONFIG_SW_TEMP_MNG != 0)
 #include "hal_charger.h"
@@ -82,16 +83,6 @@
 #define FG_FULL_CHARGE                          100
 
 #define BATT_LEVEL_FULL_NO_CHARGE       4250
-#define LOOKUP_INDEX_10PRCT                     10      /**< index within lookup table related to voltage
-	                                                 * corresponding to 10% of charge*/
-#define LOOKUP_INDEX_30PRCT                     11      /**< index within lookup table related to voltage
-	                                                 * corresponding to 30% of charge*/
-#define LOOKUP_INDEX_50PRCT                     12      /**< index within lookup table related to voltage
-	                                                 * corresponding to 50% of charge*/
-#define LOOKUP_INDEX_70PRCT                     13      /**< index within lookup table related to voltage
-	                                                 * corresponding to 70% of charge*/
-#define LOOKUP_INDEX_90PRCT                     14      /**< index within lookup table related to voltage
-	                                                 * corresponding to 90% of charge*/
 
 #define FG_INITIAL_TEMPERATURE          20      /**< temperature at Boot time */
 
@@ -182,6 +173,12 @@ struct adc_filter_t {
 	uint8_t error_count;
 	enum e_state last_charger_state;
 	uint8_t vbatt_table_count;
+	/** index of the oldest value, ie next one to be replaced */
+	uint8_t vbatt_table_head;
+	/** latest value added to the table */
+	uint16_t vbatt_last;
+	/** running sum of the values in the table */
+	uint32_t vbatt_sum;
 	uint16_t vbatt_table[FB_FILTER_COUNT_VALUE];
 };
 static struct adc_filter_t adc_filter = {};
@@ -394,38 +391,6 @@ static void fg_set_battery_soc_properties(uint8_t battery_soc_measured)
 	battery_properties->battery_soc = battery_soc_measured;
 }
 
-/*
- * @brief Get Percentage of battery capacity from linearization
- * @param[in] voltage_x Voltage corresponding to first point
- * @param[in] percent_x Percentage corresponding to the first point
- * @param[in] voltage_y Voltage corresponding to second point
- * @param[in] percent_y Percentage corresponding to the second point
- * @param[in] voltage_batt Battery voltage from which percentage is required
- * @param[in,out] percent_batt Percentage corresponding to voltage_batt
- * @return None
- */
-static void fg_linearize(uint16_t voltage_x,
-			 uint16_t percent_x,
-			 uint16_t voltage_y,
-			 uint16_t percent_y,
-			 uint16_t voltage_batt, uint8_t *percent_batt)
-{
-	assert((voltage_y != voltage_x) && percent_batt);
-	/*!
-	 * Y1 = a.X1 + b
-	 * Y2 = a.X2 + b
-	 * a = (Y2 - Y1)/(X2 - X1)
-	 * percent = a.Voltage + b
-	 * percent = Voltage.(Y2 - Y1)/(X2 - X1) + b
-	 * percent = Y1 + (Voltage - X1).(Y2 -Y1)/(X2 -X1)
-	 */
-	*percent_batt =
-		percent_x +
-		(uint16_t)((voltage_batt -
-			    voltage_x) *
-			   (percent_y - percent_x)) / (voltage_y - voltage_x);
-}
-
 /*
  * @brief Set current fuel gauge from Temperature and battery voltage
  * @param[in] batt_voltage_mv Current battery voltage
@@ -433,8 +398,6 @@ static void fg_linearize(uint16_t voltage_x,
  */
 static fg_status_t fg_set_battery_soc(int16_t batt_voltage_mv)
 {
-	uint16_t batt_level_full = 0;
-	uint8_t lookup_index;
 	uint16_t *p_table = NULL;
 	uint8_t battery_soc_measured = 0;
 	fg_status_t fg_status = FG_STATUS_ERROR_OUT_OF_RANGE;
@@ -464,53 +427,9 @@ static fg_status_t fg_set_battery_soc(int16_t batt_voltage_mv)
 	if (fg_status != FG_STATUS_SUCCESS)
 		return FG_INVALID_LOOKUP_TABLE;
 
-	batt_level_full = p_table[BATTPROP_LOOKUP_TABLE_SIZE - 1];
-
-	if (batt_level_full < batt_voltage_mv) {
-		battery_soc_measured = FG_FULL_CHARGE;
-		fg_status = FG_STATUS_SUCCESS;
-	} else if (batt_voltage_mv >= p_table[LOOKUP_INDEX_90PRCT]) {
-		battery_soc_measured = FG_FULL_CHARGE - 1;
-		fg_status = FG_STATUS_SUCCESS;
-		for (lookup_index = LOOKUP_INDEX_90PRCT;
-		     lookup_index <= (BATTPROP_LOOKUP_TABLE_SIZE - 1);
-		     lookup_index++) {
-			if (batt_voltage_mv < p_table[lookup_index + 1]) {
-				battery_soc_measured =
-					90 + (lookup_index -
-					      LOOKUP_INDEX_90PRCT);
-				break;
-			}
-		}
-	} else if (batt_voltage_mv < p_table[LOOKUP_INDEX_10PRCT]) {
-		for (lookup_index = 0;
-		     lookup_index <= LOOKUP_INDEX_10PRCT;
-		     lookup_index++) {
-			if (batt_voltage_mv <= p_table[lookup_index]) {
-				battery_soc_measured = lookup_index;
-				fg_status = FG_STATUS_SUCCESS;
-				break;
-			}
-		}
-	} else {
-		uint16_t percent_x = 10;
-		for (lookup_index = LOOKUP_INDEX_10PRCT,
-		     percent_x = 10;
-		     lookup_index < LOOKUP_INDEX_90PRCT;
-		     lookup_index++,
-		     percent_x += 20) {
-			if (batt_voltage_mv < p_table[lookup_index + 1]) {
-				fg_linearize(p_table[lookup_index],
-					     percent_x,
-					     p_table[lookup_index + 1],
-					     percent_x + 20,
-					     batt_voltage_mv,
-					     &battery_soc_measured);
-				fg_status = FG_STATUS_SUCCESS;
-				break;
-			}
-		}
-	}
+	battery_soc_measured = fg_soc_lookup(p_table,
+					     BATTPROP_LOOKUP_TABLE_SIZE,
+					     batt_voltage_mv);
 
 	if (FG_STATUS_SUCCESS == fg_status) {
 		if ((battprop_fuelgauge.is_charging && battery_soc_measured >
@@ -637,9 +556,12 @@ static bool fg_is_charge_evt_detected(struct adc_filter_t *adc_filter)
 static void fg_adc_filter_init(struct adc_filter_t *adc_filter)
 {
 	adc_filter->vbatt_table_count = 0;
+	adc_filter->vbatt_table_head = 0;
+	adc_filter->vbatt_last = 0;
+	adc_filter->vbatt_sum = 0;
 	adc_filter->error_count = 0;
 	adc_filter->last_charger_state = charging_sm_get_state();
-	memset(adc_filter->vbatt_table, 0, FB_FILTER_COUNT_VALUE);
+	memset(adc_filter->vbatt_table, 0, sizeof(adc_filter->vbatt_table));
 }
 
 
@@ -651,12 +573,12 @@ static bool fg_is_vbatt_monotonous(struct adc_filter_t *adc_filter,
 	switch (adc_filter->last_charger_state) {
 	case CHARGE:
 		if (*batt_voltage >=
-		    adc_filter->vbatt_table[FB_FILTER_COUNT_VALUE - 1]) {
+		    adc_filter->vbatt_last) {
 			/* fg_measure_cfg.voltage_cfg.interval >> 14 (time interval / 8192) for 1.22mV per 10 second */
 			if (FB_FILTER_DIFF_MAX_INTER_MEASURE +
 			    (fg_measure_cfg.voltage_cfg.interval >> 14) >
 			    (*batt_voltage -
-			     adc_filter->vbatt_table[FB_FILTER_COUNT_VALUE - 1]))
+			     adc_filter->vbatt_last))
 				is_value_consistent = true;
 		} else
 			return false;
@@ -665,23 +587,20 @@ static bool fg_is_vbatt_monotonous(struct adc_filter_t *adc_filter,
 	case DISCHARGE:
 	case FAULT:
 		if (*batt_voltage <=
-		    adc_filter->vbatt_table[FB_FILTER_COUNT_VALUE - 1]) {
+		    adc_filter->vbatt_last) {
 			if (FB_FILTER_DIFF_MAX_INTER_MEASURE +
 			    (fg_measure_cfg.voltage_cfg.interval >> 14) >
-			    (adc_filter->vbatt_table[FB_FILTER_COUNT_VALUE -
-						     1] - *batt_voltage))
+			    (adc_filter->vbatt_last - *batt_voltage))
 				is_value_consistent = true;
 		} else
 			return false;
 		break;
 	case COMPLETE:
 		if ((*batt_voltage <
-		     adc_filter->vbatt_table[FB_FILTER_COUNT_VALUE -
-					     1] +
+		     adc_filter->vbatt_last +
 		     FB_FILTER_DIFF_MAX_INTER_MEASURE) &&
 		    (*batt_voltage >
-		     adc_filter->vbatt_table[FB_FILTER_COUNT_VALUE -
-					     1] -
+		     adc_filter->vbatt_last -
 		     FB_FILTER_DIFF_MAX_INTER_MEASURE))
 			is_value_consistent = true;
 		break;
@@ -701,29 +620,28 @@ static bool fg_is_vbatt_monotonous(struct adc_filter_t *adc_filter,
 	return is_value_consistent;
 }
 
+/*
+ * @brief Add a value to the filter, replacing the oldest one if full
+ * Keeps the running sum up to date so that the average is O(1)
+ */
 static void fg_adc_filter_add_elt(struct adc_filter_t * adc_filter,
 				  uint16_t *		batt_voltage)
 {
-	uint8_t count = 0;
+	uint8_t head = adc_filter->vbatt_table_head;
 
-	for (count = 0; count < FB_FILTER_COUNT_VALUE - 1; count++) {
-		adc_filter->vbatt_table[count] =
-			adc_filter->vbatt_table[count + 1];
-	}
-	adc_filter->vbatt_table[count] = *batt_voltage;
+	if (adc_filter->vbatt_table_count < FB_FILTER_COUNT_VALUE)
+		adc_filter->vbatt_table_count++;
+	else
+		adc_filter->vbatt_sum -= adc_filter->vbatt_table[head];
+	adc_filter->vbatt_table[head] = *batt_voltage;
+	adc_filter->vbatt_sum += *batt_voltage;
+	adc_filter->vbatt_last = *batt_voltage;
+	adc_filter->vbatt_table_head = (head + 1) % FB_FILTER_COUNT_VALUE;
 }
 
 static uint16_t fg_adc_filter_average(struct adc_filter_t *adc_filter)
 {
-	uint16_t result = 0;
-	uint8_t count = 0;
-
-	for (count = 0; count < adc_filter->vbatt_table_count; count++) {
-		result += adc_filter->vbatt_table[count];
-	}
-	result = result / adc_filter->vbatt_table_count;
-
-	return result;
+	return adc_filter->vbatt_sum / adc_filter->vbatt_table_count;
 }
 /*
  * @brief Adding filter for battery voltage
@@ -737,14 +655,9 @@ static uint16_t fg_adc_filter(uint16_t *batt_voltage)
 	if (true == fg_is_charge_evt_detected(&adc_filter))
 		fg_adc_filter_init(&adc_filter);
 
-	if (FB_FILTER_COUNT_VALUE <= adc_filter.vbatt_table_count) {
-		if (true == fg_is_vbatt_monotonous(&adc_filter, batt_voltage))
-			fg_adc_filter_add_elt(&adc_filter, batt_voltage);
-	} else {
-		adc_filter.vbatt_table[adc_filter.vbatt_table_count] =
-			*batt_voltage;
-		adc_filter.vbatt_table_count++;
-	}
+	if ((FB_FILTER_COUNT_VALUE > adc_filter.vbatt_table_count) ||
+	    (true == fg_is_vbatt_monotonous(&adc_filter, batt_voltage)))
+		fg_adc_filter_add_elt(&adc_filter, batt_voltage);
 
 	vbatt_filtered = fg_adc_filter_average(&adc_filter);
 
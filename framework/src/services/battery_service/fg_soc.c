@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "fg_soc.h"
+
+/*
+ * @brief Find the first index in [first, last) whose voltage is greater than
+ * (or equal to, if or_equal is set) the provided voltage
+ * @return last if there is none
+ */
+static uint8_t fg_soc_bound(const uint16_t *table, uint8_t first,
+			    uint8_t last, uint16_t voltage_mv, int or_equal)
+{
+	while (first < last) {
+		uint8_t mid = first + (last - first) / 2;
+		if (table[mid] < voltage_mv ||
+		    (!or_equal && table[mid] == voltage_mv))
+			first = mid + 1;
+		else
+			last = mid;
+	}
+	return first;
+}
+
+/*
+ * @brief Get Percentage of battery capacity from linearization
+ * @param[in] voltage_x Voltage corresponding to first point
+ * @param[in] percent_x Percentage corresponding to the first point
+ * @param[in] voltage_y Voltage corresponding to second point
+ * @param[in] percent_y Percentage corresponding to the second point
+ * @param[in] voltage_batt Battery voltage from which percentage is required
+ * @return Percentage corresponding to voltage_batt
+ */
+static uint8_t fg_linearize(uint16_t voltage_x, uint16_t percent_x,
+			    uint16_t voltage_y, uint16_t percent_y,
+			    uint16_t voltage_batt)
+{
+	/*!
+	 * Y1 = a.X1 + b
+	 * Y2 = a.X2 + b
+	 * a = (Y2 - Y1)/(X2 - X1)
+	 * percent = a.Voltage + b
+	 * percent = Voltage.(Y2 - Y1)/(X2 - X1) + b
+	 * percent = Y1 + (Voltage - X1).(Y2 -Y1)/(X2 -X1)
+	 */
+	return percent_x +
+	       (uint16_t)((voltage_batt - voltage_x) * (percent_y - percent_x)) /
+	       (voltage_y - voltage_x);
+}
+
+uint8_t fg_soc_lookup(const uint16_t *table, uint8_t table_size,
+		      int16_t voltage_mv)
+{
+	uint8_t index;
+
+	if (voltage_mv < 0)
+		return 0;
+
+	if (voltage_mv > table[table_size - 1])
+		return FG_SOC_FULL_CHARGE;
+
+	if (voltage_mv >= table[FG_SOC_LOOKUP_INDEX_90PRCT]) {
+		/* Last point whose voltage is lower than or equal */
+		index = fg_soc_bound(table, FG_SOC_LOOKUP_INDEX_90PRCT + 1,
+				     table_size, voltage_mv, 0) - 1;
+		if (index == table_size - 1)
+			return FG_SOC_FULL_CHARGE - 1;
+		return 90 + (index - FG_SOC_LOOKUP_INDEX_90PRCT);
+	}
+
+	if (voltage_mv < table[FG_SOC_LOOKUP_INDEX_10PRCT])
+		/* First point whose voltage is greater than or equal */
+		return fg_soc_bound(table, 0, FG_SOC_LOOKUP_INDEX_10PRCT,
+				    voltage_mv, 1);
+
+	/* Linearize between the 10, 30, 50, 70 and 90% points */
+	index = fg_soc_bound(table, FG_SOC_LOOKUP_INDEX_10PRCT + 1,
+			     FG_SOC_LOOKUP_INDEX_90PRCT + 1, voltage_mv, 0) - 1;
+	return fg_linearize(table[index],
+			    10 + 20 * (index - FG_SOC_LOOKUP_INDEX_10PRCT),
+			    table[index + 1],
+			    30 + 20 * (index - FG_SOC_LOOKUP_INDEX_10PRCT),
+			    voltage_mv);
+}
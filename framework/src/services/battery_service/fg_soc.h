@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _FG_SOC_H_
+#define _FG_SOC_H_
+
+#include <stdint.h>
+
+/*
+ * Layout of a battery lookup table (BATTPROP_LOOKUP_TABLE_SIZE voltages, in
+ * mV, in increasing order):
+ *  - indexes [0;10] are the voltages for a SOC of 0 to 10%,
+ *  - indexes [10;14] are the voltages for a SOC of 10, 30, 50, 70 and 90%,
+ *    the SOC is linearized between two points,
+ *  - indexes [14;24] are the voltages for a SOC of 90 to 100%.
+ */
+#define FG_SOC_LOOKUP_INDEX_10PRCT      10
+#define FG_SOC_LOOKUP_INDEX_90PRCT      14
+#define FG_SOC_FULL_CHARGE              100
+
+/**
+ * Compute the battery SOC from a lookup table.
+ *
+ * The lookup is a binary search on each piecewise section of the table, so
+ * its cost does not depend on the battery voltage.
+ *
+ * @param table       lookup table, see layout above
+ * @param table_size  number of voltages in the table
+ * @param voltage_mv  battery voltage, a negative reading gives 0%
+ *
+ * @return the battery SOC in percent
+ */
+uint8_t fg_soc_lookup(const uint16_t *table, uint8_t table_size,
+		      int16_t voltage_mv);
+
+#endif /* _FG_SOC_H_ */
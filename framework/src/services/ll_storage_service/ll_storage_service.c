@@ -28,6 +28,8 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string.h>
+
 #include "infra/log.h"
 
 #include "cfw/cfw.h"
@@ -63,8 +65,34 @@ extern const flash_device_t flash_devices[];
 static struct {
 	flash_partition_t *partitions;
 	uint8_t no_part;
+	/* Index in partitions of each partition id, -1 if none */
+	int8_t *partition_lut;
+	uint16_t partition_lut_size;
 } ll_storage_config;
 
+#ifdef CONFIG_LL_STORAGE_READ_CACHE
+#define READ_CACHE_ENTRIES 2
+
+/*
+ * Read-ahead cache of a serial flash partition.
+ *
+ * An entry follows the reads of one partition: when a read starts where the
+ * previous one ended, CONFIG_LL_STORAGE_READ_AHEAD bytes are read at once and
+ * the next reads of the stream are served from RAM.
+ */
+struct read_cache {
+	int16_t partition_index;        /* -1 if the entry is unused */
+	uint32_t offset;                /* Cached offset in the partition */
+	uint32_t size;                  /* Cached bytes, 0 if none */
+	uint32_t next;                  /* End of the last read */
+	uint32_t last_used;
+	uint32_t data[CONFIG_LL_STORAGE_READ_AHEAD / sizeof(uint32_t)];
+};
+
+static struct read_cache read_cache[READ_CACHE_ENTRIES];
+static uint32_t read_cache_uses;
+#endif
+
 DEFINE_LOG_MODULE(LOG_MODULE_LL_STORAGE_SERVICE, "LLST")
 
 /* Init and Configure partitions seen by the Storage Service. */
@@ -77,6 +105,24 @@ static void ll_storage_service_init(int service_id, void *queue)
 
 	ll_storage_config.partitions = storage_configuration;
 	ll_storage_config.no_part = NUMBER_OF_PARTITIONS;
+
+	int i;
+	uint16_t size = 0;
+
+	for (i = 0; i < ll_storage_config.no_part; i++)
+		if (ll_storage_config.partitions[i].partition_id >= size)
+			size = ll_storage_config.partitions[i].partition_id + 1;
+	ll_storage_config.partition_lut = balloc(size, NULL);
+	ll_storage_config.partition_lut_size = size;
+	memset(ll_storage_config.partition_lut, -1, size);
+	for (i = 0; i < ll_storage_config.no_part; i++)
+		ll_storage_config.partition_lut[
+			ll_storage_config.partitions[i].partition_id] = i;
+
+#ifdef CONFIG_LL_STORAGE_READ_CACHE
+	for (i = 0; i < READ_CACHE_ENTRIES; i++)
+		read_cache[i].partition_index = -1;
+#endif
 }
 
 CFW_DECLARE_SERVICE(ll_storage, LL_STOR_SERVICE_ID, ll_storage_service_init);
@@ -95,7 +141,269 @@ static void ll_storage_client_disconnected(conn_handle_t *instance)
 	pr_debug(LOG_MODULE_LL_STORAGE_SERVICE, "%s: ", __func__);
 }
 
+static int16_t find_partition(uint16_t partition_id)
+{
+	if (partition_id >= ll_storage_config.partition_lut_size)
+		return -1;
+	return ll_storage_config.partition_lut[partition_id];
+}
+
+static DRIVER_API_RC read_flash(const flash_device_t *flash, uint32_t address,
+				uint32_t len, unsigned int *retlen,
+				uint32_t *buffer)
+{
+	if (flash->flash_location == EMBEDDED_FLASH)
+		return soc_flash_read(address, len, retlen, buffer);
+#ifdef CONFIG_SPI_FLASH
+	return spi_flash_read((struct td_device *)&pf_sba_device_flash_spi0,
+			      address, len, retlen, buffer);
+#else
+	return DRV_RC_FAIL;
+#endif
+}
+
+#ifdef CONFIG_LL_STORAGE_READ_CACHE
+/* Get the cache entry of a partition, or recycle the least recently used */
+static struct read_cache *read_cache_get(int16_t partition_index)
+{
+	struct read_cache *cache = &read_cache[0];
+	int i;
+
+	for (i = 0; i < READ_CACHE_ENTRIES; i++) {
+		if (read_cache[i].partition_index == partition_index) {
+			cache = &read_cache[i];
+			goto found;
+		}
+		if (read_cache[i].last_used < cache->last_used)
+			cache = &read_cache[i];
+	}
+	cache->partition_index = partition_index;
+	cache->size = 0;
+	cache->next = UINT32_MAX;
+found:
+	cache->last_used = ++read_cache_uses;
+	return cache;
+}
+
+/* Drop the cached data of a partition before it is modified */
+static void read_cache_invalidate(int16_t partition_index)
+{
+	int i;
+
+	for (i = 0; i < READ_CACHE_ENTRIES; i++)
+		if (read_cache[i].partition_index == partition_index)
+			read_cache[i].size = 0;
+}
+
+/*
+ * Read len words at offset of a partition, through its read cache.
+ */
+static DRIVER_API_RC read_cached(int16_t partition_index, uint32_t offset,
+				 uint32_t len, unsigned int *retlen,
+				 uint32_t *buffer)
+{
+	flash_partition_t *partition =
+		&ll_storage_config.partitions[partition_index];
+	const flash_device_t *flash = &flash_devices[partition->flash_id];
+	uint32_t base = partition->start_block * flash->block_size;
+	uint32_t end = (partition->end_block + 1) * flash->block_size - base;
+	struct read_cache *cache = read_cache_get(partition_index);
+	uint32_t bytes = len * sizeof(uint32_t);
+	uint32_t fill = sizeof(cache->data);
+
+	if (cache->size && offset >= cache->offset &&
+	    offset + bytes <= cache->offset + cache->size)
+		goto hit;
+
+	if (fill > end - offset)
+		fill = end - offset;
+	if (offset != cache->next || bytes > fill) {
+		/* Not a sequential access, or too large for the cache */
+		cache->next = offset + bytes;
+		return read_flash(flash, base + offset, len, retlen, buffer);
+	}
+
+	/* Sequential access, read ahead */
+	cache->size = 0;
+	if (read_flash(flash, base + offset, fill / sizeof(uint32_t), retlen,
+		       cache->data) != DRV_RC_OK ||
+	    *retlen != fill / sizeof(uint32_t)) {
+		cache->next = offset + bytes;
+		return read_flash(flash, base + offset, len, retlen, buffer);
+	}
+	cache->offset = offset;
+	cache->size = fill;
+
+hit:
+	memcpy(buffer, (uint8_t *)cache->data + offset - cache->offset, bytes);
+	*retlen = len;
+	cache->next = offset + bytes;
+	return DRV_RC_OK;
+}
+#endif
+
+static DRIVER_API_RC erase_blocks(uint16_t flash_id, uint32_t start_block,
+				  uint32_t no_blks)
+{
+	if (flash_devices[flash_id].flash_location == EMBEDDED_FLASH)
+		return soc_flash_block_erase(start_block, no_blks);
+#ifdef CONFIG_SPI_FLASH
+	return spi_flash_sector_erase(
+		(struct td_device *)&pf_sba_device_flash_spi0,
+		start_block, no_blks);
+#else
+	return DRV_RC_FAIL;
+#endif
+}
+
+static void erase_block_req(struct cfw_message *msg, uint32_t erased);
+static void write_partition_req(struct cfw_message *msg, uint32_t erased);
+
+bool ll_storage_erase_step(struct cfw_message *msg, uint32_t erased)
+{
+	flash_partition_t *partition;
+	int16_t partition_index;
+	uint32_t block;
+
+	if (CFW_MESSAGE_ID(msg) == MSG_ID_LL_ERASE_BLOCK_REQ) {
+		ll_storage_erase_block_req_msg_t *req =
+			(ll_storage_erase_block_req_msg_t *)msg;
+
+		partition_index = find_partition(req->partition_id);
+		if (req->no_blks < erased + 2 || partition_index == -1)
+			return false;
+		partition = &ll_storage_config.partitions[partition_index];
+#ifdef CONFIG_LL_STORAGE_READ_CACHE
+		read_cache_invalidate(partition_index);
+#endif
+		block = partition->start_block + req->st_blk;
+		if (block + req->no_blks - 1 > partition->end_block ||
+		    erase_blocks(partition->flash_id, block + erased,
+				 1) != DRV_RC_OK)
+			return false;
+		return true;
+	} else if (CFW_MESSAGE_ID(msg) == MSG_ID_LL_WRITE_PARTITION_REQ) {
+		ll_storage_write_partition_req_msg_t *req =
+			(ll_storage_write_partition_req_msg_t *)msg;
+
+		partition_index = find_partition(req->partition_id);
+		if (req->write_type != ERASE_REQ || partition_index == -1)
+			return false;
+		partition = &ll_storage_config.partitions[partition_index];
+#ifdef CONFIG_LL_STORAGE_READ_CACHE
+		read_cache_invalidate(partition_index);
+#endif
+		block = partition->start_block + erased;
+		/* The last block is erased by the regular handler */
+		if (block >= partition->end_block ||
+		    erase_blocks(partition->flash_id, block, 1) != DRV_RC_OK)
+			return false;
+		return true;
+	}
+	return false;
+}
+
+void ll_storage_handle_erase(struct cfw_message *msg, uint32_t erased)
+{
+	if (CFW_MESSAGE_ID(msg) == MSG_ID_LL_ERASE_BLOCK_REQ)
+		erase_block_req(msg, erased);
+	else
+		write_partition_req(msg, erased);
+	cfw_msg_free(msg);
+}
+
+void ll_storage_handle_write_batch(struct cfw_message **msgs, int count)
+{
+	ll_storage_write_partition_req_msg_t *first =
+		(ll_storage_write_partition_req_msg_t *)msgs[0];
+	ll_storage_write_partition_req_msg_t *last =
+		(ll_storage_write_partition_req_msg_t *)msgs[count - 1];
+	int16_t partition_index = find_partition(first->partition_id);
+	uint32_t size = last->st_offset + last->size - first->st_offset;
+	unsigned int retlen = 0;
+	DRIVER_API_RC ret = DRV_RC_FAIL;
+	OS_ERR_TYPE err = E_OS_OK;
+	flash_device_t flash;
+	uint8_t *buffer = NULL;
+	int i;
+
+	if (partition_index != -1)
+		flash = flash_devices[
+			ll_storage_config.partitions[partition_index].flash_id];
+
+	if (count >= 2 && size <= LL_STORAGE_WRITE_BATCH_MAX)
+		buffer = balloc(size + sizeof(uint32_t), &err);
+
+	/* Let the regular handler report errors, and write the requests one by
+	 * one when there is no memory for the staging buffer */
+	if (buffer == NULL || err != E_OS_OK || partition_index == -1 ||
+	    ((ll_storage_config.partitions[partition_index].start_block *
+	      flash.block_size) + first->st_offset + size) >
+	    ((ll_storage_config.partitions[partition_index].end_block + 1) *
+	     flash.block_size)) {
+		if (buffer)
+			bfree(buffer);
+		for (i = 0; i < count; i++)
+			handle_message(msgs[i], NULL);
+		return;
+	}
+
+#ifdef CONFIG_LL_STORAGE_READ_CACHE
+	read_cache_invalidate(partition_index);
+#endif
+	for (i = 0; i < count; i++) {
+		ll_storage_write_partition_req_msg_t *req =
+			(ll_storage_write_partition_req_msg_t *)msgs[i];
+		memcpy(buffer + req->st_offset - first->st_offset,
+		       req->buffer, req->size);
+	}
+
+	uint32_t address =
+		(ll_storage_config.partitions[partition_index].start_block *
+		 flash.block_size) + first->st_offset;
+	size = size / sizeof(uint32_t) + !!(size % sizeof(uint32_t));
+
+	if (flash.flash_location == EMBEDDED_FLASH) {
+		ret = soc_flash_write(address, size, &retlen,
+				      (uint32_t *)buffer);
+#ifdef CONFIG_SPI_FLASH
+	} else { // SERIAL_FLASH
+		ret = spi_flash_write(
+			(struct td_device *)&pf_sba_device_flash_spi0,
+			address, size, &retlen, (uint32_t *)buffer);
+#endif
+	}
+	bfree(buffer);
+
+	/* Split the written length between the requests */
+	retlen *= sizeof(uint32_t);
+	for (i = 0; i < count; i++) {
+		ll_storage_write_partition_req_msg_t *req =
+			(ll_storage_write_partition_req_msg_t *)msgs[i];
+		ll_storage_service_write_rsp_msg_t *resp =
+			(ll_storage_service_write_rsp_msg_t *)cfw_alloc_rsp_msg(
+				msgs[i],
+				MSG_ID_LL_STORAGE_SERVICE_WRITE_RSP,
+				sizeof(*resp));
+		uint32_t offset = req->st_offset - first->st_offset;
+
+		resp->actual_size = retlen <= offset ? 0 :
+				    retlen - offset >= req->size ? req->size :
+				    retlen - offset;
+		resp->status = ret;
+		resp->write_type = req->write_type;
+		cfw_send_message(resp);
+		cfw_msg_free(msgs[i]);
+	}
+}
+
 void handle_erase_block(struct cfw_message *msg)
+{
+	erase_block_req(msg, 0);
+}
+
+/* Erase the blocks of an erase block request, but the first erased ones */
+static void erase_block_req(struct cfw_message *msg, uint32_t erased)
 {
 	ll_storage_erase_block_req_msg_t *req =
 		(ll_storage_erase_block_req_msg_t *)msg;
@@ -108,7 +416,6 @@ void handle_erase_block(struct cfw_message *msg)
 	flash_device_t flash;
 	uint16_t flash_id = 0;
 	int16_t partition_index = -1;
-	uint32_t i = 0;
 	DRIVER_API_RC ret = DRV_RC_FAIL;
 
 	if (req->no_blks == 0) {
@@ -118,13 +425,9 @@ void handle_erase_block(struct cfw_message *msg)
 		goto send;
 	}
 
-	for (i = 0; i < ll_storage_config.no_part; i++)
-		if (ll_storage_config.partitions[i].partition_id ==
-		    req->partition_id) {
-			flash_id = ll_storage_config.partitions[i].flash_id;
-			partition_index = i;
-			break;
-		}
+	partition_index = find_partition(req->partition_id);
+	if (partition_index != -1)
+		flash_id = ll_storage_config.partitions[partition_index].flash_id;
 
 	if (partition_index == -1) {
 		pr_debug(
@@ -147,13 +450,16 @@ void handle_erase_block(struct cfw_message *msg)
 	}
 
 	flash = flash_devices[flash_id];
+#ifdef CONFIG_LL_STORAGE_READ_CACHE
+	read_cache_invalidate(partition_index);
+#endif
 
 	if (flash.flash_location == EMBEDDED_FLASH) {
 		ret =
 			soc_flash_block_erase(
 				ll_storage_config.partitions[partition_index].
 				start_block +
-				req->st_blk, req->no_blks);
+				req->st_blk + erased, req->no_blks - erased);
 	}
 #ifdef CONFIG_SPI_FLASH
 	else {
@@ -161,8 +467,9 @@ void handle_erase_block(struct cfw_message *msg)
 		ret = spi_flash_sector_erase(
 			(struct td_device *)&pf_sba_device_flash_spi0,
 			ll_storage_config.partitions[
-				partition_index].start_block + req->st_blk,
-			req->no_blks);
+				partition_index].start_block + req->st_blk +
+			erased,
+			req->no_blks - erased);
 	}
 #endif
 
@@ -172,6 +479,12 @@ send:
 }
 
 void handle_write_partition(struct cfw_message *msg)
+{
+	write_partition_req(msg, 0);
+}
+
+/* Write a partition, an ERASE_REQ skips the first erased blocks */
+static void write_partition_req(struct cfw_message *msg, uint32_t erased)
 {
 	ll_storage_write_partition_req_msg_t *req =
 		(ll_storage_write_partition_req_msg_t *)msg;
@@ -184,7 +497,6 @@ void handle_write_partition(struct cfw_message *msg)
 	flash_device_t flash;
 	uint16_t flash_id = 0;
 	int16_t partition_index = -1;
-	uint32_t i = 0;
 	uint32_t size = 0;
 	unsigned int retlen = 0;
 	DRIVER_API_RC ret = DRV_RC_FAIL;
@@ -204,13 +516,9 @@ void handle_write_partition(struct cfw_message *msg)
 		goto send;
 	}
 
-	for (i = 0; i < ll_storage_config.no_part; i++)
-		if (ll_storage_config.partitions[i].partition_id ==
-		    req->partition_id) {
-			flash_id = ll_storage_config.partitions[i].flash_id;
-			partition_index = i;
-			break;
-		}
+	partition_index = find_partition(req->partition_id);
+	if (partition_index != -1)
+		flash_id = ll_storage_config.partitions[partition_index].flash_id;
 
 	if (partition_index == -1) {
 		pr_debug(
@@ -234,32 +542,19 @@ void handle_write_partition(struct cfw_message *msg)
 	}
 
 	size = req->size / sizeof(uint32_t) + !!(req->size % sizeof(uint32_t));
+#ifdef CONFIG_LL_STORAGE_READ_CACHE
+	read_cache_invalidate(partition_index);
+#endif
 
 	if (req->write_type == ERASE_REQ) {
-		if (flash.flash_location == EMBEDDED_FLASH) {
-			ret = soc_flash_block_erase(
-				ll_storage_config.partitions[partition_index].
-				start_block,
-				(ll_storage_config.
-				 partitions[partition_index
-				 ].end_block -
-				 ll_storage_config.
-				 partitions[partition_index].
-				 start_block) + 1);
-#ifdef CONFIG_SPI_FLASH
-		} else { // SERIAL_FLASH
-			ret = spi_flash_sector_erase(
-				(struct td_device *)&pf_sba_device_flash_spi0,
-				ll_storage_config.
-				partitions[partition_index].start_block,
-				(ll_storage_config.
-				 partitions[
-					 partition_index].end_block -
-				 ll_storage_config.
-				 partitions[partition_index].
-				 start_block) + 1);
-#endif
-		}
+		uint32_t start_block =
+			ll_storage_config.partitions[partition_index].
+			start_block + erased;
+
+		ret = erase_blocks(flash_id, start_block,
+				   (ll_storage_config.
+				    partitions[partition_index].end_block -
+				    start_block) + 1);
 	} else {
 		uint32_t address =
 			((ll_storage_config.partitions[partition_index].
@@ -306,7 +601,6 @@ void handle_read_partition(struct cfw_message *msg)
 	flash_device_t flash;
 	uint16_t flash_id = 0;
 	int16_t partition_index = -1;
-	uint32_t i = 0;
 	uint32_t size = 0;
 	unsigned int retlen = 0;
 	DRIVER_API_RC ret = DRV_RC_FAIL;
@@ -318,13 +612,9 @@ void handle_read_partition(struct cfw_message *msg)
 		goto send;
 	}
 
-	for (i = 0; i < ll_storage_config.no_part; i++)
-		if (ll_storage_config.partitions[i].partition_id ==
-		    req->partition_id) {
-			flash_id = ll_storage_config.partitions[i].flash_id;
-			partition_index = i;
-			break;
-		}
+	partition_index = find_partition(req->partition_id);
+	if (partition_index != -1)
+		flash_id = ll_storage_config.partitions[partition_index].flash_id;
 
 	if (partition_index == -1) {
 		pr_debug(LOG_MODULE_LL_STORAGE_SERVICE,
@@ -352,15 +642,14 @@ void handle_read_partition(struct cfw_message *msg)
 		  flash.block_size) + req->st_offset);
 	resp->buffer = balloc(size * sizeof(uint32_t), NULL);
 
-	if (flash.flash_location == EMBEDDED_FLASH) {
-		ret = soc_flash_read(address, size, &retlen, resp->buffer);
-#ifdef CONFIG_SPI_FLASH
-	} else { // SERIAL_FLASH
-		ret = spi_flash_read(
-			(struct td_device *)&pf_sba_device_flash_spi0,
-			address, size, &retlen, resp->buffer);
+#ifdef CONFIG_LL_STORAGE_READ_CACHE
+	/* The embedded flash is memory mapped, only cache the serial flash */
+	if (flash.flash_location == SERIAL_FLASH)
+		ret = read_cached(partition_index, req->st_offset, size,
+				  &retlen, resp->buffer);
+	else
 #endif
-	}
+	ret = read_flash(&flash, address, size, &retlen, resp->buffer);
 
 	resp->actual_read_size =
 		(retlen * sizeof(uint32_t)) - (((req->size % sizeof(uint32_t)))
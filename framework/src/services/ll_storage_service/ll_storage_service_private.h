@@ -32,6 +32,7 @@
 #define __LL_STORAGE_SERVICE_PRIVATE_H__
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "cfw/cfw.h"
 #include "services/services_ids.h"
@@ -93,5 +94,53 @@ typedef struct ll_storage_read_partition_req_msg {
 	uint32_t size;
 } ll_storage_read_partition_req_msg_t;
 
+/**
+ * Erase the next block of a multi-block erase request.
+ *
+ * Used by the storage task to split long erases so that other requests
+ * can be served in between. msg is not modified: the storage task keeps
+ * the count of erased blocks.
+ *
+ * @param msg    Erase block request, or partition write request of
+ *               ERASE_REQ type.
+ * @param erased Number of leading blocks of msg already erased.
+ *
+ * @return true if a block was erased and msg still has blocks to erase,
+ *         false if msg must be handled with ll_storage_handle_erase().
+ */
+bool ll_storage_erase_step(struct cfw_message *msg, uint32_t erased);
+
+/**
+ * Handle an erase request whose leading blocks were erased by
+ * ll_storage_erase_step().
+ *
+ * The response is sent and msg is freed.
+ *
+ * @param msg    Erase block request, or partition write request of
+ *               ERASE_REQ type.
+ * @param erased Number of leading blocks of msg already erased.
+ */
+void ll_storage_handle_erase(struct cfw_message *msg, uint32_t erased);
+
+/**
+ * Largest size of the requests merged in a batch. The staging buffer of the
+ * batch, rounded up to 4 bytes, then fits in a 512-byte memory pool block.
+ */
+#define LL_STORAGE_WRITE_BATCH_MAX 508
+
+/**
+ * Handle write requests to consecutive areas of a partition with a single
+ * flash write.
+ *
+ * Each request gets its own response and is freed. If the staging buffer
+ * cannot be allocated, the requests are written one by one.
+ *
+ * @param msgs  Write requests of WRITE_REQ type, in increasing offset order,
+ *              each starting where the previous ends. All but the last
+ *              have a size multiple of 4, and their total size is at most
+ *              LL_STORAGE_WRITE_BATCH_MAX.
+ * @param count Number of requests in msgs.
+ */
+void ll_storage_handle_write_batch(struct cfw_message **msgs, int count);
 
 #endif /* __LL_STORAGE_SERVICE_PRIVATE_H__ */
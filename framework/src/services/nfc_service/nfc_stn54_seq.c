@@ -42,6 +42,15 @@
 #include <drivers/spi_flash.h>
 static T_TIMER fwu_timer;
 static ndlc_msg_t tx_msg;
+
+/* The image is read from flash in large chunks and the commands are parsed
+ * from this buffer (a command is at most 255 bytes: length, body, delay) */
+#define FWU_BUF_SIZE 1024
+static uint8_t fwu_buf[FWU_BUF_SIZE];
+static uint16_t fwu_pos;        /* next command in fwu_buf */
+static uint16_t fwu_len;        /* valid bytes in fwu_buf */
+static uint32_t fwu_rd_offset;  /* flash offset of the byte after fwu_buf */
+static uint32_t fwu_unread;     /* image bytes not read from flash yet */
 #endif
 
 static const uint8_t fdt_reg_tuned[] = { 0x84, 0x01, 0x00, 0x24, 0x82, 0x11,
@@ -116,6 +125,41 @@ static void fwu_timer_cb(void *param)
 	return;
 }
 
+/* Move the unparsed bytes to the start of fwu_buf and fill the rest */
+static int fwu_refill(void)
+{
+	uint16_t keep = fwu_len - fwu_pos;
+	uint32_t count = FWU_BUF_SIZE - keep;
+	unsigned int retlen;
+	int ret;
+
+	if (count > fwu_unread)
+		count = fwu_unread;
+	if (!count)
+		return DRV_RC_OK;
+
+	memmove(fwu_buf, fwu_buf + fwu_pos, keep);
+	fwu_pos = 0;
+	fwu_len = keep;
+	ret = spi_flash_read_byte((struct td_device *)&pf_sba_device_flash_spi0,
+				  fwu_rd_offset, count, &retlen,
+				  fwu_buf + keep);
+	if (ret != DRV_RC_OK)
+		return ret;
+	fwu_len += count;
+	fwu_rd_offset += count;
+	fwu_unread -= count;
+	return DRV_RC_OK;
+}
+
+/* Whether the next command is completely in fwu_buf */
+static bool fwu_cmd_ready(void)
+{
+	uint16_t avail = fwu_len - fwu_pos;
+
+	return avail && avail >= fwu_buf[fwu_pos] + 2;
+}
+
 int nfc_send_ndlc(uint8_t *buffer, int length)
 {
 	ndlc_msg_t *msg = &tx_msg;
@@ -1092,6 +1136,11 @@ void nfc_scn_fw_update(bool start, uint8_t *rx_data, uint8_t len)
 		memcpy(&len_to_do, &rx_data[0 + sizeof(r_offset)],
 		       sizeof(len_to_do));
 
+		fwu_rd_offset = r_offset;
+		fwu_unread = len_to_do;
+		fwu_pos = 0;
+		fwu_len = 0;
+
 		fwu_timer = timer_create(fwu_timer_cb, "", 250, 0, 0, NULL);
 
 		/* simulate a timer event, to start the update */
@@ -1105,37 +1154,41 @@ void nfc_scn_fw_update(bool start, uint8_t *rx_data, uint8_t len)
 	} else if (rx_msg->pcb == TIMER_MESSAGE_TYPE) {
 		if (p_buffer[0] == 0x03) {
 			if (len_to_do > 0) {
-				uint8_t r_buff[253 + 2];
+				uint8_t *r_buff;
 				uint16_t cmd_len;
 				uint8_t cmd_delay;
-				unsigned int retlen;
-				struct td_device *spidev =
-					(struct td_device *)&
-					pf_sba_device_flash_spi0;
-
-				spi_flash_read_byte(spidev, r_offset, 1,
-						    &retlen,
-						    (uint8_t *)r_buff);
-				spi_flash_read_byte(spidev, r_offset + 1,
-						    r_buff[0] + 1, &retlen,
-						    (uint8_t *)(r_buff + 1));
 
+				/* Normally already prefetched */
+				if (!fwu_cmd_ready())
+					status = fwu_refill();
+				if (status == DRV_RC_OK && !fwu_cmd_ready())
+					/* truncated image */
+					status = DRV_RC_FAIL;
+				if (status != DRV_RC_OK)
+					goto fwu_error;
+
+				r_buff = &fwu_buf[fwu_pos];
 				cmd_len = r_buff[0];
 				cmd_delay = r_buff[cmd_len + 1];
 				status = nfc_send_ndlc(&r_buff[1], cmd_len);
 				if (status == DRV_RC_OK) {
-					cmd_delay = r_buff[cmd_len + 1];
+					fwu_pos += (cmd_len + 1 + 1);
 					r_offset += (cmd_len + 1 + 1); /*len + cmd + delay */
 					len_to_do -= (cmd_len + 1 + 1); // The complete command (length command) + byte of length_command (1) + byte of Delay (1)
 					timer_start(fwu_timer, 8 * cmd_delay,
 						    NULL);
-					pr_info(LOG_MODULE_NFC,
-						"c:%3db, d:%3dms, r:%5db",
-						cmd_len, 8 *
-						cmd_delay,
-						len_to_do);
+					pr_debug(LOG_MODULE_NFC,
+						 "c:%3db, d:%3dms, r:%5db",
+						 cmd_len, 8 *
+						 cmd_delay,
+						 len_to_do);
+					/* Read ahead while the controller
+					 * processes the command */
+					if (len_to_do > 0 && !fwu_cmd_ready())
+						status = fwu_refill();
 				}
 			}
+fwu_error:
 
 			if (len_to_do > 0 && status != DRV_RC_OK) {
 				timer_stop(fwu_timer);
@@ -34,6 +34,82 @@
 #include "sensor_svc.h"
 #include "sensor_svc_utils.h"
 
+/*
+ * Answer a request that the sensor core refused, the way its own response
+ * would have, so that the client is not left waiting.
+ */
+static void send_busy_rsp_to_clients(struct ia_cmd *cmd)
+{
+	struct sensor_id *sensor = (struct sensor_id *)cmd->param;
+	sensor_service_t handle;
+
+	if (cmd->cmd_id == CMD_GET_SENSOR_LIST) {
+		struct sensor_type_bit_map *bitmap =
+			(struct sensor_type_bit_map *)cmd->param;
+		ss_send_scan_rsp_msg_to_clients(bitmap->bit_map,
+						RESP_DEVICE_BUSY,
+						cmd->conn_client,
+						cmd->priv_data_from_client);
+		return;
+	}
+	if (cmd->length < sizeof(struct ia_cmd) + sizeof(struct sensor_id))
+		return;
+
+	handle = GET_SENSOR_HANDLE(sensor->sensor_type, sensor->dev_id);
+	switch (cmd->cmd_id) {
+	case CMD_SUBSCRIBE_SENSOR_DATA:
+		ss_send_subscribing_rsp_msg_to_clients(handle, RESP_DEVICE_BUSY,
+						       cmd->conn_client,
+						       cmd->priv_data_from_client);
+		break;
+	case CMD_UNSUBSCRIBE_SENSOR_DATA:
+		ss_send_unsubscribing_rsp_msg_to_clients(handle,
+							 RESP_DEVICE_BUSY,
+							 cmd->conn_client,
+							 cmd->priv_data_from_client);
+		break;
+	case CMD_CALIBRATION:
+		ss_send_cal_rsp_and_data_to_clients(
+			handle,
+			((struct calibration *)cmd->param)->calibration_type,
+			0, NULL, RESP_DEVICE_BUSY,
+			cmd->conn_client, cmd->priv_data_from_client);
+		break;
+	case CMD_GET_PROPERTY:
+		ss_send_get_property_data_to_clients(handle, 0, NULL,
+						     RESP_DEVICE_BUSY,
+						     cmd->conn_client,
+						     cmd->priv_data_from_client);
+		break;
+	case CMD_SET_PROPERTY:
+		ss_send_set_property_rsp_to_clients(handle, RESP_DEVICE_BUSY,
+						    cmd->conn_client,
+						    cmd->priv_data_from_client);
+		break;
+	case CMD_START_SENSOR:
+	case CMD_STOP_SENSOR:
+		/* No response is sent to clients for these */
+		SS_PRINT_ERR("Sensor %d/%d %s lost", sensor->sensor_type,
+			     sensor->dev_id,
+			     cmd->cmd_id == CMD_START_SENSOR ? "start" : "stop");
+		break;
+	default:
+		break;
+	}
+}
+
+static int send_cmd_to_core(struct ia_cmd *cmd)
+{
+	int err = ipc_2core_request(cmd);
+
+	if (err == IPC_STS_ERR_OVERFLOW) {
+		SS_PRINT_ERR("Sensor core busy, cmd %d refused", cmd->cmd_id);
+		send_busy_rsp_to_clients(cmd);
+		bfree(cmd);
+	}
+	return err;
+}
+
 int send_request_cmd_to_core(uint8_t			tran_id,
 			     uint8_t			sensor_id,
 			     uint32_t			param1,
@@ -112,7 +188,7 @@ int send_request_cmd_to_core(uint8_t			tran_id,
 	cmd->cmd_id = cmd_id;
 	cmd->conn_client = p_req->conn;
 	cmd->priv_data_from_client = p_req->priv;
-	return ipc_2core_send(cmd);
+	return send_cmd_to_core(cmd);
 }
 
 int svc_send_scan_cmd_to_core(uint32_t			sensor_type_bit_map,
@@ -203,7 +279,7 @@ int svc_send_calibration_cmd_to_core(ss_sensor_calibration_req_t *req)
 	cmd->cmd_id = CMD_CALIBRATION;
 	cmd->conn_client = req->header.conn;
 	cmd->priv_data_from_client = req->header.priv;
-	return ipc_2core_send(cmd);
+	return send_cmd_to_core(cmd);
 }
 
 void ss_sc_resp_msg_handler(sc_rsp_t *p_msg)
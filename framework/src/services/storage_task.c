@@ -29,6 +29,7 @@
  */
 
 #include <zephyr.h>
+#include <string.h>
 
 #include "util/assert.h"
 
@@ -37,6 +38,20 @@
 #include "infra/system_events.h"
 #include "cfw/cfw.h"
 #include "services/services_ids.h"
+#ifdef CONFIG_STORAGE_IO_SCHED
+#include "infra/port.h"
+#include "infra/time.h"
+#ifdef CONFIG_SERVICES_QUARK_SE_LL_STORAGE_IMPL
+#include "ll_storage_service/ll_storage_service_private.h"
+#endif
+#ifdef CONFIG_SERVICES_QUARK_SE_PROPERTIES_IMPL
+#include "properties_service/properties_service_internal.h"
+#endif
+#ifdef CONFIG_TCMD
+#include <stdio.h>
+#include "infra/tcmd/handler.h"
+#endif
+#endif
 
 /* Definition of the private task "TASK_STORAGE" */
 DEFINE_TASK(TASK_STORAGE, 7, storage_task, 2048, 0);
@@ -65,9 +80,291 @@ void init_storage(void)
 	task_start(TASK_STORAGE);
 }
 
+#ifdef CONFIG_STORAGE_IO_SCHED
+/*
+ * I/O scheduler of the storage task.
+ *
+ * Requests are pulled from the storage queue into a small window, kept in
+ * arrival order, and dispatched one at a time:
+ * - a read may bypass the writes and erases queued before it, as long as
+ *   none of them targets the same domain (low level storage partition, or
+ *   properties); other requests are never reordered,
+ * - multi-block erases are done one block per step, so that reads of other
+ *   partitions are served between two blocks,
+ * - consecutive writes to the same partition are done with a single flash
+ *   write.
+ */
+#define STORAGE_IO_DEPTH        16
+/* Dispatches of reads ahead of the oldest request before it must be served */
+#define STORAGE_IO_MAX_BYPASS   8
+
+/* Domain of a request, partition ids are positive */
+#define DOMAIN_ANY              -1      /* Conflicts with all domains */
+#define DOMAIN_PROPERTIES       -2
+
+enum storage_io_class {
+	STORAGE_IO_READ,
+	STORAGE_IO_WRITE,
+	STORAGE_IO_ERASE,
+	STORAGE_IO_OTHER,
+	STORAGE_IO_CLASSES
+};
+
+struct storage_io {
+	struct cfw_message *msg;
+	uint32_t queued;        /* Uptime in 32k ticks at enqueue */
+	int32_t domain;
+	uint8_t class;
+	uint32_t erased;        /* Blocks erased by the erase steps */
+};
+
+static struct storage_io pending[STORAGE_IO_DEPTH];
+static int pending_count;
+static int bypass_count;
+
+/* Latency histograms, bucket n counts latencies below 2^n ms */
+#define STORAGE_IO_BUCKETS      10
+
+static struct {
+	uint32_t latency[STORAGE_IO_CLASSES][STORAGE_IO_BUCKETS];
+	uint32_t merged;
+	uint32_t erase_steps;
+} storage_io_stats;
+
+static void storage_io_classify(struct storage_io *io)
+{
+	io->class = STORAGE_IO_OTHER;
+	io->domain = DOMAIN_ANY;
+
+	if (CFW_MESSAGE_TYPE(io->msg) != TYPE_REQ)
+		return;
+
+	switch (CFW_MESSAGE_ID(io->msg)) {
+#ifdef CONFIG_SERVICES_QUARK_SE_LL_STORAGE_IMPL
+	case MSG_ID_LL_READ_PARTITION_REQ:
+		io->class = STORAGE_IO_READ;
+		io->domain = ((ll_storage_read_partition_req_msg_t *)io->msg)->
+			     partition_id;
+		break;
+	case MSG_ID_LL_WRITE_PARTITION_REQ:
+		io->class =
+			((ll_storage_write_partition_req_msg_t *)io->msg)->
+			write_type == ERASE_REQ ? STORAGE_IO_ERASE :
+			STORAGE_IO_WRITE;
+		io->domain = ((ll_storage_write_partition_req_msg_t *)io->msg)->
+			     partition_id;
+		break;
+	case MSG_ID_LL_ERASE_BLOCK_REQ:
+		io->class = STORAGE_IO_ERASE;
+		io->domain = ((ll_storage_erase_block_req_msg_t *)io->msg)->
+			     partition_id;
+		break;
+#endif
+#ifdef CONFIG_SERVICES_QUARK_SE_PROPERTIES_IMPL
+	case MSG_ID_PROP_SERVICE_READ_PROP_REQ:
+		io->class = STORAGE_IO_READ;
+		io->domain = DOMAIN_PROPERTIES;
+		break;
+	case MSG_ID_PROP_SERVICE_ADD_PROP_REQ:
+	case MSG_ID_PROP_SERVICE_REMOVE_PROP_REQ:
+	case MSG_ID_PROP_SERVICE_WRITE_PROP_REQ:
+		io->class = STORAGE_IO_WRITE;
+		io->domain = DOMAIN_PROPERTIES;
+		break;
+#endif
+	}
+}
+
+static bool storage_io_conflict(struct storage_io *a, struct storage_io *b)
+{
+	return a->domain == DOMAIN_ANY || b->domain == DOMAIN_ANY ||
+	       a->domain == b->domain;
+}
+
+static void storage_io_complete(int index, int count)
+{
+	uint32_t now = get_uptime_32k();
+	int i;
+
+	for (i = index; i < index + count; i++) {
+		/* 32k ticks to ms */
+		uint32_t latency = ((now - pending[i].queued) * 1000) >> 15;
+		int bucket = 0;
+
+		while (latency && bucket < STORAGE_IO_BUCKETS - 1) {
+			latency >>= 1;
+			bucket++;
+		}
+		storage_io_stats.latency[pending[i].class][bucket]++;
+	}
+	pending_count -= count;
+	memmove(&pending[index], &pending[index + count],
+		(pending_count - index) * sizeof(pending[0]));
+}
+
+#ifdef CONFIG_SERVICES_QUARK_SE_LL_STORAGE_IMPL
+/* Dispatch the write at index 0 with the next consecutive writes */
+static int storage_io_write_batch(void)
+{
+	struct cfw_message *msgs[STORAGE_IO_DEPTH];
+	ll_storage_write_partition_req_msg_t *prev =
+		(ll_storage_write_partition_req_msg_t *)pending[0].msg;
+	uint32_t size = prev->size;
+	int count = 1;
+	int i;
+
+	msgs[0] = pending[0].msg;
+	for (i = 1; i < pending_count; i++) {
+		ll_storage_write_partition_req_msg_t *req =
+			(ll_storage_write_partition_req_msg_t *)pending[i].msg;
+
+		if (!storage_io_conflict(&pending[0], &pending[i]))
+			continue;
+		/* Only merge the requests that directly follow */
+		if (pending[i].class != STORAGE_IO_WRITE ||
+		    CFW_MESSAGE_ID(pending[i].msg) !=
+		    MSG_ID_LL_WRITE_PARTITION_REQ ||
+		    (prev->size % sizeof(uint32_t)) ||
+		    req->st_offset != prev->st_offset + prev->size ||
+		    size + req->size > LL_STORAGE_WRITE_BATCH_MAX)
+			break;
+		size += req->size;
+		/* Move the request next to the previous ones */
+		struct storage_io io = pending[i];
+		memmove(&pending[count + 1], &pending[count],
+			(i - count) * sizeof(pending[0]));
+		pending[count] = io;
+		msgs[count++] = io.msg;
+		prev = req;
+	}
+
+	if (count == 1)
+		return 0;
+
+	ll_storage_handle_write_batch(msgs, count);
+	storage_io_stats.merged += count - 1;
+	return count;
+}
+#endif
+
+static void storage_io_dispatch(void)
+{
+	int i, j;
+#ifdef CONFIG_SERVICES_QUARK_SE_LL_STORAGE_IMPL
+	int count;
+#endif
+
+	/* Look for a read that no older request has to go before */
+	for (i = 0; i < pending_count && bypass_count < STORAGE_IO_MAX_BYPASS;
+	     i++) {
+		if (pending[i].class != STORAGE_IO_READ)
+			continue;
+		for (j = 0; j < i; j++)
+			if (pending[j].class != STORAGE_IO_READ &&
+			    storage_io_conflict(&pending[i], &pending[j]))
+				break;
+		if (j == i)
+			break;
+	}
+	if (i == pending_count || bypass_count == STORAGE_IO_MAX_BYPASS)
+		i = 0;
+	bypass_count = i ? bypass_count + 1 : 0;
+
+#ifdef CONFIG_SERVICES_QUARK_SE_LL_STORAGE_IMPL
+	if (i == 0 && pending[0].class == STORAGE_IO_ERASE) {
+		if (ll_storage_erase_step(pending[0].msg, pending[0].erased)) {
+			/* More blocks to erase, let the reads go first */
+			pending[0].erased++;
+			storage_io_stats.erase_steps++;
+			return;
+		}
+		if (pending[0].erased) {
+			ll_storage_handle_erase(pending[0].msg,
+						pending[0].erased);
+			storage_io_complete(0, 1);
+			return;
+		}
+	}
+	if (i == 0 && pending[0].class == STORAGE_IO_WRITE &&
+	    CFW_MESSAGE_ID(pending[0].msg) == MSG_ID_LL_WRITE_PARTITION_REQ &&
+	    (count = storage_io_write_batch())) {
+		storage_io_complete(0, count);
+		return;
+	}
+#endif
+	port_process_message(&pending[i].msg->m);
+	storage_io_complete(i, 1);
+}
+
+static void storage_io_loop(void)
+{
+	T_QUEUE_MESSAGE m;
+	OS_ERR_TYPE err;
+
+	while (1) {
+		/* Only wait for requests when none is pending */
+		while (pending_count < STORAGE_IO_DEPTH) {
+			queue_get_message(storage_queue, &m,
+					  pending_count ? OS_NO_WAIT :
+					  OS_WAIT_FOREVER, &err);
+			if (err != E_OS_OK)
+				break;
+			if (m == NULL)
+				continue;
+			pending[pending_count].msg = (struct cfw_message *)m;
+			pending[pending_count].queued = get_uptime_32k();
+			pending[pending_count].erased = 0;
+			storage_io_classify(&pending[pending_count++]);
+		}
+		if (pending_count)
+			storage_io_dispatch();
+	}
+}
+
+#ifdef CONFIG_TCMD
+/*
+ * Displays the latency histograms of the storage requests: storage latency
+ * One line per class of request (read, write, erase, other), with the count
+ * of requests completed in less than 1, 2, 4, ... 256 ms, and above.
+ * The last line gives the number of merged writes and erase steps.
+ *
+ * @param[in]   argc        Number of arguments in the Test Command (including group and name)
+ * @param[in]   argv        Table of null-terminated buffers containing the arguments
+ * @param[in]   ctx         The opaque context to pass to responses
+ */
+void storage_latency(int argc, char **argv, struct tcmd_handler_ctx *ctx)
+{
+	static const char *const names[STORAGE_IO_CLASSES] = {
+		"read", "write", "erase", "other"
+	};
+	char answer[96];
+	int i, j, len;
+
+	for (i = 0; i < STORAGE_IO_CLASSES; i++) {
+		len = snprintf(answer, sizeof(answer), "%s:", names[i]);
+		for (j = 0; j < STORAGE_IO_BUCKETS; j++)
+			len += snprintf(answer + len, sizeof(answer) - len,
+					" %u", (unsigned int)
+					storage_io_stats.latency[i][j]);
+		TCMD_RSP_PROVISIONAL(ctx, answer);
+	}
+	snprintf(answer, sizeof(answer), "merged: %u erase_steps: %u",
+		 (unsigned int)storage_io_stats.merged,
+		 (unsigned int)storage_io_stats.erase_steps);
+	TCMD_RSP_FINAL(ctx, answer);
+}
+
+DECLARE_TEST_COMMAND_ENG(storage, latency, storage_latency);
+#endif
+#endif
+
 void storage_task(void)
 {
+#ifdef CONFIG_STORAGE_IO_SCHED
+	storage_io_loop();
+#else
 	cfw_loop(storage_queue);
+#endif
 #ifdef CONFIG_SYSTEM_EVENTS
 	system_event_set_xloop(&loop);
 #endif
@@ -0,0 +1,125 @@
+#!/usr/bin/env python
+
+# Copyright (c) 2016, Intel Corporation. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the following disclaimer.
+#
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+#
+# 3. Neither the name of the copyright holder nor the names of its contributors
+# may be used to endorse or promote products derived from this software without
+# specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+
+# Reference decoder for the ACC streaming codec
+# (framework/src/lib/ble/acc/acc_codec.c).
+#
+# The input file contains one notification per line, as hexadecimal bytes,
+# optionally separated by spaces, colons or dashes. The decoded samples are
+# written as "x,y,z" lines. Lost notifications are reported on stderr.
+
+import argparse
+import re
+import sys
+
+HEADER_LEN = 8
+BLOCK_SAMPLES = 4
+
+def to_int16(value):
+    value &= 0xFFFF
+    return value - 0x10000 if value & 0x8000 else value
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+def decode_packet(packet):
+    """Return (sequence number, list of (x, y, z) samples)"""
+    if len(packet) < HEADER_LEN:
+        raise ValueError("truncated header")
+    seq = packet[0]
+    count = packet[1]
+    last = [to_int16(packet[2 + 2 * i] | (packet[3 + 2 * i] << 8))
+            for i in range(3)]
+    samples = [tuple(last)]
+    pos = HEADER_LEN
+    remaining = count - 1
+    while remaining > 0:
+        nb = min(BLOCK_SAMPLES, remaining)
+        width = packet[pos]
+        pos += 1
+        nbytes = (3 * nb * width + 7) // 8
+        if width > 16 or pos + nbytes > len(packet):
+            raise ValueError("truncated block")
+        bits = int.from_bytes(bytes(packet[pos:pos + nbytes]), 'little')
+        pos += nbytes
+        mask = (1 << width) - 1
+        for _ in range(nb):
+            for axis in range(3):
+                delta = unzigzag(bits & mask)
+                bits >>= width
+                last[axis] = to_int16(last[axis] + delta)
+            samples.append(tuple(last))
+        remaining -= nb
+    if pos != len(packet):
+        raise ValueError("trailing bytes")
+    return seq, samples
+
+def parse_line(line):
+    digits = re.sub(r'[\s:\-]', '', line)
+    if len(digits) % 2:
+        raise ValueError("odd number of hex digits")
+    return bytearray.fromhex(digits)
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode ACC notifications")
+    parser.add_argument('notifications',
+                        help='file with one hex encoded notification per line')
+    parser.add_argument('-o', '--output', help='output CSV file (default stdout)')
+    args = parser.parse_args()
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+    expected = None
+    packets = samples = lost = 0
+    with open(args.notifications) as f:
+        for lineno, line in enumerate(f, 1):
+            if not line.strip() or line.startswith('#'):
+                continue
+            try:
+                seq, decoded = decode_packet(parse_line(line))
+            except ValueError as e:
+                sys.stderr.write("line %d: %s\n" % (lineno, e))
+                return 1
+            if expected is not None and seq != expected:
+                missing = (seq - expected) & 0xFF
+                sys.stderr.write("line %d: %d notification(s) lost\n"
+                                 % (lineno, missing))
+                lost += missing
+            expected = (seq + 1) & 0xFF
+            for sample in decoded:
+                out.write("%d,%d,%d\n" % sample)
+            packets += 1
+            samples += len(decoded)
+    sys.stderr.write("%d notifications, %d samples, %d lost notifications\n"
+                     % (packets, samples, lost))
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+
+ *****************************************************************************
+ * Host test for the ACC streaming codec (acc_codec.c).
+ *
+ * Encodes sample streams with a send callback that can be made to fail,
+ * decodes the sent packets like tools/scripts/acc_decode.py and checks that:
+ * - a stream sent without errors decodes to the input samples,
+ * - failed sends never let the pending block overflow, and the packets that
+ *   are sent between failed ones still decode to runs of input samples.
+ *
+ * Compile with:
+ * gcc -Wall -Wextra -O2 -I framework/include tools/tests/acc_codec_test.c \
+ *     framework/src/lib/ble/acc/acc_codec.c -o acc_codec_test
+ *
+ * Usage:
+ * acc_codec_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lib/ble/acc/acc_codec.h"
+
+#define MAX_SAMPLES 4096
+
+static int16_t input[MAX_SAMPLES][3];
+static int16_t output[MAX_SAMPLES][3];
+static int out_count;
+static int send_calls;
+static int fail_every;
+static int failures;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+static uint16_t unzigzag(uint16_t value)
+{
+	return (value >> 1) ^ (uint16_t)-(value & 1);
+}
+
+/* Decode a packet to the output samples */
+static int decode(const uint8_t *packet, int len)
+{
+	int16_t last[3];
+	int remaining = packet[1] - 1;
+	int pos = ACC_CODEC_HEADER_LEN;
+	int axis;
+
+	if (len < ACC_CODEC_HEADER_LEN || !packet[1])
+		return -1;
+	for (axis = 0; axis < 3; axis++)
+		last[axis] = packet[2 + 2 * axis] | packet[3 + 2 * axis] << 8;
+	memcpy(output[out_count++], last, sizeof(last));
+
+	while (remaining > 0) {
+		int nb = remaining < ACC_CODEC_BLOCK_SAMPLES ?
+			 remaining : ACC_CODEC_BLOCK_SAMPLES;
+		int width = packet[pos++];
+		int nbytes = (3 * nb * width + 7) / 8;
+		int bit = 0;
+
+		if (width > 16 || pos + nbytes > len)
+			return -1;
+		for (int i = 0; i < nb; i++) {
+			for (axis = 0; axis < 3; axis++) {
+				uint32_t value = 0;
+
+				for (int b = 0; b < width; b++, bit++)
+					value |= (uint32_t)(packet[pos + bit / 8]
+							    >> (bit % 8) & 1) << b;
+				last[axis] += unzigzag(value);
+			}
+			memcpy(output[out_count++], last, sizeof(last));
+		}
+		pos += nbytes;
+		remaining -= nb;
+	}
+	return pos == len ? 0 : -1;
+}
+
+static int send_cb(uint8_t *packet, uint8_t len)
+{
+	if (fail_every && ++send_calls % fail_every == 0)
+		return -1;
+	CHECK(decode(packet, len) == 0);
+	return 0;
+}
+
+/* x holds the sample index so that the decoded runs can be located */
+static void make_input(int count, int amplitude)
+{
+	for (int i = 0; i < count; i++) {
+		input[i][0] = i;
+		input[i][1] = rand() % (2 * amplitude + 1) - amplitude;
+		input[i][2] = (i & 64) ? INT16_MAX - i : INT16_MIN + i;
+	}
+}
+
+static void test_lossless(uint8_t max_len)
+{
+	struct acc_codec codec;
+	int count = 1000;
+
+	make_input(count, 300);
+	out_count = 0;
+	fail_every = 0;
+	CHECK(acc_codec_init(&codec, send_cb, max_len) == 0);
+	for (int i = 0; i < count; i++)
+		CHECK(acc_codec_push(&codec, input[i]) == 0);
+	CHECK(acc_codec_flush(&codec) == 0);
+	CHECK(out_count == count);
+	CHECK(memcmp(input, output, count * sizeof(input[0])) == 0);
+}
+
+static void test_send_failure(uint8_t max_len, int every)
+{
+	struct acc_codec codec;
+	int count = 2000;
+	int errors = 0;
+
+	/* Small deltas fill the packets with complete blocks, the jumps of z
+	 * then leave a full block pending when the send fails */
+	make_input(count, 3);
+	out_count = 0;
+	send_calls = 0;
+	fail_every = every;
+	CHECK(acc_codec_init(&codec, send_cb, max_len) == 0);
+	for (int i = 0; i < count; i++) {
+		if (acc_codec_push(&codec, input[i]))
+			errors++;
+		CHECK(codec.pending <= ACC_CODEC_BLOCK_SAMPLES);
+	}
+	fail_every = 0;
+	CHECK(acc_codec_flush(&codec) == 0);
+	CHECK(errors > 0);
+
+	/* Every decoded sample is an input sample, lost packets only cut the
+	 * stream between samples */
+	for (int i = 0; i < out_count; i++) {
+		int index = (uint16_t)output[i][0];
+
+		CHECK(index < count);
+		if (index < count)
+			CHECK(memcmp(output[i], input[index],
+				     sizeof(input[0])) == 0);
+		if (i)
+			CHECK(index > (uint16_t)output[i - 1][0]);
+	}
+	CHECK(out_count > 0 && (uint16_t)output[out_count - 1][0] == count - 1);
+}
+
+int main(void)
+{
+	static const uint8_t max_lens[] = { ACC_CODEC_HEADER_LEN + 7, 20,
+					    ACC_CODEC_MAX_PACKET };
+
+	srand(1);
+	for (unsigned i = 0; i < sizeof(max_lens); i++) {
+		test_lossless(max_lens[i]);
+		for (int every = 2; every <= 5; every++)
+			test_send_failure(max_lens[i], every);
+	}
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
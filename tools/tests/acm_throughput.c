@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+
+ *****************************************************************************
+ * Measures the USB CDC-ACM bulk IN throughput of the target and checks the
+ * received data.
+ *
+ * The target sends an incrementing little endian 32 bits counter with the
+ * "usb acm_stream <idx> <bytes>" test command (CONFIG_USB_ACM_STREAM_TCMD).
+ * If a command tty is given, the command is sent by this tool, otherwise it
+ * must be issued once the tool is waiting for data.
+ *
+ * Compile with:
+ * gcc -O2 -Wall tools/tests/acm_throughput.c -o acm_throughput
+ *
+ * Usage:
+ * acm_throughput <data_tty> <bytes> [<cmd_tty> <acm_idx>]
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define READ_TIMEOUT_MS 2000
+
+static int open_tty(const char *path)
+{
+	struct termios tio;
+	int fd = open(path, O_RDWR | O_NOCTTY);
+
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+	if (tcgetattr(fd, &tio) == 0) {
+		cfmakeraw(&tio);
+		/* Return as soon as data is available, with a 0.1s timeout */
+		tio.c_cc[VMIN] = 0;
+		tio.c_cc[VTIME] = 1;
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+	tcflush(fd, TCIOFLUSH);
+	return fd;
+}
+
+static double now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long total, received = 0;
+	uint32_t expected = 0, word = 0;
+	unsigned long errors = 0;
+	int word_bytes = 0;
+	double start = 0, last;
+	uint8_t buf[4096];
+	int fd, i;
+
+	if (argc != 3 && argc != 5) {
+		fprintf(stderr,
+			"Usage: %s <data_tty> <bytes> [<cmd_tty> <acm_idx>]\n",
+			argv[0]);
+		return 1;
+	}
+	total = strtoul(argv[2], NULL, 0) & ~3UL;
+	if ((fd = open_tty(argv[1])) < 0)
+		return 1;
+
+	if (argc == 5) {
+		char cmd[64];
+		int cfd = open_tty(argv[3]);
+		int len;
+
+		if (cfd < 0)
+			return 1;
+		len = snprintf(cmd, sizeof(cmd), "usb acm_stream %s %lu\n",
+			       argv[4], total);
+		if (write(cfd, cmd, len) != len) {
+			perror(argv[3]);
+			return 1;
+		}
+		close(cfd);
+	}
+
+	last = now();
+	while (received < total) {
+		ssize_t n = read(fd, buf, sizeof(buf));
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			perror(argv[1]);
+			return 1;
+		}
+		if (n == 0) {
+			if ((now() - last) * 1000 > READ_TIMEOUT_MS &&
+			    received) {
+				fprintf(stderr, "Timeout after %lu bytes\n",
+					received);
+				break;
+			}
+			continue;
+		}
+		if (!received)
+			start = now();
+		last = now();
+		for (i = 0; i < n; i++) {
+			word |= (uint32_t)buf[i] << (8 * word_bytes);
+			if (++word_bytes == 4) {
+				if (word != expected)
+					errors++;
+				expected = word + 1;
+				word = 0;
+				word_bytes = 0;
+			}
+		}
+		received += n;
+	}
+
+	if (received && last > start)
+		printf("%lu bytes in %.3f s: %.1f kB/s, %lu bad words\n",
+		       received, last - start,
+		       received / (last - start) / 1000, errors);
+	close(fd);
+	return received == total && !errors ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+
+ *****************************************************************************
+ * Host harness running the step cadence algorithm
+ * (projects/curie_ble/arc/alg_step_cadence.c) on an accelerometer trace.
+ *
+ * The algorithm exec function is fed the way the sensor core feeds a single
+ * demand algorithm from a polled sensor (FeedSensDataDirectly()): frames are
+ * decimated from the sensor rate to the demand rate, and the reports flagged
+ * ready are committed after each exec. The uptime is the time of the frame
+ * being fed.
+ *
+ * Without a trace, a synthetic 100 Hz walk of 2 steps per second is fed and
+ * the reports are checked: one every 5 s, each of 120 steps per minute, also
+ * when fed from a 400 Hz sensor. With a trace, in the format of
+ * trace2replay.c (accel lines only), the reports are printed.
+ *
+ * Compile with:
+ * gcc -O2 -Wall -Ibsp/include -Iframework/include \
+ *	-Iframework/include/sensors/sensor_core/open_core \
+ *	-Iprojects/curie_ble/arc tools/tests/algo_replay_test.c \
+ *	-o algo_replay_test -lm
+ *
+ * Usage:
+ * algo_replay_test [-a scale] [-r sensor_rate_hz] [trace]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* The algorithm under test, built with the harness to reach its feed */
+#include "alg_step_cadence.c"
+
+#define MAX_LINE 256
+#define MAX_FRAMES 65535
+#define MAX_REPORTS 1024
+
+struct report {
+	uint32_t time_ms;
+	int cadence;
+};
+
+static struct report reports[MAX_REPORTS];
+static int nb_reports;
+static uint32_t uptime_ms;
+
+/* Raw accel frames, in mg, as returned by the replay sensor */
+static int16_t (*frames)[3];
+static int nb_frames;
+
+/*
+ * Sensor core services used by the algorithm
+ */
+uint32_t get_uptime_ms(void)
+{
+	return uptime_ms;
+}
+
+int GetSensorDataFrameSize(uint8_t type, uint8_t id)
+{
+	return type == SENSOR_ACCELEROMETER ? sizeof(frames[0]) : 0;
+}
+
+exposed_sensor_t *GetExposedStruct(uint8_t type, uint8_t id)
+{
+	return type == stepcadence_exposed_sensor.type ?
+	       &stepcadence_exposed_sensor : NULL;
+}
+
+/* HandleAlgo(): commit the reports flagged ready by a successful exec */
+static void handle_algo(feed_general_t *feed, void **data)
+{
+	if (!feed->ctl_api.exec(data, feed))
+		return;
+	if (stepcadence_exposed_sensor.ready_flag) {
+		struct cadence_result *r = stepcadence_exposed_sensor.rpt_data_buf;
+
+		if (nb_reports < MAX_REPORTS) {
+			reports[nb_reports].time_ms = uptime_ms;
+			reports[nb_reports].cadence = r->cadence;
+			nb_reports++;
+		}
+		stepcadence_exposed_sensor.ready_flag = 0;
+	}
+}
+
+/* Feed the frames polled at rate_hz, FeedSensDataDirectly() style */
+static void replay(feed_general_t *feed, int rate_hz)
+{
+	sensor_data_demand_t *demand = &feed->demand[0];
+	int gap = (int)lround((double)rate_hz / demand->freq);
+	int16_t frame[3];
+	void *ptr[1];
+	int i;
+
+	if (gap < 1)
+		gap = 1;
+	nb_reports = 0;
+	step_count = 0;
+	local_time = 0;
+	feed->ctl_api.init(feed);
+	for (i = 0; i < nb_frames; i += gap) {
+		uptime_ms = (uint32_t)((uint64_t)i * 1000 / rate_hz);
+		memcpy(frame, frames[i], sizeof(frame));
+		ptr[0] = frame;
+		handle_algo(feed, ptr);
+	}
+	feed->ctl_api.deinit(feed);
+}
+
+static int load_trace(const char *file, double scale)
+{
+	char buf[MAX_LINE], name[16];
+	double v[3];
+	FILE *f = fopen(file, "r");
+
+	if (!f) {
+		perror(file);
+		return -1;
+	}
+	frames = malloc(MAX_FRAMES * sizeof(frames[0]));
+	while (fgets(buf, sizeof(buf), f) && nb_frames < MAX_FRAMES) {
+		if (buf[0] == '#')
+			continue;
+		/* Try without then with a leading timestamp */
+		if (sscanf(buf, "%15s %lf %lf %lf", name, &v[0], &v[1],
+			   &v[2]) != 4 &&
+		    sscanf(buf, "%*s %15s %lf %lf %lf", name, &v[0], &v[1],
+			   &v[2]) != 4)
+			continue;
+		if (strncmp(name, "accel", strlen(name)))
+			continue;
+		for (int k = 0; k < 3; k++) {
+			double val = lround(v[k] * scale);
+
+			frames[nb_frames][k] = val > 32767 ? 32767 :
+					       val < -32768 ? -32768 : val;
+		}
+		nb_frames++;
+	}
+	fclose(f);
+	return 0;
+}
+
+/* 20 s of walk at rate_hz: 1 g on z, a step peak at 250 ms every 500 ms */
+static void synthetic_walk(int rate_hz)
+{
+	int i;
+
+	nb_frames = 20 * rate_hz + 1;
+	frames = realloc(frames, nb_frames * sizeof(frames[0]));
+	for (i = 0; i < nb_frames; i++) {
+		uint32_t t = (uint32_t)((uint64_t)i * 1000 / rate_hz);
+
+		frames[i][0] = 20;
+		frames[i][1] = -30;
+		frames[i][2] = t % 500 >= 250 && t % 500 < 260 ? 1400 : 400;
+	}
+}
+
+static int check_walk(int rate_hz)
+{
+	int failures = 0;
+	int i;
+
+	synthetic_walk(rate_hz);
+	replay(&stepcadence_algo, rate_hz);
+	if (nb_reports != 4) {
+		printf("FAIL %d Hz: %d reports, expected 4\n", rate_hz,
+		       nb_reports);
+		failures++;
+	}
+	for (i = 0; i < nb_reports; i++) {
+		if (reports[i].time_ms != (uint32_t)(i + 1) * FIVE_SEC_DURATION ||
+		    reports[i].cadence != 120) {
+			printf("FAIL %d Hz: report %d at %u ms cadence %d, "
+			       "expected %u ms cadence 120\n", rate_hz, i,
+			       reports[i].time_ms, reports[i].cadence,
+			       (i + 1) * FIVE_SEC_DURATION);
+			failures++;
+		}
+	}
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	double scale = 1.0;
+	int rate_hz = 100;
+	int i;
+
+	for (i = 1; i < argc - 1 && argv[i][0] == '-'; i += 2) {
+		if (!strcmp(argv[i], "-a"))
+			scale = strtod(argv[i + 1], NULL);
+		else if (!strcmp(argv[i], "-r"))
+			rate_hz = atoi(argv[i + 1]);
+		else
+			break;
+	}
+	if (rate_hz <= 0 || (i < argc && argv[i][0] == '-')) {
+		fprintf(stderr, "Usage: %s [-a scale] [-r sensor_rate_hz] [trace]\n",
+			argv[0]);
+		return 1;
+	}
+
+	if (i == argc) {
+		int failures = check_walk(100) + check_walk(400);
+
+		if (failures) {
+			printf("%d failures\n", failures);
+			return 1;
+		}
+		printf("OK\n");
+		return 0;
+	}
+
+	if (load_trace(argv[i], scale))
+		return 1;
+	replay(&stepcadence_algo, rate_hz);
+	printf("%d accel frames at %d Hz, %d reports\n", nb_frames, rate_hz,
+	       nb_reports);
+	for (i = 0; i < nb_reports; i++)
+		printf("%8u ms cadence %d\n", reports[i].time_ms,
+		       reports[i].cadence);
+	return 0;
+}
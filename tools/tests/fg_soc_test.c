@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+
+ *****************************************************************************
+ * Checks the fuel gauge SOC lookup against the former linear search, on the
+ * voltage range of each table of a battery LUT, and optionally on recorded
+ * voltage traces (one voltage in mV per line).
+ *
+ * Compile with (one LUT at a time):
+ * gcc -I bsp/include -I framework/src/services/battery_service \
+ *     tools/tests/fg_soc_test.c framework/src/services/battery_service/fg_soc.c \
+ *     framework/src/services/battery_service/battery_LUT/P0469_LF_LUT.c \
+ *     -o fg_soc_test
+ *
+ * Usage:
+ * fg_soc_test [trace]...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "fg_soc.h"
+#include "battery_LUT/battery_LUT.h"
+
+/* Margin, in mV, swept below and above each table */
+#define SWEEP_MARGIN 200
+
+/* The SOC computation of adc_fuel_gauge_api.c before the binary search */
+static uint8_t linear_soc(const uint16_t *p_table, int16_t batt_voltage_mv)
+{
+	uint8_t lookup_index;
+	uint8_t battery_soc_measured = 0;
+
+	if (p_table[BATTPROP_LOOKUP_TABLE_SIZE - 1] < batt_voltage_mv) {
+		battery_soc_measured = FG_SOC_FULL_CHARGE;
+	} else if (batt_voltage_mv >= p_table[FG_SOC_LOOKUP_INDEX_90PRCT]) {
+		battery_soc_measured = FG_SOC_FULL_CHARGE - 1;
+		/* The former loop read one entry past the table */
+		for (lookup_index = FG_SOC_LOOKUP_INDEX_90PRCT;
+		     lookup_index < (BATTPROP_LOOKUP_TABLE_SIZE - 1);
+		     lookup_index++) {
+			if (batt_voltage_mv < p_table[lookup_index + 1]) {
+				battery_soc_measured =
+					90 + (lookup_index -
+					      FG_SOC_LOOKUP_INDEX_90PRCT);
+				break;
+			}
+		}
+	} else if (batt_voltage_mv < p_table[FG_SOC_LOOKUP_INDEX_10PRCT]) {
+		for (lookup_index = 0;
+		     lookup_index <= FG_SOC_LOOKUP_INDEX_10PRCT;
+		     lookup_index++) {
+			if (batt_voltage_mv <= p_table[lookup_index]) {
+				battery_soc_measured = lookup_index;
+				break;
+			}
+		}
+	} else {
+		uint16_t percent_x = 10;
+		for (lookup_index = FG_SOC_LOOKUP_INDEX_10PRCT;
+		     lookup_index < FG_SOC_LOOKUP_INDEX_90PRCT;
+		     lookup_index++, percent_x += 20) {
+			if (batt_voltage_mv < p_table[lookup_index + 1]) {
+				battery_soc_measured = percent_x +
+					(uint16_t)((batt_voltage_mv -
+						    p_table[lookup_index]) *
+						   20) /
+					(p_table[lookup_index + 1] -
+					 p_table[lookup_index]);
+				break;
+			}
+		}
+	}
+	return battery_soc_measured;
+}
+
+static int check(const char *name, int table, const uint16_t *p_table,
+		 int16_t voltage)
+{
+	uint8_t ref = linear_soc(p_table, voltage);
+	uint8_t soc = fg_soc_lookup(p_table, BATTPROP_LOOKUP_TABLE_SIZE,
+				    voltage);
+
+	if (ref == soc)
+		return 0;
+	printf("%s[%d] %dmV: expected %d%%, got %d%%\n", name, table, voltage,
+	       ref, soc);
+	return 1;
+}
+
+static int sweep(const char *name,
+		 const uint16_t tables[][BATTPROP_LOOKUP_TABLE_SIZE])
+{
+	int errors = 0;
+	int i, v;
+
+	for (i = 0; i < BATTPROP_LOOKUP_TABLE_COUNT; i++) {
+		for (v = tables[i][0] - SWEEP_MARGIN;
+		     v <= tables[i][BATTPROP_LOOKUP_TABLE_SIZE - 1] +
+		     SWEEP_MARGIN; v++)
+			errors += check(name, i, tables[i], v);
+		/* The fuel gauge voltage is signed, negative readings are 0% */
+		for (v = -SWEEP_MARGIN; v <= 0; v++)
+			errors += check(name, i, tables[i], v);
+		errors += check(name, i, tables[i], INT16_MIN);
+	}
+	return errors;
+}
+
+static int replay(const char *path,
+		  const uint16_t tables[][BATTPROP_LOOKUP_TABLE_SIZE])
+{
+	FILE *f = fopen(path, "r");
+	int errors = 0;
+	int count = 0;
+	int v;
+	int i;
+
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+	while (fscanf(f, "%d", &v) == 1) {
+		for (i = 0; i < BATTPROP_LOOKUP_TABLE_COUNT; i++)
+			errors += check(path, i, tables[i], v);
+		count++;
+	}
+	fclose(f);
+	printf("%s: %d samples replayed\n", path, count);
+	return errors;
+}
+
+int main(int argc, char **argv)
+{
+	int errors = 0;
+	int i;
+
+	errors += sweep("dflt_lookup_tables", dflt_lookup_tables);
+	errors += sweep("dflt_lookup_tables2", dflt_lookup_tables2);
+	for (i = 1; i < argc; i++) {
+		errors += replay(argv[i], dflt_lookup_tables);
+		errors += replay(argv[i], dflt_lookup_tables2);
+	}
+	printf("%d mismatches\n", errors);
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+
+ *****************************************************************************
+ * Host simulation of the IPC rings: a producer thread and a consumer thread
+ * stand for the two cores, a flag polled by the consumer stands for the
+ * mailbox interrupt.
+ *
+ * Compares, on the same traffic, one synchronous mailbox request per message
+ * (the sender waits for the acknowledge, as ipc_request_sync_int() does) with
+ * the ring (the sender only rings the doorbell when the consumer armed it).
+ * Reports throughput, message latency and number of mailbox transactions, and
+ * checks that no entry is lost or reordered.
+ *
+ * Compile with:
+ * gcc -O2 -pthread -I bsp/include tools/tests/ipc_ring_sim.c \
+ *     bsp/src/infra/ipc_ring.c -o ipc_ring_sim
+ *
+ * Usage:
+ * ipc_ring_sim [messages] [burst]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "infra/ipc_ring.h"
+
+/* Emulated mailbox: data, and interrupt / acknowledge flags */
+static volatile uint32_t mbx_data;
+static volatile int mbx_irq;
+static volatile int mbx_ack;
+static unsigned long mbx_count;
+
+static struct ipc_ring ring;
+static volatile int done;
+
+static uint32_t n_msgs = 1000000;
+static uint32_t burst = 16;
+static uint64_t *sent_ns;
+static uint64_t *lat_ns;
+static uint32_t received;
+static uint32_t errors;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Message handler on the consumer core: entries are index << 1 | free */
+static void handle_entry(uint32_t entry)
+{
+	uint32_t index = entry >> 1;
+
+	if (index != received || (entry & 1) != (index % 5 == 0))
+		errors++;
+	else
+		lat_ns[index] = now_ns() - sent_ns[index];
+	received++;
+}
+
+static void wait_irq(void)
+{
+	while (!mbx_irq) {
+		if (done)
+			return;
+		sched_yield();
+	}
+	mbx_irq = 0;
+}
+
+static void *sync_consumer(void *arg)
+{
+	(void)arg;
+	while (received < n_msgs) {
+		wait_irq();
+		if (done)
+			break;
+		handle_entry(mbx_data);
+		mbx_ack = 1;
+	}
+	return NULL;
+}
+
+static void sync_send(uint32_t entry)
+{
+	mbx_ack = 0;
+	mbx_data = entry;
+	__sync_synchronize();
+	mbx_irq = 1;
+	mbx_count++;
+	while (!mbx_ack)
+		sched_yield();
+}
+
+static void *ring_consumer(void *arg)
+{
+	uint32_t entry;
+
+	(void)arg;
+	while (received < n_msgs) {
+		wait_irq();
+		if (done)
+			break;
+		do {
+			while (ipc_ring_pop(&ring, &entry) == 0)
+				handle_entry(entry);
+		} while (ipc_ring_arm_doorbell(&ring));
+	}
+	return NULL;
+}
+
+static void ring_send(uint32_t entry)
+{
+	while (ipc_ring_push(&ring, entry))
+		sched_yield();
+	if (ipc_ring_take_doorbell(&ring)) {
+		mbx_irq = 1;
+		mbx_count++;
+	}
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void run(const char *name, void *(*consumer)(void *),
+		void (*send)(uint32_t))
+{
+	pthread_t thread;
+	uint64_t start, elapsed;
+	uint32_t i, j;
+
+	mbx_irq = mbx_ack = 0;
+	mbx_count = 0;
+	received = errors = 0;
+	done = 0;
+	ipc_ring_init(&ring);
+	ipc_ring_set_ready(&ring);
+	memset(lat_ns, 0, n_msgs * sizeof(*lat_ns));
+
+	pthread_create(&thread, NULL, consumer, NULL);
+	start = now_ns();
+	for (i = 0; i < n_msgs; i += burst) {
+		for (j = i; j < i + burst && j < n_msgs; j++) {
+			sent_ns[j] = now_ns();
+			send(j << 1 | (j % 5 == 0));
+		}
+		/* Let the consumer catch up between bursts */
+		sched_yield();
+	}
+	while (received < n_msgs && !errors)
+		sched_yield();
+	elapsed = now_ns() - start;
+	done = 1;
+	pthread_join(thread, NULL);
+
+	qsort(lat_ns, n_msgs, sizeof(*lat_ns), cmp_u64);
+	printf("%-5s: %8.0f msg/s, latency p50 %6llu ns p99 %8llu ns, "
+	       "%lu mailbox transactions, %u errors\n",
+	       name, n_msgs * 1e9 / elapsed,
+	       (unsigned long long)lat_ns[n_msgs / 2],
+	       (unsigned long long)lat_ns[n_msgs - n_msgs / 100 - 1],
+	       mbx_count, errors);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1)
+		n_msgs = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		burst = strtoul(argv[2], NULL, 0);
+	if (!n_msgs || !burst || n_msgs > 0x7fffffff) {
+		fprintf(stderr, "Usage: %s [messages] [burst]\n", argv[0]);
+		return 1;
+	}
+	sent_ns = calloc(n_msgs, sizeof(*sent_ns));
+	lat_ns = calloc(n_msgs, sizeof(*lat_ns));
+	if (!sent_ns || !lat_ns)
+		return 1;
+
+	printf("%u messages, bursts of %u, ring of %u entries\n",
+	       n_msgs, burst, IPC_RING_SIZE);
+	run("sync", sync_consumer, sync_send);
+	run("ring", ring_consumer, ring_send);
+
+	free(sent_ns);
+	free(lat_ns);
+	return errors ? 1 : 0;
+}
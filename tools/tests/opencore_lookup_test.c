@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+
+ *****************************************************************************
+ * Unit test for the OpenCore handle lookup table (opencore_lookup.c).
+ *
+ * Registers up to several hundred synthetic sensor, feed and exposed sensor
+ * handles and checks that:
+ * - every registered key resolves to its handle and unknown keys miss,
+ * - the first handle registered under a key is kept,
+ * - a full table reports the overflow,
+ * - the probe length and the lookup time do not grow with the number of
+ *   handles, unlike the list walk the table replaces.
+ *
+ * Compile with:
+ * gcc -O2 -DLOOKUP_TABLE_SIZE=2048 \
+ *	-Iframework/src/sensors/sensor_core/open_core/opencore_src \
+ *	tools/tests/opencore_lookup_test.c \
+ *	framework/src/sensors/sensor_core/open_core/opencore_src/opencore_lookup.c \
+ *	-o opencore_lookup_test
+ *
+ * Usage:
+ * opencore_lookup_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "opencore_lookup.h"
+
+#define MAX_HANDLES  768
+#define MAX_PROBE    16
+#define ROUNDS       200000
+/* Allowed lookup time growth from the smallest to the largest table load */
+#define MAX_SLOWDOWN 3.0
+
+struct handle {
+	struct handle *next;
+	lookup_kind_t kind;
+	uint8_t type;
+	uint8_t id;
+};
+
+static struct handle handles[MAX_HANDLES];
+static struct handle *list_head;
+static int failures;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Spread the handles over the four kinds, 32 types and as many ids as
+ * needed, the way several boards of sensors would register */
+static void make_handles(int count)
+{
+	list_head = NULL;
+	for (int i = count - 1; i >= 0; i--) {
+		handles[i].kind = LOOKUP_INT + i % 4;
+		handles[i].type = (i / 4) % 32;
+		handles[i].id = i / 128;
+		handles[i].next = list_head;
+		list_head = &handles[i];
+	}
+}
+
+static struct handle *list_get(lookup_kind_t kind, uint8_t type, uint8_t id)
+{
+	for (struct handle *h = list_head; h != NULL; h = h->next)
+		if (h->kind == kind && h->type == type && h->id == id)
+			return h;
+	return NULL;
+}
+
+static void test_resolve(int count)
+{
+	make_handles(count);
+	LookupReset();
+	for (int i = 0; i < count; i++)
+		CHECK(LookupAdd(handles[i].kind, handles[i].type,
+				handles[i].id, &handles[i]) == 0);
+
+	for (int i = 0; i < count; i++) {
+		CHECK(LookupGet(handles[i].kind, handles[i].type,
+				handles[i].id) == &handles[i]);
+		/* Same type and id registered under no other kind */
+		CHECK(LookupGet(handles[i].kind, handles[i].type,
+				handles[i].id + 100) == NULL);
+	}
+	CHECK(!LookupOverflowed());
+	CHECK(LookupMaxProbe() <= MAX_PROBE);
+}
+
+static void test_first_wins(void)
+{
+	LookupReset();
+	CHECK(LookupAdd(LOOKUP_INT, 1, 0, &handles[0]) == 0);
+	CHECK(LookupAdd(LOOKUP_INT, 1, 0xff, &handles[0]) == 0);
+	CHECK(LookupAdd(LOOKUP_INT, 1, 1, &handles[1]) == 0);
+	CHECK(LookupAdd(LOOKUP_INT, 1, 0xff, &handles[1]) == -1);
+	CHECK(LookupGet(LOOKUP_INT, 1, 0xff) == &handles[0]);
+	CHECK(LookupGet(LOOKUP_INT, 1, 1) == &handles[1]);
+	CHECK(!LookupOverflowed());
+}
+
+static void test_overflow(void)
+{
+	int added = 0;
+
+	LookupReset();
+	for (int i = 0; i < LOOKUP_TABLE_SIZE; i++)
+		if (LookupAdd(LOOKUP_POLL, i & 0xff, i >> 8, &handles[0]) == 0)
+			added++;
+	CHECK(added == LOOKUP_TABLE_SIZE - 1);
+	CHECK(LookupOverflowed());
+	/* A miss still terminates on the slot kept empty */
+	CHECK(LookupGet(LOOKUP_FEED, 0, 0) == NULL);
+}
+
+/* Average time of one lookup over all the registered handles */
+static double time_lookups(int count, int use_list)
+{
+	volatile uintptr_t sink = 0;
+	int rounds = ROUNDS / count + 1;
+	double start = now_ns();
+
+	for (int r = 0; r < rounds; r++)
+		for (int i = 0; i < count; i++) {
+			struct handle *h = &handles[(i * 7) % count];
+			if (use_list)
+				sink += (uintptr_t)list_get(h->kind, h->type, h->id);
+			else
+				sink += (uintptr_t)LookupGet(h->kind, h->type, h->id);
+		}
+	(void)sink;
+	return (now_ns() - start) / ((double)rounds * count);
+}
+
+static void test_constant_time(void)
+{
+	static const int counts[] = { 16, 64, 256, MAX_HANDLES };
+	double first = 0;
+
+	printf("%8s %10s %12s %12s\n", "handles", "max probe",
+	       "table ns", "list ns");
+	for (unsigned i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		double table_ns, list_ns;
+
+		test_resolve(counts[i]);
+		table_ns = time_lookups(counts[i], 0);
+		list_ns = time_lookups(counts[i], 1);
+		printf("%8d %10d %12.1f %12.1f\n", counts[i], LookupMaxProbe(),
+		       table_ns, list_ns);
+		if (i == 0)
+			first = table_ns;
+		else
+			CHECK(table_ns <= first * MAX_SLOWDOWN);
+	}
+}
+
+int main(void)
+{
+	if (LOOKUP_TABLE_SIZE < 2 * MAX_HANDLES) {
+		printf("build with -DLOOKUP_TABLE_SIZE=%d or more\n",
+		       2 * MAX_HANDLES);
+		return 2;
+	}
+
+	test_first_wins();
+	test_overflow();
+	test_constant_time();
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
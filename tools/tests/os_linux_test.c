@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+
+ *****************************************************************************
+ * Smoke test of the linux OS abstraction layer (bsp/src/os/linux), the one
+ * host builds of framework code run on.
+ *
+ * Checks, against the behaviour of the target OS layer:
+ * - queues: FIFO order, send to head, max_size overflow, empty and timeout
+ *   errors, and a blocked reader woken by another thread,
+ * - semaphores: count, busy when not waiting, timeout duration, and a
+ *   blocked taker woken by another thread,
+ * - timers: period of a repeating timer, one-shot timer, restart and stop,
+ *   callbacks run in the simulated interrupt context.
+ *
+ * Compile with:
+ * gcc -O2 -Wall -DCONFIG_OS_LINUX -Ibsp/include tools/tests/os_linux_test.c \
+ *	bsp/src/os/linux/os_linux.c bsp/src/util/list.c -lpthread \
+ *	-o os_linux_test
+ *
+ * Usage:
+ * os_linux_test
+ */
+
+#define _GNU_SOURCE
+/* Keep the libc POSIX timer prototypes out of the way of the OS API ones */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <stdio.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <unistd.h>
+#undef timer_create
+#undef timer_delete
+#include "os/os.h"
+#include "util/list.h"
+
+/* Slack allowed on timeouts and timer periods, in ms */
+#define SLACK_MS 15
+
+struct msg {
+	list_t link;
+	int val;
+};
+
+/* Not part of the OS API, the linux layer defines it for its mutexes */
+int8_t is_in_isr_context(void);
+
+static int failures;
+
+#define CHECK(cond, ...) \
+	do { if (!(cond)) { failures++; printf("FAIL %s:%d: ", __func__, \
+					       __LINE__); \
+			    printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+void log_printk(uint8_t level, const char *module_short_name,
+		const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	printf("[%s] ", module_short_name);
+	vprintf(format, args);
+	printf("\n");
+	va_end(args);
+}
+
+static struct msg msgs[4];
+static T_QUEUE queue;
+static T_SEMAPHORE sem;
+
+static void *delayed_send(void *arg)
+{
+	OS_ERR_TYPE err;
+
+	local_task_sleep_ms(30);
+	queue_send_message(queue, &msgs[3], &err);
+	return NULL;
+}
+
+static void *delayed_give(void *arg)
+{
+	local_task_sleep_ms(30);
+	semaphore_give(sem, NULL);
+	return NULL;
+}
+
+static void test_queue(void)
+{
+	T_QUEUE_MESSAGE m;
+	OS_ERR_TYPE err;
+	pthread_t thread;
+	uint32_t start;
+	int i;
+
+	queue = queue_create(3);
+	CHECK(queue != NULL, "queue_create");
+	for (i = 0; i < 4; i++)
+		msgs[i].val = i;
+
+	queue_send_message(queue, &msgs[1], &err);
+	CHECK(err == E_OS_OK, "send err %d", err);
+	queue_send_message(queue, &msgs[2], &err);
+	CHECK(err == E_OS_OK, "send err %d", err);
+	queue_send_message_head(queue, &msgs[0], &err);
+	CHECK(err == E_OS_OK, "send head err %d", err);
+	queue_send_message(queue, &msgs[3], &err);
+	CHECK(err == E_OS_ERR_OVERFLOW, "send to full queue err %d", err);
+
+	for (i = 0; i < 3; i++) {
+		queue_get_message(queue, &m, OS_NO_WAIT, &err);
+		CHECK(err == E_OS_OK && m == &msgs[i], "get %d: err %d msg %d",
+		      i, err, m ? ((struct msg *)m)->val : -1);
+	}
+
+	queue_get_message(queue, &m, OS_NO_WAIT, &err);
+	CHECK(err == E_OS_ERR_EMPTY && !m, "get empty: err %d", err);
+
+	start = get_time_ms();
+	queue_get_message(queue, &m, 50, &err);
+	start = get_time_ms() - start;
+	CHECK(err == E_OS_ERR_TIMEOUT && !m, "get timeout: err %d", err);
+	CHECK(start >= 50 && start <= 50 + SLACK_MS, "timeout after %u ms",
+	      start);
+
+	pthread_create(&thread, NULL, delayed_send, NULL);
+	start = get_time_ms();
+	queue_get_message(queue, &m, OS_WAIT_FOREVER, &err);
+	start = get_time_ms() - start;
+	pthread_join(thread, NULL);
+	CHECK(err == E_OS_OK && m == &msgs[3], "blocked get: err %d", err);
+	CHECK(start >= 25 && start <= 30 + SLACK_MS, "woken after %u ms",
+	      start);
+
+	queue_delete(queue);
+}
+
+static void test_semaphore(void)
+{
+	OS_ERR_TYPE err;
+	pthread_t thread;
+	uint32_t start;
+
+	sem = semaphore_create(1);
+	CHECK(sem != NULL, "semaphore_create");
+	CHECK(semaphore_get_count(sem, NULL) == 1, "count %d",
+	      (int)semaphore_get_count(sem, NULL));
+	err = semaphore_take(sem, OS_NO_WAIT);
+	CHECK(err == E_OS_OK, "take err %d", err);
+	err = semaphore_take(sem, OS_NO_WAIT);
+	CHECK(err == E_OS_ERR_BUSY, "take without waiting: err %d", err);
+
+	start = get_time_ms();
+	err = semaphore_take(sem, 40);
+	start = get_time_ms() - start;
+	CHECK(err == E_OS_ERR_TIMEOUT, "take timeout: err %d", err);
+	CHECK(start >= 40 && start <= 40 + SLACK_MS, "timeout after %u ms",
+	      start);
+
+	semaphore_give(sem, &err);
+	semaphore_give(sem, &err);
+	CHECK(semaphore_get_count(sem, NULL) == 2, "count %d",
+	      (int)semaphore_get_count(sem, NULL));
+	CHECK(semaphore_take(sem, 10) == E_OS_OK, "take given");
+	CHECK(semaphore_take(sem, 10) == E_OS_OK, "take given");
+
+	pthread_create(&thread, NULL, delayed_give, NULL);
+	start = get_time_ms();
+	err = semaphore_take(sem, 1000);
+	start = get_time_ms() - start;
+	pthread_join(thread, NULL);
+	CHECK(err == E_OS_OK, "blocked take: err %d", err);
+	CHECK(start >= 25 && start <= 30 + SLACK_MS, "woken after %u ms",
+	      start);
+
+	semaphore_delete(sem);
+}
+
+struct timer_count {
+	volatile int count;
+	volatile int not_isr;
+};
+
+static void timer_cb(void *arg)
+{
+	struct timer_count *tc = arg;
+
+	if (!is_in_isr_context())
+		tc->not_isr++;
+	tc->count++;
+}
+
+static void test_timer(void)
+{
+	struct timer_count periodic = { 0 }, oneshot = { 0 };
+	T_TIMER t1, t2;
+	OS_ERR_TYPE err;
+	int count;
+
+	t1 = timer_create(timer_cb, &periodic, 20, true, true, &err);
+	t2 = timer_create(timer_cb, &oneshot, 30, false, false, &err);
+	CHECK(t1 && t2, "timer_create");
+
+	local_task_sleep_ms(50);
+	CHECK(oneshot.count == 0, "one-shot timer not started fired");
+	timer_start(t2, 30, &err);
+	local_task_sleep_ms(155);
+	/* 205 ms of a 20 ms period */
+	CHECK(periodic.count >= 9 && periodic.count <= 10,
+	      "periodic timer fired %d times", periodic.count);
+	CHECK(oneshot.count == 1, "one-shot timer fired %d times",
+	      oneshot.count);
+
+	/* Restarting a running timer postpones it */
+	timer_start(t2, 40, &err);
+	local_task_sleep_ms(20);
+	timer_start(t2, 40, &err);
+	local_task_sleep_ms(30);
+	CHECK(oneshot.count == 1, "restarted timer fired early");
+	local_task_sleep_ms(10 + SLACK_MS);
+	CHECK(oneshot.count == 2, "restarted timer fired %d times",
+	      oneshot.count);
+
+	timer_stop(t1);
+	count = periodic.count;
+	local_task_sleep_ms(60);
+	CHECK(periodic.count == count, "stopped timer fired %d times",
+	      periodic.count - count);
+	CHECK(!periodic.not_isr && !oneshot.not_isr,
+	      "callback out of the interrupt context");
+
+	timer_delete(t1);
+	timer_delete(t2);
+}
+
+int main(void)
+{
+	os_init();
+	test_queue();
+	test_semaphore();
+	test_timer();
+	if (failures) {
+		printf("%d failures\n", failures);
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+
+ *****************************************************************************
+ * Compares the OpenCore poll loop that walked the active sensor list twice
+ * per wakeup with the poll schedule heap, for 1 to 32 polled sensors at
+ * mixed rates, on a simulated 32 kHz uptime counter.
+ *
+ * Both loops are copies of the sensor core code reduced to the scheduling:
+ * reading a sensor costs nothing and every clock read advances the counter
+ * by one tick.
+ *
+ * Compile with:
+ * gcc -O2 tools/tests/poll_sched_bench.c -o poll_sched_bench
+ *
+ * Usage:
+ * poll_sched_bench [simulated_seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#define MAX_SENSORS 32
+#define MS_TO_32K(ms)       ((uint32_t)((ms) * 32768 / 1000))
+#define TICKS_32K_TO_MS(t)  ((uint32_t)(((uint64_t)(t) * 1000) >> 15))
+#define FOREVER_VALUE       (-1)
+
+/* Sampling rates in Hz x10, as set by RefleshSensorCore() */
+static const uint16_t rates[] = { 2000, 1000, 500, 250, 125, 1000, 100, 500 };
+
+struct sensor {
+	struct sensor *next;
+	double npp_ms;
+	float pi;
+	uint32_t npp;
+	uint32_t pi_32k;
+};
+
+struct run_stats {
+	unsigned long wakeups;
+	unsigned long passes;
+	unsigned long polls;
+	double jitter_sum;
+	double jitter_max;
+	double cpu_ns;
+};
+
+static struct sensor sensors[MAX_SENSORS];
+static struct sensor *list_head;
+static int sensor_count;
+static uint32_t sim_now;
+static struct run_stats *stats;
+
+static uint32_t get_uptime_32k(void)
+{
+	return sim_now++;
+}
+
+/* Records how far from its due point, in ms, a sensor was read */
+static void account_poll(double offset_ms)
+{
+	if (offset_ms < 0)
+		offset_ms = -offset_ms;
+	stats->polls++;
+	stats->jitter_sum += offset_ms;
+	if (offset_ms > stats->jitter_max)
+		stats->jitter_max = offset_ms;
+}
+
+static void setup(int count, uint32_t start)
+{
+	list_head = NULL;
+	for (int i = count - 1; i >= 0; i--) {
+		sensors[i].pi = (float)1000 * 10 / rates[i % (sizeof(rates) /
+							  sizeof(rates[0]))];
+		sensors[i].npp_ms = start * (double)1000 / 32768;
+		sensors[i].npp = 0;
+		sensors[i].next = list_head;
+		list_head = &sensors[i];
+	}
+	sensor_count = count;
+	sim_now = start;
+}
+
+/* The former SensorCoreProcess() */
+static int list_process(int *poll_timeout)
+{
+	while (1) {
+		double min_npp = 0;
+		double ct = get_uptime_32k() * (double)1000 / 32768;
+		int act_npp = 0;
+
+		for (struct sensor *s = list_head; s != NULL; s = s->next) {
+			if (min_npp == 0 || min_npp > s->npp_ms)
+				min_npp = s->npp_ms;
+			act_npp++;
+		}
+		if (act_npp == 0) {
+			*poll_timeout = FOREVER_VALUE;
+			return 0;
+		}
+		if (ct < min_npp && min_npp - ct > 1) {
+			*poll_timeout = min_npp - ct;
+			return 0;
+		}
+
+		stats->passes++;
+		for (struct sensor *s = list_head; s != NULL; s = s->next) {
+			if (ct >= s->npp_ms) {
+				account_poll(sim_now * (double)1000 / 32768 -
+					     s->npp_ms);
+				s->npp_ms = ct + s->pi;
+			}
+		}
+	}
+}
+
+/* The poll schedule of opencore_sched.c */
+static struct sensor *heap[MAX_SENSORS];
+static int heap_count;
+
+static inline int npp_before(struct sensor *a, struct sensor *b)
+{
+	return (int32_t)(a->npp - b->npp) < 0;
+}
+
+static void sift_down(int i)
+{
+	struct sensor *s = heap[i];
+
+	while (1) {
+		int child = 2 * i + 1;
+		if (child >= heap_count)
+			break;
+		if (child + 1 < heap_count &&
+		    npp_before(heap[child + 1], heap[child]))
+			child++;
+		if (!npp_before(heap[child], s))
+			break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = s;
+}
+
+static void sift_up(int i)
+{
+	struct sensor *s = heap[i];
+
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+		if (!npp_before(s, heap[parent]))
+			break;
+		heap[i] = heap[parent];
+		i = parent;
+	}
+	heap[i] = s;
+}
+
+static void heap_rebuild(uint32_t now)
+{
+	heap_count = 0;
+	for (struct sensor *s = list_head; s != NULL; s = s->next) {
+		s->pi_32k = MS_TO_32K(s->pi);
+		if (s->npp == 0 || (int32_t)(s->npp - now) > (int32_t)s->pi_32k)
+			s->npp = now;
+		heap[heap_count++] = s;
+	}
+	for (int i = heap_count / 2 - 1; i >= 0; i--)
+		sift_down(i);
+}
+
+static struct sensor *heap_pop(uint32_t now)
+{
+	struct sensor *s;
+
+	if (heap_count == 0)
+		return NULL;
+	s = heap[0];
+	if ((int32_t)(s->npp - now) > 0)
+		return NULL;
+	heap[0] = heap[--heap_count];
+	if (heap_count > 0)
+		sift_down(0);
+	return s;
+}
+
+static void heap_reschedule(struct sensor *s, uint32_t now)
+{
+	s->npp += s->pi_32k;
+	if ((int32_t)(s->npp - now) <= 0)
+		s->npp = now + s->pi_32k;
+	heap[heap_count] = s;
+	sift_up(heap_count++);
+}
+
+static int heap_process(int *poll_timeout)
+{
+	while (1) {
+		struct sensor *due[MAX_SENSORS];
+		int due_count = 0;
+		uint32_t ct = get_uptime_32k();
+		struct sensor *s = heap_count > 0 ? heap[0] : NULL;
+
+		if (s == NULL) {
+			*poll_timeout = FOREVER_VALUE;
+			return 0;
+		}
+		if ((int32_t)(s->npp - ct) > 0) {
+			if (TICKS_32K_TO_MS(s->npp - ct) > 0) {
+				*poll_timeout = TICKS_32K_TO_MS(s->npp - ct);
+				return 0;
+			}
+			while ((int32_t)(s->npp - (ct = get_uptime_32k())) > 0)
+				;
+		}
+
+		stats->passes++;
+		while ((s = heap_pop(ct)) != NULL)
+			due[due_count++] = s;
+		for (int i = 0; i < due_count; i++) {
+			s = due[i];
+			account_poll((int32_t)(sim_now - s->npp) * 1000.0 / 32768);
+			heap_reschedule(s, ct);
+		}
+	}
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void run(int (*process)(int *), uint32_t duration)
+{
+	uint32_t start = sim_now;
+	int poll_timeout;
+
+	while (sim_now - start < duration) {
+		double t0 = now_ns();
+		process(&poll_timeout);
+		stats->cpu_ns += now_ns() - t0;
+		stats->wakeups++;
+		if (poll_timeout == FOREVER_VALUE)
+			break;
+		sim_now += MS_TO_32K(poll_timeout);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int seconds = argc > 1 ? atoi(argv[1]) : 60;
+	uint32_t duration = seconds * 32768;
+
+	if (seconds <= 0) {
+		fprintf(stderr, "usage: %s [simulated_seconds]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%2s | %-35s | %-35s\n", "N",
+	       "list walk: ns/wakeup passes jitter", "heap: ns/wakeup passes jitter");
+	printf("%2s | %-35s | %-35s\n", "", "                      (avg/max ms)",
+	       "                 (avg/max ms)");
+	for (int n = 1; n <= MAX_SENSORS; n++) {
+		struct run_stats list_stats = { 0 }, heap_stats = { 0 };
+
+		stats = &list_stats;
+		setup(n, 1000);
+		run(list_process, duration);
+
+		/* Run across the counter wrap, that the list walk could not */
+		stats = &heap_stats;
+		setup(n, -(duration / 2));
+		heap_rebuild(sim_now);
+		run(heap_process, duration);
+
+		printf("%2d | %9.0f %9lu %6.3f/%6.3f | %9.0f %9lu %6.3f/%6.3f\n", n,
+		       list_stats.cpu_ns / list_stats.wakeups, list_stats.passes,
+		       list_stats.jitter_sum / list_stats.polls,
+		       list_stats.jitter_max,
+		       heap_stats.cpu_ns / heap_stats.wakeups, heap_stats.passes,
+		       heap_stats.jitter_sum / heap_stats.polls,
+		       heap_stats.jitter_max);
+	}
+	return 0;
+}
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+
+ *****************************************************************************
+ * Proposes a memory_pool_list.def layout from the balloc histogram printed by
+ * the "dbg pool" test command (CONFIG_MEMORY_POOLS_BALLOC_HISTOGRAM).
+ *
+ * Compile with:
+ * gcc -O2 -Wall tools/tests/pool_advisor.c -o pool_advisor
+ *
+ * Usage:
+ * pool_advisor <dbg_pool_output> [headroom_percent] [max_pools]
+ *
+ * The input lines of interest are:
+ *   class <size> bytes count:<n> max:<n> fallback:<n> fail:<n>
+ *   hist <bound>:<allocations>/<peak> ...
+ * anything else (log prefixes, owner lists) is ignored.
+ *
+ * Each pool of the proposal groups consecutive histogram buckets; its block
+ * size is the bound of its largest bucket and its block count is the sum of
+ * the bucket peaks plus the headroom. Summing the peaks assumes they were
+ * reached at the same time, so the proposal errs on the safe side. The pool
+ * grouping minimizing RAM (blocks plus tracking words and descriptor) is
+ * found by dynamic programming over the buckets. The largest current class is
+ * always kept, as an extra pool of one block or, with max_pools at 1, as the
+ * block size of the single pool.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE 1024
+#define MAX_CLASSES 32
+#define MAX_BUCKETS 64
+#define BITS_PER_U32 32
+#define MIN_POOL_BYTES 64
+/* Size of a T_POOL_DESC with statistics disabled */
+#define DESC_SIZE 16
+
+struct pool_class {
+	unsigned int size;
+	unsigned int count;
+	unsigned int max;
+	unsigned int fallback;
+	unsigned int fail;
+};
+
+struct bucket {
+	unsigned int bound;
+	unsigned int count;
+	unsigned int peak;
+};
+
+static struct pool_class classes[MAX_CLASSES];
+static int nb_classes;
+static struct bucket buckets[MAX_BUCKETS];
+static int nb_buckets;
+
+static int parse(const char *file)
+{
+	char line[MAX_LINE];
+	FILE *f = fopen(file, "r");
+
+	if (!f) {
+		perror(file);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		struct pool_class *c = &classes[nb_classes];
+		char *p;
+		int len;
+
+		if ((p = strstr(line, "class ")) && nb_classes < MAX_CLASSES &&
+		    sscanf(p, "class %u bytes count:%u max:%u fallback:%u fail:%u",
+			   &c->size, &c->count, &c->max, &c->fallback,
+			   &c->fail) == 5) {
+			nb_classes++;
+			continue;
+		}
+		if (!(p = strstr(line, "hist ")))
+			continue;
+		p += 4;
+		while (nb_buckets < MAX_BUCKETS) {
+			struct bucket *b = &buckets[nb_buckets];
+
+			if (sscanf(p, " %u:%u/%u%n", &b->bound, &b->count,
+				   &b->peak, &len) != 3)
+				break;
+			if (b->peak == 0)
+				b->peak = 1;
+			nb_buckets++;
+			p += len;
+		}
+	}
+	fclose(f);
+	return 0;
+}
+
+static unsigned long pool_ram(unsigned int size, unsigned int count)
+{
+	return (unsigned long)size * count +
+	       (count / BITS_PER_U32 + 1) * 4 + DESC_SIZE;
+}
+
+/* balloc requires each pool to span at least MIN_POOL_BYTES */
+static unsigned int min_count(unsigned int size, unsigned int count)
+{
+	unsigned int min = (MIN_POOL_BYTES + size - 1) / size;
+
+	return count < min ? min : count;
+}
+
+static unsigned int group_count(int first, int last, unsigned int headroom)
+{
+	unsigned int peak = 0;
+	int i;
+
+	for (i = first; i <= last; i++)
+		peak += buckets[i].peak;
+	peak = (peak * (100 + headroom) + 99) / 100;
+	return min_count(buckets[last].bound, peak);
+}
+
+static int cmp_bucket(const void *a, const void *b)
+{
+	const struct bucket *ba = a, *bb = b;
+
+	return (ba->bound > bb->bound) - (ba->bound < bb->bound);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int headroom = argc > 2 ? atoi(argv[2]) : 25;
+	int max_pools = argc > 3 ? atoi(argv[3]) : 8;
+	/* best[k][j]: minimal RAM to cover buckets 0..j with k + 1 pools */
+	static unsigned long best[MAX_BUCKETS][MAX_BUCKETS];
+	static int split[MAX_BUCKETS][MAX_BUCKETS];
+	unsigned long cur_ram = 0, new_ram;
+	unsigned int largest = 0;
+	int bounds[MAX_BUCKETS];
+	int i, j, k, kbest, n, idx;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <dbg_pool_output> [headroom_percent] [max_pools]\n",
+			argv[0]);
+		return 1;
+	}
+	if (parse(argv[1]))
+		return 1;
+	if (!nb_buckets) {
+		fprintf(stderr, "No histogram found in %s\n", argv[1]);
+		return 1;
+	}
+	qsort(buckets, nb_buckets, sizeof(buckets[0]), cmp_bucket);
+
+	for (i = 0; i < nb_classes; i++) {
+		struct pool_class *c = &classes[i];
+
+		cur_ram += pool_ram(c->size, c->count);
+		if (c->size > largest)
+			largest = c->size;
+		printf("/* current %4u bytes x %-3u max:%-3u%s", c->size,
+		       c->count, c->max, c->max * 100 >
+		       c->count * (100 - headroom) ? " (tight)" : "");
+		if (c->fallback || c->fail)
+			printf(" fallback:%u fail:%u", c->fallback, c->fail);
+		printf(" */\n");
+	}
+
+	/* Keep the largest current class so that request sizes that did not
+	 * occur during the capture still fit: in a pool of its own, or as the
+	 * block size of the last pool when no other pool is left */
+	n = nb_buckets;
+	if (max_pools < 1)
+		max_pools = 1;
+	if (largest <= buckets[n - 1].bound) {
+		largest = 0;
+	} else if (max_pools > 1) {
+		max_pools--;
+	} else {
+		buckets[n - 1].bound = largest;
+		largest = 0;
+	}
+	if (max_pools > n)
+		max_pools = n;
+
+	for (j = 0; j < n; j++)
+		best[0][j] = pool_ram(buckets[j].bound,
+				      group_count(0, j, headroom));
+	for (k = 1; k < max_pools; k++) {
+		for (j = 0; j < n; j++) {
+			best[k][j] = best[k - 1][j];
+			split[k][j] = -1;
+			for (i = 1; i <= j; i++) {
+				unsigned long ram = best[k - 1][i - 1] +
+						    pool_ram(buckets[j].bound,
+							     group_count(i, j,
+									 headroom));
+				if (ram < best[k][j]) {
+					best[k][j] = ram;
+					split[k][j] = i;
+				}
+			}
+		}
+	}
+
+	/* Walk back the splits, the pools are found from the largest one */
+	kbest = max_pools - 1;
+	idx = 0;
+	j = n - 1;
+	for (k = kbest; j >= 0; k--) {
+		i = k > 0 ? split[k][j] : 0;
+		if (i < 0)
+			continue;
+		bounds[idx++] = j;
+		bounds[idx++] = i;
+		j = i - 1;
+	}
+
+	new_ram = 0;
+	printf("/* proposal with %u%% headroom */\n", headroom);
+	for (k = idx - 2, i = 0; k >= 0; k -= 2, i++) {
+		unsigned int size = buckets[bounds[k]].bound;
+		unsigned int count = group_count(bounds[k + 1], bounds[k],
+						 headroom);
+
+		new_ram += pool_ram(size, count);
+		printf("DECLARE_MEMORY_POOL(%d,%u,%u)\n", i, size, count);
+	}
+	if (largest) {
+		unsigned int count = min_count(largest, 1);
+
+		new_ram += pool_ram(largest, count);
+		printf("DECLARE_MEMORY_POOL(%d,%u,%u)\n", i, largest, count);
+	}
+	printf("#undef DECLARE_MEMORY_POOL\n");
+	if (cur_ram)
+		printf("/* RAM: %lu bytes, was %lu bytes */\n", new_ram,
+		       cur_ram);
+	else
+		printf("/* RAM: %lu bytes */\n", new_ram);
+	return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+
+ *****************************************************************************
+ * Replays a recorded test command script against the test command lookup and
+ * compares it with the former linear section walk.
+ *
+ * Compile with:
+ * gcc -Wall -Wextra -O2 -I bsp/include -I bsp/src/infra/tcmd \
+ *     tools/tests/tcmd_lookup_bench.c \
+ *     bsp/src/infra/tcmd/lookup.c -o tcmd_lookup_bench
+ *
+ * Usage:
+ * tcmd_lookup_bench <help_output> <script> [iterations]
+ *
+ * <help_output> is the output of the "help" test command captured on the
+ * target, ie one "<group>: <name> <name> ..." line per group.
+ * <script> contains one test command per line ("<group> <name> [args]"),
+ * empty lines and lines starting with '#' are ignored.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lookup.h"
+
+#define MAX_LINE 1024
+
+static struct tcmd_handler *table;
+static int table_len;
+
+struct script_cmd {
+	char *group;
+	char *name;
+};
+
+static struct script_cmd *script;
+static int script_len;
+
+/* The lookup the engine used before the table was sorted */
+static const struct tcmd_handler *linear_lookup(const char *group,
+						const char *name)
+{
+	const struct tcmd_handler *cmd = table;
+	const struct tcmd_handler *result = NULL;
+	size_t grp_len = strlen(group);
+	size_t name_len = strlen(name);
+
+	for (; cmd < table + table_len; cmd++) {
+		if ((strncmp(group, cmd->group, grp_len) == 0)
+		    && (strncmp(name, cmd->name, name_len) == 0)) {
+			if ((grp_len == strlen(cmd->group))
+			    && (name_len == strlen(cmd->name)))
+				return cmd;
+			if (!result)
+				result = cmd;
+		}
+	}
+	return result;
+}
+
+static int compare_handlers(const void *a, const void *b)
+{
+	const struct tcmd_handler *ha = a;
+	const struct tcmd_handler *hb = b;
+	int ret = strcmp(ha->group, hb->group);
+
+	return ret ? ret : strcmp(ha->name, hb->name);
+}
+
+static void add_handler(const char *group, const char *name)
+{
+	table = realloc(table, (table_len + 1) * sizeof(*table));
+	table[table_len].group = strdup(group);
+	table[table_len].name = strdup(name);
+	table[table_len].run = NULL;
+	table_len++;
+}
+
+static int load_table(const char *path)
+{
+	char line[MAX_LINE];
+	FILE *f = fopen(path, "r");
+
+	if (!f)
+		return -1;
+	while (fgets(line, sizeof(line), f)) {
+		char *colon = strchr(line, ':');
+		char *tok;
+		if (!colon)
+			continue;
+		*colon = '\0';
+		for (tok = strtok(colon + 1, " \r\n"); tok;
+		     tok = strtok(NULL, " \r\n"))
+			add_handler(line, tok);
+	}
+	fclose(f);
+	/* Same ordering as the linker SORT on .test_cmds.<group>.<name> */
+	qsort(table, table_len, sizeof(*table), compare_handlers);
+	return 0;
+}
+
+static int load_script(const char *path)
+{
+	char line[MAX_LINE];
+	FILE *f = fopen(path, "r");
+
+	if (!f)
+		return -1;
+	while (fgets(line, sizeof(line), f)) {
+		char *group = strtok(line, " \r\n");
+		char *name = strtok(NULL, " \r\n");
+		if (!group || group[0] == '#' || !name)
+			continue;
+		script = realloc(script, (script_len + 1) * sizeof(*script));
+		script[script_len].group = strdup(group);
+		script[script_len].name = strdup(name);
+		script_len++;
+	}
+	fclose(f);
+	return 0;
+}
+
+static double now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = argc > 3 ? atoi(argv[3]) : 1000;
+	/* Called through pointers so that lookups are not hoisted */
+	const struct tcmd_handler *(*volatile linear)(const char *,
+						      const char *) =
+		linear_lookup;
+	const struct tcmd_handler *(*volatile sorted)(
+		const struct tcmd_handler *, const struct tcmd_handler *,
+		const char *, const char *) = tcmd_lookup;
+	double start, linear_us, sorted_us;
+	int i, j, errors = 0;
+
+	if (argc < 3) {
+		fprintf(stderr, "usage: %s <help_output> <script> [iterations]\n",
+			argv[0]);
+		return 1;
+	}
+	if (load_table(argv[1]) || load_script(argv[2])) {
+		perror("load");
+		return 1;
+	}
+
+	for (i = 0; i < script_len; i++) {
+		const struct tcmd_handler *ref =
+			linear_lookup(script[i].group, script[i].name);
+		const struct tcmd_handler *res =
+			tcmd_lookup(table, table + table_len, script[i].group,
+				    script[i].name);
+		if (ref != res) {
+			fprintf(stderr, "mismatch for '%s %s': %s %s vs %s %s\n",
+				script[i].group, script[i].name,
+				ref ? ref->group : "-", ref ? ref->name : "-",
+				res ? res->group : "-", res ? res->name : "-");
+			errors++;
+		}
+	}
+
+	start = now_us();
+	for (j = 0; j < iterations; j++)
+		for (i = 0; i < script_len; i++)
+			linear(script[i].group, script[i].name);
+	linear_us = now_us() - start;
+
+	start = now_us();
+	for (j = 0; j < iterations; j++)
+		for (i = 0; i < script_len; i++)
+			sorted(table, table + table_len, script[i].group,
+			       script[i].name);
+	sorted_us = now_us() - start;
+
+	printf("%d handlers, %d commands x %d iterations\n", table_len,
+	       script_len, iterations);
+	printf("linear: %.1f ns/lookup\n",
+	       linear_us * 1e3 / ((double)script_len * iterations));
+	printf("sorted: %.1f ns/lookup\n",
+	       sorted_us * 1e3 / ((double)script_len * iterations));
+	printf("%d mismatches\n", errors);
+
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2016, Intel Corporation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+
+ *****************************************************************************
+ * Converts a recorded accel/gyro/mag trace into a C file defining the frame
+ * arrays expected by sensor_replay_load() (CONFIG_SENSOR_REPLAY).
+ *
+ * Compile with:
+ * gcc -O2 -Wall tools/tests/trace2replay.c -o trace2replay -lm
+ *
+ * Usage:
+ * trace2replay [-a scale] [-g scale] [-m scale] <trace> > replay_trace.c
+ *
+ * Each input line holds an optional timestamp, a sensor name and three
+ * values:
+ *   [timestamp] accel|gyro|mag x y z
+ * Sensor names may be abbreviated to their first letter; empty lines and
+ * lines starting with '#' are skipped. Values are multiplied by the scale of
+ * their sensor (1.0 by default) and rounded to the raw physical sensor unit:
+ * mg for accel, millidegree/s for gyro and 16LSB/uT for mag. Emulator traces
+ * recorded in SI units only need the matching scales (e.g. -a 101.97 for
+ * m/s^2 to mg).
+ *
+ * The output defines replay_accel, replay_gyro and replay_mag with their
+ * replay_*_count, plus replay_trace_load() attaching all non-empty arrays.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define MAX_LINE 256
+#define MAX_FRAMES 65535
+
+enum { ACCEL, GYRO, MAG, SENSORS };
+
+static const char *const names[SENSORS] = { "accel", "gyro", "mag" };
+static const char *const types[SENSORS] = {
+	"phy_accel_data_t", "phy_gyro_data_t", "phy_mag_data_t"
+};
+static const char *const ids[SENSORS] = {
+	"SENSOR_REPLAY_ACCEL", "SENSOR_REPLAY_GYRO", "SENSOR_REPLAY_MAG"
+};
+/* accel frames are 16 bits, gyro and mag frames 32 bits */
+static const double limits[SENSORS] = { 32767.0, 2147483647.0, 2147483647.0 };
+
+struct frames {
+	long (*xyz)[3];
+	unsigned int count;
+	unsigned int size;
+};
+
+static struct frames frames[SENSORS];
+static double scales[SENSORS] = { 1.0, 1.0, 1.0 };
+
+static int sensor_index(const char *name)
+{
+	int i;
+
+	for (i = 0; i < SENSORS; i++)
+		if (!strcmp(name, names[i]) ||
+		    (name[0] == names[i][0] && name[1] == '\0'))
+			return i;
+	return -1;
+}
+
+static long to_raw(int sensor, double value, unsigned int line)
+{
+	double raw = value * scales[sensor];
+
+	if (raw > limits[sensor] || raw < -limits[sensor] - 1) {
+		fprintf(stderr, "line %u: %s value %g out of range, clamped\n",
+			line, names[sensor], raw);
+		raw = raw > 0 ? limits[sensor] : -limits[sensor] - 1;
+	}
+	return lround(raw);
+}
+
+static int add_frame(int sensor, const double v[3], unsigned int line)
+{
+	struct frames *f = &frames[sensor];
+	int i;
+
+	if (f->count == MAX_FRAMES) {
+		fprintf(stderr, "line %u: too many %s frames\n", line,
+			names[sensor]);
+		return -1;
+	}
+	if (f->count == f->size) {
+		f->size = f->size ? f->size * 2 : 1024;
+		f->xyz = realloc(f->xyz, f->size * sizeof(*f->xyz));
+		if (!f->xyz) {
+			perror("realloc");
+			return -1;
+		}
+	}
+	for (i = 0; i < 3; i++)
+		f->xyz[f->count][i] = to_raw(sensor, v[i], line);
+	f->count++;
+	return 0;
+}
+
+static int parse(FILE *in)
+{
+	char buf[MAX_LINE];
+	unsigned int line = 0;
+
+	while (fgets(buf, sizeof(buf), in)) {
+		char name[16];
+		double v[3];
+		int sensor;
+
+		line++;
+		if (buf[strspn(buf, " \t\r\n")] == '\0' || buf[0] == '#')
+			continue;
+		/* Try without then with a leading timestamp */
+		if (sscanf(buf, "%15s %lf %lf %lf", name, &v[0], &v[1],
+			   &v[2]) != 4 &&
+		    sscanf(buf, "%*s %15s %lf %lf %lf", name, &v[0], &v[1],
+			   &v[2]) != 4) {
+			fprintf(stderr, "line %u: cannot parse\n", line);
+			return -1;
+		}
+		sensor = sensor_index(name);
+		if (sensor < 0) {
+			fprintf(stderr, "line %u: unknown sensor %s\n", line,
+				name);
+			return -1;
+		}
+		if (add_frame(sensor, v, line))
+			return -1;
+	}
+	return 0;
+}
+
+static void output(void)
+{
+	unsigned int i, j;
+	int s;
+
+	printf("/* Generated by trace2replay, do not edit */\n\n");
+	printf("#include \"sensors/phy_sensor_api/phy_sensor_common.h\"\n");
+	printf("#include \"drivers/sensor/sensor_replay.h\"\n");
+
+	for (s = 0; s < SENSORS; s++) {
+		struct frames *f = &frames[s];
+
+		printf("\nconst unsigned int replay_%s_count = %u;\n",
+		       names[s], f->count);
+		if (!f->count) {
+			printf("const %s *const replay_%s = NULL;\n", types[s],
+			       names[s]);
+			continue;
+		}
+		printf("const %s replay_%s[%u] = {\n", types[s], names[s],
+		       f->count);
+		for (i = 0; i < f->count; i++) {
+			printf("\t{");
+			for (j = 0; j < 3; j++)
+				printf(" %ld%s", f->xyz[i][j], j < 2 ? "," : "");
+			printf(" },\n");
+		}
+		printf("};\n");
+	}
+
+	printf("\nvoid replay_trace_load(bool loop)\n{\n");
+	for (s = 0; s < SENSORS; s++)
+		if (frames[s].count)
+			printf("\tsensor_replay_load(%s, replay_%s, %u, loop);\n",
+			       ids[s], names[s], frames[s].count);
+	printf("}\n");
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-a scale] [-g scale] [-m scale] <trace>\n", prog);
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *path = NULL;
+	FILE *in;
+	int i, ret;
+
+	for (i = 1; i < argc; i++) {
+		int s = -1;
+
+		if (!strcmp(argv[i], "-a"))
+			s = ACCEL;
+		else if (!strcmp(argv[i], "-g"))
+			s = GYRO;
+		else if (!strcmp(argv[i], "-m"))
+			s = MAG;
+		else if (!path)
+			path = argv[i];
+		else
+			usage(argv[0]);
+
+		if (s >= 0) {
+			if (++i == argc)
+				usage(argv[0]);
+			scales[s] = strtod(argv[i], NULL);
+		}
+	}
+	if (!path)
+		usage(argv[0]);
+
+	in = fopen(path, "r");
+	if (!in) {
+		perror(path);
+		return 1;
+	}
+	ret = parse(in);
+	fclose(in);
+	if (ret)
+		return 1;
+
+	output();
+	for (i = 0; i < SENSORS; i++)
+		fprintf(stderr, "%s: %u frames\n", names[i], frames[i].count);
+	return 0;
+}